@@ -0,0 +1,73 @@
+/* @brief: Benchmark the itinerary search, with random origin/destination
+ *         pairs, and the all-pairs travel time precomputation on the network
+ *         layout used by the tests
+ */
+
+#include "TransportNetwork.h"
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <random>
+#include <utility>
+#include <vector>
+
+using NetworkMonitor::Itinerary;
+using NetworkMonitor::ItineraryOptions;
+using NetworkMonitor::StationHandle;
+using NetworkMonitor::TransportNetwork;
+
+/* Build the network from the JSON layout */
+static TransportNetwork LoadNetworkLayout (
+    const std::filesystem::path& src
+)
+{
+    TransportNetwork nw {};
+    nw.FromJson(src);
+
+    return nw;
+}
+
+static void BM_GetFastestItinerary (
+    benchmark::State& state
+)
+{
+    const auto nw {LoadNetworkLayout(TESTS_NETWORK_LAYOUT_JSON)};
+
+    /* Pre-draw the random pairs, so that the timed loop only runs the search.
+       Station handles are dense, so we can draw them directly */
+    std::mt19937 generator {42};
+    std::uniform_int_distribution<StationHandle> distribution(
+        0, static_cast<StationHandle>(nw.GetStationCount() - 1)
+    );
+    std::vector<std::pair<StationHandle, StationHandle>> pairs(1024);
+    for (auto& pair: pairs)
+    {
+        pair = {distribution(generator), distribution(generator)};
+    }
+
+    ItineraryOptions options {};
+    options.lineChangePenalty = static_cast<unsigned int>(state.range(0));
+    Itinerary itinerary {};
+    size_t idx {0};
+    for (auto _: state)
+    {
+        const auto& [from, to] {pairs[idx++ % pairs.size()]};
+        benchmark::DoNotOptimize(nw.GetFastestItinerary(from, to, itinerary, options));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetFastestItinerary)->Arg(0)->Arg(5);
+
+static void BM_PrecomputeTravelTimes (
+    benchmark::State& state
+)
+{
+    auto nw {LoadNetworkLayout(TESTS_NETWORK_LAYOUT_JSON)};
+    for (auto _: state)
+    {
+        nw.PrecomputeTravelTimes(static_cast<unsigned int>(state.range(0)));
+    }
+    state.SetItemsProcessed(state.iterations() * nw.GetStationCount());
+}
+BENCHMARK(BM_PrecomputeTravelTimes)->Arg(1)->Arg(4)->UseRealTime();
@@ -0,0 +1,171 @@
+/* @brief: Benchmark the ways to parse a JSON file: reading it through an
+ *         iostream into a document, parsing the mapped file as one buffer
+ *         into a document, and only validating the mapped buffer without
+ *         building a document, which is the lower bound of any parser built
+ *         on nlohmann::json.
+ *         Each runs on the network layout used by the tests and on a copy
+ *         of it scaled 100 times
+ */
+
+#include "FileDownloader.h"
+#include "MappedFile.h"
+
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+
+using NetworkMonitor::LoadJsonFile;
+using NetworkMonitor::MappedFile;
+using NetworkMonitor::ParseJsonFile;
+
+/* Write `scale` copies of the network layout side by side, with the IDs of
+   each copy suffixed by its number */
+static bool WriteScaledLayout (
+    const std::filesystem::path& src,
+    const std::filesystem::path& dst,
+    int64_t scale
+)
+{
+    const auto layout = ParseJsonFile(src);
+    if (layout.is_null())
+        return false;
+
+    nlohmann::json scaled {
+        {"stations", nlohmann::json::array()},
+        {"lines", nlohmann::json::array()},
+        {"travel_times", nlohmann::json::array()}
+    };
+    for (int64_t copy {0}; copy < scale; ++copy)
+    {
+        const auto suffix {"_" + std::to_string(copy)};
+        auto rename {[&suffix](nlohmann::json& value) {
+            value = value.get<std::string>() + suffix;
+        }};
+        for (auto station: layout.at("stations"))
+        {
+            rename(station.at("station_id"));
+            scaled["stations"].push_back(std::move(station));
+        }
+        for (auto line: layout.at("lines"))
+        {
+            rename(line.at("line_id"));
+            for (auto& route: line.at("routes"))
+            {
+                for (const auto key: {"route_id", "line_id", "start_station_id", "end_station_id"})
+                {
+                    rename(route.at(key));
+                }
+                for (auto& stop: route.at("route_stops"))
+                {
+                    rename(stop);
+                }
+            }
+            scaled["lines"].push_back(std::move(line));
+        }
+        for (auto travelTime: layout.at("travel_times"))
+        {
+            for (const auto key: {"start_station_id", "end_station_id", "line_id", "route_id"})
+            {
+                rename(travelTime.at(key));
+            }
+            scaled["travel_times"].push_back(std::move(travelTime));
+        }
+    }
+
+    std::ofstream file {dst, std::ios::binary | std::ios::trunc};
+    file << scaled.dump(4);
+    return static_cast<bool>(file);
+}
+
+/* The layout scaled `scale` times, written once per run
+   Return an empty path if it could not be written */
+static std::filesystem::path GetLayout (
+    int64_t scale
+)
+{
+    if (scale == 1)
+        return TESTS_NETWORK_LAYOUT_JSON;
+
+    static std::map<int64_t, std::filesystem::path> layouts {};
+    auto it {layouts.find(scale)};
+    if (it == layouts.end())
+    {
+        auto dst {
+            std::filesystem::temp_directory_path()
+            / ("network-layout-x" + std::to_string(scale) + ".json")
+        };
+        if (!WriteScaledLayout(TESTS_NETWORK_LAYOUT_JSON, dst, scale))
+        {
+            dst.clear();
+        }
+        it = layouts.emplace(scale, std::move(dst)).first;
+    }
+    return it->second;
+}
+
+static void BM_ParseJsonIostream (
+    benchmark::State& state
+)
+{
+    const auto src {GetLayout(state.range(0))};
+    if (src.empty())
+    {
+        state.SkipWithError("Could not write the scaled layout");
+        return;
+    }
+    for (auto _: state)
+    {
+        nlohmann::json parsed {};
+        std::ifstream file {src};
+        file >> parsed;
+        benchmark::DoNotOptimize(parsed);
+    }
+    state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(src));
+}
+BENCHMARK(BM_ParseJsonIostream)->Arg(1)->Arg(100)->Unit(benchmark::kMillisecond);
+
+static void BM_ParseJsonMapped (
+    benchmark::State& state
+)
+{
+    const auto src {GetLayout(state.range(0))};
+    if (src.empty())
+    {
+        state.SkipWithError("Could not write the scaled layout");
+        return;
+    }
+    for (auto _: state)
+    {
+        auto parsed {LoadJsonFile(src)};
+        benchmark::DoNotOptimize(parsed);
+    }
+    state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(src));
+}
+BENCHMARK(BM_ParseJsonMapped)->Arg(1)->Arg(100)->Unit(benchmark::kMillisecond);
+
+static void BM_AcceptJsonMapped (
+    benchmark::State& state
+)
+{
+    const auto src {GetLayout(state.range(0))};
+    if (src.empty())
+    {
+        state.SkipWithError("Could not write the scaled layout");
+        return;
+    }
+    for (auto _: state)
+    {
+        MappedFile file {};
+        file.Open(src);
+        const auto buffer {file.GetView()};
+        benchmark::DoNotOptimize(nlohmann::json::accept(buffer.begin(), buffer.end()));
+    }
+    state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(src));
+}
+BENCHMARK(BM_AcceptJsonMapped)->Arg(1)->Arg(100)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,115 @@
+/* @brief: Benchmark loading the network layout used by the tests: building
+ *         a JSON document first and copying it into the network, against the
+ *         one-pass SAX loader and against mapping a binary snapshot
+ */
+
+#include "FileDownloader.h"
+#include "NetworkSnapshot.h"
+#include "TransportNetwork.h"
+
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using NetworkMonitor::Line;
+using NetworkMonitor::NetworkSnapshot;
+using NetworkMonitor::ParseJsonFile;
+using NetworkMonitor::Route;
+using NetworkMonitor::Station;
+using NetworkMonitor::TransportNetwork;
+
+/* Build the network from a full JSON document of the layout */
+static TransportNetwork LoadNetworkLayoutDom (
+    const std::filesystem::path& src
+)
+{
+    TransportNetwork nw {};
+    const auto layout = ParseJsonFile(src);
+    for (const auto& station: layout.at("stations"))
+    {
+        nw.AddStation(Station {
+            station.at("station_id").get<std::string>(),
+            station.at("name").get<std::string>()
+        });
+    }
+    for (const auto& line: layout.at("lines"))
+    {
+        Line lineData {
+            line.at("line_id").get<std::string>(),
+            line.at("name").get<std::string>(),
+            {}
+        };
+        for (const auto& route: line.at("routes"))
+        {
+            lineData.routes.push_back(Route {
+                route.at("route_id").get<std::string>(),
+                route.at("direction").get<std::string>(),
+                route.at("line_id").get<std::string>(),
+                route.at("start_station_id").get<std::string>(),
+                route.at("end_station_id").get<std::string>(),
+                route.at("route_stops").get<std::vector<std::string>>()
+            });
+        }
+        nw.AddLine(lineData);
+    }
+    for (const auto& travelTime: layout.at("travel_times"))
+    {
+        nw.SetTravelTime(
+            travelTime.at("start_station_id").get<std::string>(),
+            travelTime.at("end_station_id").get<std::string>(),
+            travelTime.at("travel_time").get<unsigned int>()
+        );
+    }
+
+    return nw;
+}
+
+static void BM_LoadNetworkLayoutDom (
+    benchmark::State& state
+)
+{
+    for (auto _: state)
+    {
+        auto nw {LoadNetworkLayoutDom(TESTS_NETWORK_LAYOUT_JSON)};
+        benchmark::DoNotOptimize(nw);
+    }
+}
+BENCHMARK(BM_LoadNetworkLayoutDom);
+
+static void BM_LoadNetworkLayoutSax (
+    benchmark::State& state
+)
+{
+    const std::filesystem::path src {TESTS_NETWORK_LAYOUT_JSON};
+    for (auto _: state)
+    {
+        TransportNetwork nw {};
+        benchmark::DoNotOptimize(nw.FromJson(src));
+    }
+}
+BENCHMARK(BM_LoadNetworkLayoutSax);
+
+static void BM_OpenNetworkSnapshot (
+    benchmark::State& state
+)
+{
+    const auto snapshotPath {
+        std::filesystem::temp_directory_path() / "network-monitor-bench.snapshot"
+    };
+    if (!NetworkSnapshot::ConvertLayout(TESTS_NETWORK_LAYOUT_JSON, snapshotPath))
+    {
+        state.SkipWithError("Could not write the snapshot");
+        return;
+    }
+    const bool verifyChecksum {state.range(0) != 0};
+    for (auto _: state)
+    {
+        NetworkSnapshot snapshot {};
+        benchmark::DoNotOptimize(snapshot.Open(snapshotPath, verifyChecksum));
+    }
+    std::filesystem::remove(snapshotPath);
+}
+BENCHMARK(BM_OpenNetworkSnapshot)->Arg(0)->Arg(1);
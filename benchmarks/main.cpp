@@ -0,0 +1,5 @@
+/* BENCHMARK_MAIN defines the entry point of the benchmark executable.
+   Each benchmark file registers its own cases with the BENCHMARK macro */
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
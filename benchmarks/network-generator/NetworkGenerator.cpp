@@ -0,0 +1,262 @@
+#include "NetworkGenerator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using NetworkMonitor::Id;
+using NetworkMonitor::Line;
+using NetworkMonitor::LayoutTravelTime;
+using NetworkMonitor::NetworkGeneratorOptions;
+using NetworkMonitor::NetworkLayout;
+using NetworkMonitor::Route;
+using NetworkMonitor::Station;
+
+namespace
+{
+    /* IDs are zero-padded like in network-layout.json, to at least 3 digits */
+    Id MakeId (
+        const char* prefix,
+        size_t number,
+        size_t count
+    )
+    {
+        size_t width {3};
+        for (auto limit {count}; limit >= 1000; limit /= 10)
+        {
+            ++width;
+        }
+        auto digits {std::to_string(number)};
+        if (digits.size() < width)
+        {
+            digits.insert(0, width - digits.size(), '0');
+        }
+        return prefix + digits;
+    }
+
+    /* Draw the stops of each line, as station numbers */
+    std::vector<std::vector<size_t>> DrawLineStops (
+        const NetworkGeneratorOptions& options
+    )
+    {
+        const auto nStations {options.nStations};
+        const auto stopsPerLine {std::max<size_t>(options.stopsPerLine, 2)};
+        const auto ratio {std::clamp(options.interchangeRatio, 0.0, 0.9)};
+
+        std::mt19937 generator {options.seed};
+        std::uniform_real_distribution<double> coin {0.0, 1.0};
+
+        /* Stations are opened in order: station `opened` is the next new one */
+        std::vector<std::vector<size_t>> lines {};
+        size_t opened {0};
+        while (opened < nStations)
+        {
+            std::vector<size_t> stops {};
+            while (stops.size() < stopsPerLine)
+            {
+                /* The last line ends with the last station */
+                if (opened == nStations && stops.size() >= 2)
+                    break;
+
+                bool interchange {opened > 0 && (opened == nStations || coin(generator) < ratio)};
+                if (interchange)
+                {
+                    /* A line does not stop twice at the same station */
+                    const auto window {options.interchangeWindow};
+                    const size_t first {window == 0 || window >= opened ? 0 : opened - window};
+                    std::uniform_int_distribution<size_t> pick {first, opened - 1};
+                    interchange = false;
+                    for (int attempt {0}; attempt < 8 && !interchange; ++attempt)
+                    {
+                        const auto station {pick(generator)};
+                        if (std::find(stops.begin(), stops.end(), station) == stops.end())
+                        {
+                            stops.push_back(station);
+                            interchange = true;
+                        }
+                    }
+                    if (interchange)
+                        continue;
+                    if (opened == nStations)
+                        break;
+                }
+                stops.push_back(opened++);
+            }
+
+            /* Only possible with a single station */
+            if (stops.size() < 2)
+                break;
+            lines.push_back(std::move(stops));
+        }
+
+        return lines;
+    }
+
+    /* JSON string field. Generated IDs and names need no escaping */
+    struct Field
+    {
+        const char* key;
+        const std::string& value;
+    };
+
+    std::ostream& operator<< (
+        std::ostream& dst,
+        const Field& field
+    )
+    {
+        return dst << '"' << field.key << "\":\"" << field.value << '"';
+    }
+}   /* namespace */
+
+NetworkLayout NetworkMonitor::GenerateNetworkLayout (
+    const NetworkGeneratorOptions& options
+)
+{
+    NetworkLayout layout {};
+    const auto nStations {options.nStations};
+    layout.stations.reserve(nStations);
+    for (size_t station {0}; station < nStations; ++station)
+    {
+        layout.stations.push_back(Station {
+            MakeId("station_", station, nStations),
+            "Station " + std::to_string(station)
+        });
+    }
+
+    const auto lineStops {DrawLineStops(options)};
+    const auto nLines {lineStops.size()};
+    const auto nRoutes {2 * nLines};
+
+    /* The travel times are drawn after the stops, with their own sequence */
+    std::mt19937 generator {options.seed + 1};
+    std::uniform_int_distribution<unsigned int> travelTime {
+        std::min(options.minTravelTime, options.maxTravelTime),
+        std::max(options.minTravelTime, options.maxTravelTime)
+    };
+
+    layout.lines.reserve(nLines);
+    for (size_t line {0}; line < nLines; ++line)
+    {
+        const auto lineId {MakeId("line_", line, nLines)};
+        std::vector<Id> stops {};
+        stops.reserve(lineStops[line].size());
+        for (const auto station: lineStops[line])
+        {
+            stops.push_back(layout.stations[station].id);
+        }
+
+        Route inbound {
+            MakeId("route_", 2 * line, nRoutes),
+            "inbound",
+            lineId,
+            stops.front(),
+            stops.back(),
+            stops
+        };
+        std::reverse(stops.begin(), stops.end());
+        Route outbound {
+            MakeId("route_", 2 * line + 1, nRoutes),
+            "outbound",
+            lineId,
+            stops.front(),
+            stops.back(),
+            std::move(stops)
+        };
+
+        /* The travel time between two stations is the same both ways */
+        for (size_t stop {0}; stop + 1 < inbound.stops.size(); ++stop)
+        {
+            layout.travelTimes.push_back(LayoutTravelTime {
+                inbound.stops[stop],
+                inbound.stops[stop + 1],
+                lineId,
+                inbound.id,
+                travelTime(generator)
+            });
+        }
+
+        layout.lines.push_back(Line {
+            lineId,
+            "Line " + std::to_string(line),
+            {std::move(inbound), std::move(outbound)}
+        });
+    }
+
+    return layout;
+}
+
+bool NetworkMonitor::WriteNetworkLayout (
+    const NetworkLayout& layout,
+    std::ostream& dst
+)
+{
+    auto writeList {[&dst](const auto& items, auto writeItem) {
+        dst << '[';
+        bool first {true};
+        for (const auto& item: items)
+        {
+            dst << (first ? "\n" : ",\n");
+            writeItem(item);
+            first = false;
+        }
+        dst << "\n]";
+    }};
+
+    dst << "{\n\"lines\":";
+    writeList(layout.lines, [&dst, &writeList](const Line& line) {
+        dst << '{' << Field {"line_id", line.id} << ',' << Field {"name", line.name}
+            << ",\"routes\":";
+        writeList(line.routes, [&dst, &writeList](const Route& route) {
+            dst << '{' << Field {"route_id", route.id}
+                << ',' << Field {"direction", route.direction}
+                << ',' << Field {"line_id", route.lineId}
+                << ',' << Field {"start_station_id", route.startStationId}
+                << ',' << Field {"end_station_id", route.endStationId}
+                << ",\"route_stops\":";
+            writeList(route.stops, [&dst](const Id& stop) {
+                dst << '"' << stop << '"';
+            });
+            dst << '}';
+        });
+
+        /* The inbound route serves all the stations of the line */
+        dst << ",\"stations\":";
+        writeList(line.routes.front().stops, [&dst](const Id& stop) {
+            dst << '"' << stop << '"';
+        });
+        dst << '}';
+    });
+    dst << ",\n\"stations\":";
+    writeList(layout.stations, [&dst](const Station& station) {
+        dst << '{' << Field {"station_id", station.id} << ',' << Field {"name", station.name} << '}';
+    });
+    dst << ",\n\"travel_times\":";
+    writeList(layout.travelTimes, [&dst](const LayoutTravelTime& travelTime) {
+        dst << '{' << Field {"start_station_id", travelTime.startStationId}
+            << ',' << Field {"end_station_id", travelTime.endStationId}
+            << ',' << Field {"line_id", travelTime.lineId}
+            << ',' << Field {"route_id", travelTime.routeId}
+            << ",\"travel_time\":" << travelTime.travelTime << '}';
+    });
+    dst << "\n}\n";
+
+    return static_cast<bool>(dst);
+}
+
+bool NetworkMonitor::WriteNetworkLayout (
+    const NetworkLayout& layout,
+    const std::filesystem::path& dst
+)
+{
+    std::ofstream file {dst, std::ios::binary | std::ios::trunc};
+    if (!file)
+        return false;
+
+    return WriteNetworkLayout(layout, file) && static_cast<bool>(file.flush());
+}
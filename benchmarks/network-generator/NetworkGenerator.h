@@ -0,0 +1,88 @@
+/* @brief: Implement a deterministic generator of synthetic network layouts,
+ *         in the schema of network-layout.json, to measure how the network
+ *         scales far beyond the test layout.
+ *         The network grows line by line, like a city growing outwards: each
+ *         line mostly opens new stations, and some of its stops are
+ *         interchanges with stations opened by the lines just before it.
+ *         Each line has an inbound route and the same stops in reverse as an
+ *         outbound route.
+ */
+
+#ifndef NETWORK_GENERATOR_H
+#define NETWORK_GENERATOR_H
+
+#include "TransportNetwork.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <vector>
+
+namespace NetworkMonitor
+{
+    /* @brief: Generator settings
+     * @member:
+     *         - `nStations` every station is served by at least one line
+     *         - `stopsPerLine` stops of each line route. The last line may
+     *           be shorter
+     *         - `interchangeRatio` share of the stops of a line that are
+     *           interchanges with earlier lines, from 0 to 0.9
+     *         - `interchangeWindow` interchanges are drawn among the last
+     *           `interchangeWindow` stations that were opened, which keeps
+     *           lines local. 0 draws among all opened stations
+     *         - `minTravelTime`, `maxTravelTime` travel time between
+     *           adjacent stops, drawn uniformly
+     *         - `seed` the same settings and seed give the same layout
+     */
+    struct NetworkGeneratorOptions
+    {
+        size_t nStations {10000};
+        size_t stopsPerLine {30};
+        double interchangeRatio {0.25};
+        size_t interchangeWindow {300};
+        unsigned int minTravelTime {1};
+        unsigned int maxTravelTime {5};
+        std::uint32_t seed {42};
+    };
+
+    /* @brief: Travel time between 2 adjacent stops of a route */
+    struct LayoutTravelTime
+    {
+        Id startStationId {};
+        Id endStationId {};
+        Id lineId {};
+        Id routeId {};
+        unsigned int travelTime {0};
+    };
+
+    /* @brief: Content of a network layout */
+    struct NetworkLayout
+    {
+        std::vector<Station> stations {};
+        std::vector<Line> lines {};
+        std::vector<LayoutTravelTime> travelTimes {};
+    };
+
+    /* @brief: Generate a network layout */
+    NetworkLayout GenerateNetworkLayout (
+        const NetworkGeneratorOptions& options
+    );
+
+    /* @brief: Write a network layout as JSON, in the schema of
+     *         network-layout.json
+     * @return: false if there was an error while writing
+     * @note: The JSON is written as it goes, without building a document,
+     *        so that layouts of millions of stations can be written
+     */
+    bool WriteNetworkLayout (
+        const NetworkLayout& layout,
+        std::ostream& dst
+    );
+
+    bool WriteNetworkLayout (
+        const NetworkLayout& layout,
+        const std::filesystem::path& dst
+    );
+}   /* namespace NetworkMonitor */
+
+#endif  /* NETWORK_GENERATOR_H */
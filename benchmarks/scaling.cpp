@@ -0,0 +1,316 @@
+/* @brief: Benchmark how the network scales, on synthetic layouts of 10k,
+ *         100k and 1M stations written by the network generator: loading the
+ *         layout, the heap held by the loaded network, adding a line, the
+ *         station and travel time queries by ID, and recording passenger
+ *         events.
+ *         The layouts are generated and loaded once per size and per run.
+ *         Select a size with --benchmark_filter, e.g. 'Scaling.+/10000(/|$)'
+ */
+
+#include "NetworkGenerator.h"
+#include "TransportNetwork.h"
+
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+using NetworkMonitor::GenerateNetworkLayout;
+using NetworkMonitor::Id;
+using NetworkMonitor::Line;
+using NetworkMonitor::NetworkGeneratorOptions;
+using NetworkMonitor::PassengerEvent;
+using NetworkMonitor::TransportNetwork;
+using NetworkMonitor::WriteNetworkLayout;
+
+/* Heap bytes in use, 0 if the C library cannot tell */
+static size_t GetHeapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    /* Large blocks are mapped on their own, outside the arenas */
+    const auto info {mallinfo2()};
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+/* A generated layout, the network loaded from it and random queries drawn
+   from the layout */
+struct ScalingFixture
+{
+    std::filesystem::path layoutFile {};
+    size_t layoutBytes {0};
+    size_t nRoutes {0};
+    TransportNetwork nw {};
+    size_t networkHeapBytes {0};
+
+    /* Lines of the layout, to add again under new IDs */
+    std::vector<Line> lines {};
+
+    /* Adjacent stations, and stations on the same route with the IDs of its
+       line and route */
+    std::vector<std::pair<Id, Id>> adjacentStations {};
+    std::vector<std::array<Id, 4>> routeStations {};
+
+    std::vector<PassengerEvent> events {};
+
+    ~ScalingFixture()
+    {
+        std::error_code ec {};
+        std::filesystem::remove(layoutFile, ec);
+    }
+};
+
+static std::unique_ptr<ScalingFixture> MakeFixture (
+    size_t nStations
+)
+{
+    auto fixture {std::make_unique<ScalingFixture>()};
+    NetworkGeneratorOptions options {};
+    options.nStations = nStations;
+    auto layout {GenerateNetworkLayout(options)};
+    fixture->layoutFile = std::filesystem::temp_directory_path()
+        / ("network-layout-generated-" + std::to_string(nStations) + ".json");
+    if (!WriteNetworkLayout(layout, fixture->layoutFile))
+        return nullptr;
+    fixture->layoutBytes = std::filesystem::file_size(fixture->layoutFile);
+
+    const auto heapBefore {GetHeapInUse()};
+    if (!fixture->nw.FromJson(fixture->layoutFile))
+        return nullptr;
+    fixture->networkHeapBytes = GetHeapInUse() - heapBefore;
+
+    /* Draw the queries once, so that the timed loops only run them */
+    const size_t nQueries {1024};
+    std::mt19937 generator {7};
+    auto draw {[&generator](size_t size) {
+        return std::uniform_int_distribution<size_t> {0, size - 1}(generator);
+    }};
+    for (size_t query {0}; query < nQueries; ++query)
+    {
+        const auto& travelTime {layout.travelTimes[draw(layout.travelTimes.size())]};
+        fixture->adjacentStations.emplace_back(travelTime.startStationId, travelTime.endStationId);
+
+        const auto& line {layout.lines[draw(layout.lines.size())]};
+        const auto& route {line.routes[draw(line.routes.size())]};
+        auto stopA {draw(route.stops.size())};
+        auto stopB {draw(route.stops.size())};
+        if (stopA > stopB)
+        {
+            std::swap(stopA, stopB);
+        }
+        fixture->routeStations.push_back({line.id, route.id, route.stops[stopA], route.stops[stopB]});
+
+        fixture->events.push_back(PassengerEvent {
+            layout.stations[draw(layout.stations.size())].id,
+            draw(2) == 0 ? PassengerEvent::Type::In : PassengerEvent::Type::Out
+        });
+    }
+    for (size_t idx {0}; idx < 16; ++idx)
+    {
+        fixture->lines.push_back(layout.lines[draw(layout.lines.size())]);
+    }
+    fixture->nRoutes = 2 * layout.lines.size();
+
+    return fixture;
+}
+
+/* @return: nullptr if the layout could not be generated or loaded */
+static ScalingFixture* GetFixture (
+    size_t nStations
+)
+{
+    static std::mutex mutex {};
+    static std::map<size_t, std::unique_ptr<ScalingFixture>> fixtures {};
+    std::lock_guard<std::mutex> lock {mutex};
+    auto it {fixtures.find(nStations)};
+    if (it == fixtures.end())
+    {
+        it = fixtures.emplace(nStations, MakeFixture(nStations)).first;
+    }
+    return it->second.get();
+}
+
+static void ScalingSizes (
+    benchmark::internal::Benchmark* benchmark
+)
+{
+    benchmark->Arg(10000)->Arg(100000)->Arg(1000000);
+}
+
+static void BM_ScalingLoad (
+    benchmark::State& state
+)
+{
+    auto* fixture {GetFixture(state.range(0))};
+    if (fixture == nullptr)
+    {
+        state.SkipWithError("Could not generate the layout");
+        return;
+    }
+    for (auto _: state)
+    {
+        TransportNetwork nw {};
+        benchmark::DoNotOptimize(nw.FromJson(fixture->layoutFile));
+    }
+    state.SetBytesProcessed(state.iterations() * fixture->layoutBytes);
+    state.counters["routes"] = static_cast<double>(fixture->nRoutes);
+    state.counters["heap_MiB"] = fixture->networkHeapBytes / (1024.0 * 1024.0);
+    state.counters["heap_B_per_station"] =
+        static_cast<double>(fixture->networkHeapBytes) / state.range(0);
+}
+BENCHMARK(BM_ScalingLoad)->Apply(ScalingSizes)->Unit(benchmark::kMillisecond);
+
+static void BM_ScalingAddLine (
+    benchmark::State& state
+)
+{
+    auto* fixture {GetFixture(state.range(0))};
+    if (fixture == nullptr)
+    {
+        state.SkipWithError("Could not generate the layout");
+        return;
+    }
+
+    /* Add copies of existing lines, under new IDs, to a copy of the
+       network. The network hardly grows over the run */
+    auto nw {fixture->nw};
+    size_t added {0};
+    for (auto _: state)
+    {
+        state.PauseTiming();
+        auto line {fixture->lines[added % fixture->lines.size()]};
+        const auto suffix {"_copy_" + std::to_string(added++)};
+        line.id += suffix;
+        for (auto& route: line.routes)
+        {
+            route.id += suffix;
+            route.lineId = line.id;
+        }
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(nw.AddLine(line));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ScalingAddLine)->Apply(ScalingSizes)->Unit(benchmark::kMicrosecond);
+
+static void BM_ScalingGetRoutesServingStation (
+    benchmark::State& state
+)
+{
+    auto* fixture {GetFixture(state.range(0))};
+    if (fixture == nullptr)
+    {
+        state.SkipWithError("Could not generate the layout");
+        return;
+    }
+    const auto& events {fixture->events};
+    size_t idx {0};
+    for (auto _: state)
+    {
+        auto routes {fixture->nw.GetRoutesServingStation(events[idx++ % events.size()].stationId)};
+        benchmark::DoNotOptimize(routes);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ScalingGetRoutesServingStation)->Apply(ScalingSizes);
+
+/* The same queries through the reverse index, without copying the routes */
+static void BM_ScalingGetRoutesServingStationView (
+    benchmark::State& state
+)
+{
+    auto* fixture {GetFixture(state.range(0))};
+    if (fixture == nullptr)
+    {
+        state.SkipWithError("Could not generate the layout");
+        return;
+    }
+    const auto& events {fixture->events};
+    size_t idx {0};
+    for (auto _: state)
+    {
+        auto routes {fixture->nw.GetRoutesServingStationView(events[idx++ % events.size()].stationId)};
+        benchmark::DoNotOptimize(routes);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ScalingGetRoutesServingStationView)->Apply(ScalingSizes);
+
+static void BM_ScalingGetTravelTimeAdjacent (
+    benchmark::State& state
+)
+{
+    auto* fixture {GetFixture(state.range(0))};
+    if (fixture == nullptr)
+    {
+        state.SkipWithError("Could not generate the layout");
+        return;
+    }
+    const auto& pairs {fixture->adjacentStations};
+    size_t idx {0};
+    for (auto _: state)
+    {
+        const auto& [stationA, stationB] {pairs[idx++ % pairs.size()]};
+        benchmark::DoNotOptimize(fixture->nw.GetTravelTime(stationA, stationB));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ScalingGetTravelTimeAdjacent)->Apply(ScalingSizes);
+
+static void BM_ScalingGetTravelTimeRoute (
+    benchmark::State& state
+)
+{
+    auto* fixture {GetFixture(state.range(0))};
+    if (fixture == nullptr)
+    {
+        state.SkipWithError("Could not generate the layout");
+        return;
+    }
+    const auto& queries {fixture->routeStations};
+    size_t idx {0};
+    for (auto _: state)
+    {
+        const auto& [line, route, stationA, stationB] {queries[idx++ % queries.size()]};
+        benchmark::DoNotOptimize(fixture->nw.GetTravelTime(line, route, stationA, stationB));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ScalingGetTravelTimeRoute)->Apply(ScalingSizes);
+
+/* Bursts of 1024 events by station ID, from several threads at once */
+static void BM_ScalingRecordPassengerEvents (
+    benchmark::State& state
+)
+{
+    auto* fixture {GetFixture(state.range(0))};
+    if (fixture == nullptr)
+    {
+        state.SkipWithError("Could not generate the layout");
+        return;
+    }
+
+    /* Recording events only changes the passenger counts, so the other
+       benchmarks can share the network */
+    auto& nw {fixture->nw};
+    const auto& events {fixture->events};
+    for (auto _: state)
+    {
+        benchmark::DoNotOptimize(nw.RecordPassengerEvents(events.data(), events.size()));
+    }
+    state.SetItemsProcessed(state.iterations() * events.size());
+}
+BENCHMARK(BM_ScalingRecordPassengerEvents)->Apply(ScalingSizes)->ThreadRange(1, 4)->UseRealTime();
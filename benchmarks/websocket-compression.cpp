@@ -0,0 +1,197 @@
+/* @brief: Measure the cost and the gain of permessage-deflate on the
+ *         passenger event feed. A StompClient subscribes to the local test
+ *         server, which replays the recorded events, once per compression
+ *         setting. We report the TLS bytes on the wire and the CPU time per
+ *         message of the client (inflate) and of the server (deflate).
+ * @usage: network-monitor-compression-bench [nMessages]
+ */
+
+#include "StompClient.h"
+#include "StompFrame.h"
+#include "TestServer.h"
+#include "WebSocketClient.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using NetworkMonitor::CompressionOptions;
+using NetworkMonitor::StompAckMode;
+using NetworkMonitor::StompClient;
+using NetworkMonitor::StompFrame;
+using NetworkMonitor::StreamOptions;
+using NetworkMonitor::TestServer;
+using NetworkMonitor::TestServerOptions;
+
+using Clock = std::chrono::steady_clock;
+
+struct Setting
+{
+    std::string name {};
+    CompressionOptions compression {};
+};
+
+struct Result
+{
+    std::uint64_t nMessages {0};
+    std::uint64_t payloadBytes {0};
+    std::uint64_t wireBytes {0};
+    double clientCpuUs {0};
+    double serverCpuUs {0};
+    double seconds {0};
+};
+
+static double CpuTimeUs (
+    clockid_t clock
+)
+{
+    timespec time {};
+    clock_gettime(clock, &time);
+    return time.tv_sec * 1e6 + time.tv_nsec / 1e3;
+}
+
+static bool Run (
+    const Setting& setting,
+    const std::vector<std::string>& events,
+    Result& result
+)
+{
+    TestServerOptions serverOptions {};
+    serverOptions.certFile = TESTS_SERVER_CERT_PEM;
+    serverOptions.keyFile = TESTS_SERVER_KEY_PEM;
+    serverOptions.events = events;
+    serverOptions.compression = setting.compression;
+    TestServer server {serverOptions};
+    const auto port {server.Start()};
+    if (port == 0)
+        return false;
+
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+    StreamOptions streamOptions {};
+    streamOptions.compression = setting.compression;
+    StompClient client {"localhost", "/network-events", std::to_string(port), ioc, ctx,
+                        {}, streamOptions};
+
+    /* The client runs on this thread, the server on its own: the process CPU
+       time minus ours is the server one */
+    const auto clientCpuStart {CpuTimeUs(CLOCK_THREAD_CPUTIME_ID)};
+    const auto processCpuStart {CpuTimeUs(CLOCK_PROCESS_CPUTIME_ID)};
+    const auto start {Clock::now()};
+
+    result = {};
+    bool failed {false};
+    auto onMessage {[&](auto ec, const StompFrame& frame) {
+        if (ec)
+            return;
+
+        ++result.nMessages;
+        result.payloadBytes += frame.GetSize();
+        if (result.nMessages == events.size())
+        {
+            client.Close();
+        }
+    }};
+    client.Connect(serverOptions.username, serverOptions.password, [&](auto ec) {
+        if (ec)
+        {
+            failed = true;
+            return;
+        }
+        client.Subscribe("/passengers", StompAckMode::Auto, nullptr, onMessage);
+    });
+    ioc.run();
+
+    const auto clientCpu {CpuTimeUs(CLOCK_THREAD_CPUTIME_ID) - clientCpuStart};
+    const auto processCpu {CpuTimeUs(CLOCK_PROCESS_CPUTIME_ID) - processCpuStart};
+    result.seconds = std::chrono::duration<double> {Clock::now() - start}.count();
+    result.clientCpuUs = clientCpu;
+    result.serverCpuUs = processCpu - clientCpu;
+    result.wireBytes = client.GetMetrics().bytesReceived;
+    server.Stop();
+
+    return !failed && result.nMessages == events.size();
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t nMessages {argc > 1 ? std::stoul(argv[1]) : 20000};
+
+    /* Repeat the recording up to the requested number of messages */
+    const auto recorded {TestServer::LoadEvents(TESTS_PASSENGER_EVENTS)};
+    if (recorded.empty())
+    {
+        std::cerr << "Could not load the recorded events" << std::endl;
+        return 1;
+    }
+    std::vector<std::string> events {};
+    events.reserve(nMessages);
+    while (events.size() < nMessages)
+    {
+        events.push_back(recorded[events.size() % recorded.size()]);
+    }
+
+    std::vector<Setting> settings {};
+    settings.push_back({"off", {}});
+    {
+        Setting setting {"deflate", {}};
+        setting.compression.enabled = true;
+        settings.push_back(setting);
+    }
+    {
+        Setting setting {"deflate level 1", {}};
+        setting.compression.enabled = true;
+        setting.compression.level = 1;
+        settings.push_back(setting);
+    }
+    {
+        Setting setting {"deflate window 9 mem 1", {}};
+        setting.compression.enabled = true;
+        setting.compression.windowBits = 9;
+        setting.compression.memLevel = 1;
+        settings.push_back(setting);
+    }
+    {
+        Setting setting {"deflate no context", {}};
+        setting.compression.enabled = true;
+        setting.compression.noContextTakeover = true;
+        settings.push_back(setting);
+    }
+
+    std::cout << std::left << std::setw(24) << "setting"
+              << std::right << std::setw(12) << "payload B"
+              << std::setw(12) << "wire B"
+              << std::setw(10) << "ratio"
+              << std::setw(16) << "client us/msg"
+              << std::setw(16) << "server us/msg"
+              << std::setw(12) << "msgs/s" << std::endl;
+    for (const auto& setting: settings)
+    {
+        Result result {};
+        if (!Run(setting, events, result))
+        {
+            std::cerr << setting.name << ": run failed" << std::endl;
+            return 1;
+        }
+        const auto n {static_cast<double>(result.nMessages)};
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::left << std::setw(24) << setting.name
+                  << std::right << std::setw(12) << result.payloadBytes / n
+                  << std::setw(12) << result.wireBytes / n
+                  << std::setw(10) << static_cast<double>(result.payloadBytes) / result.wireBytes
+                  << std::setw(16) << result.clientCpuUs / n
+                  << std::setw(16) << result.serverCpuUs / n
+                  << std::setw(12) << std::setprecision(0) << n / result.seconds
+                  << std::endl;
+    }
+
+    return 0;
+}
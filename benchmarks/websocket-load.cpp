@@ -0,0 +1,150 @@
+/* @brief: Load test the WebSocketClient against the local TLS echo server.
+ *         The client keeps a window of messages in flight and measures the
+ *         round-trip time of each one. We report the throughput and the
+ *         p50/p99/p999 round-trip latency.
+ * @usage: network-monitor-loadtest [nMessages] [messageSize] [window]
+ *                                  [serverThreads]
+ */
+
+#include "TestServer.h"
+#include "WebSocketClient.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using NetworkMonitor::TestServer;
+using NetworkMonitor::TestServerOptions;
+using NetworkMonitor::WebSocketClient;
+
+using Clock = std::chrono::steady_clock;
+
+static size_t GetArg (
+    int argc,
+    char* argv[],
+    int idx,
+    size_t defaultValue
+)
+{
+    if (idx >= argc)
+        return defaultValue;
+
+    return std::stoul(argv[idx]);
+}
+
+static double Percentile (
+    const std::vector<double>& sorted,
+    double percentile
+)
+{
+    if (sorted.empty())
+        return 0;
+
+    const auto idx {static_cast<size_t>(percentile * (sorted.size() - 1))};
+    return sorted[idx];
+}
+
+int main(int argc, char* argv[])
+{
+    const auto nMessages {GetArg(argc, argv, 1, 100000)};
+    const auto messageSize {GetArg(argc, argv, 2, 256)};
+    const auto window {std::max<size_t>(GetArg(argc, argv, 3, 64), 1)};
+    const auto serverThreads {GetArg(argc, argv, 4, 1)};
+
+    TestServerOptions options {};
+    options.certFile = TESTS_SERVER_CERT_PEM;
+    options.keyFile = TESTS_SERVER_KEY_PEM;
+    options.nThreads = static_cast<unsigned int>(serverThreads);
+    TestServer server {options};
+    const auto port {server.Start()};
+    if (port == 0)
+    {
+        std::cerr << "Could not start the test server" << std::endl;
+        return 1;
+    }
+
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    WebSocketClient client {"localhost", "/echo", std::to_string(port), ioc, ctx};
+    client.ReserveReadBuffer(messageSize);
+
+    /* Each message starts with its index, padded to the message size */
+    std::vector<Clock::time_point> sent(nMessages);
+    std::vector<double> latenciesUs {};
+    latenciesUs.reserve(nMessages);
+    size_t nSent {0};
+    bool failed {false};
+    auto sendNext {[&]() {
+        auto message {std::to_string(nSent) + ' '};
+        message.resize(std::max(messageSize, message.size()), 'x');
+        sent[nSent] = Clock::now();
+        ++nSent;
+        client.Send(std::move(message));
+    }};
+
+    Clock::time_point start {};
+    auto onConnect {[&](auto ec) {
+        if (ec)
+        {
+            failed = true;
+            return;
+        }
+        start = Clock::now();
+        while (nSent < std::min(window, nMessages))
+        {
+            sendNext();
+        }
+    }};
+    auto onMessage {[&](auto ec, std::string_view message) {
+        if (ec)
+            return;
+
+        size_t idx {0};
+        std::from_chars(message.data(), message.data() + message.size(), idx);
+        if (idx < nSent)
+        {
+            const std::chrono::duration<double, std::micro> latency {Clock::now() - sent[idx]};
+            latenciesUs.push_back(latency.count());
+        }
+        if (nSent < nMessages)
+        {
+            sendNext();
+        }
+        else if (latenciesUs.size() == nMessages)
+        {
+            client.Close();
+        }
+    }};
+
+    client.ConnectWithMessageView(onConnect, onMessage);
+    ioc.run();
+    const std::chrono::duration<double> elapsed {Clock::now() - start};
+    server.Stop();
+
+    if (failed || latenciesUs.size() != nMessages)
+    {
+        std::cerr << "Load test failed: " << latenciesUs.size() << "/" << nMessages
+                  << " messages echoed" << std::endl;
+        return 1;
+    }
+
+    std::sort(latenciesUs.begin(), latenciesUs.end());
+    std::cout << std::fixed << std::setprecision(1)
+              << "messages:     " << nMessages << " x " << messageSize << " B"
+              << ", window " << window << std::endl
+              << "throughput:   " << nMessages / elapsed.count() << " msgs/s" << std::endl
+              << "latency p50:  " << Percentile(latenciesUs, 0.50) << " us" << std::endl
+              << "latency p99:  " << Percentile(latenciesUs, 0.99) << " us" << std::endl
+              << "latency p999: " << Percentile(latenciesUs, 0.999) << " us" << std::endl;
+
+    return 0;
+}
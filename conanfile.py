@@ -7,6 +7,7 @@ class ConnaPackage(ConanFile):
    generators = 'cmake_find_package'
 
    requires = [
+      ('benchmark/1.5.2'),
       ('boost/1.75.0'),
       ('libcurl/7.73.0'),
       ('nlohmann_json/3.9.1'),
@@ -0,0 +1,110 @@
+/* @brief: Coroutine flavour of the WebSocketClient. Each operation is awaited
+ *         from a C++20 coroutine instead of taking a callback, so there is no
+ *         std::function on the message path.
+ * @note: Needs C++20. Only the network-monitor-coro target builds it
+ */
+
+#ifndef AWAITABLE_WEBSOCKET_CLIENT_H
+#define AWAITABLE_WEBSOCKET_CLIENT_H
+
+/* asio/awaitable.hpp calls std::exchange but does not include <utility>
+ * itself, so it has to be visible before any Asio header */
+#include <utility>
+
+#include "WebSocketClient.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if !defined(BOOST_ASIO_HAS_CO_AWAIT)
+#error "AwaitableWebSocketClient.h needs a C++20 compiler with coroutine support"
+#endif
+
+namespace NetworkMonitor
+{
+    /* @brief: WebSocket client driven by coroutines
+     *         All operations run on the client strand: spawn the coroutines
+     *         that use the client on GetExecutor(). Errors are returned, not
+     *         thrown.
+     *
+     *         boost::asio::co_spawn(client.GetExecutor(), [&]() -> awaitable<void> {
+     *             auto ec {co_await client.Connect()};
+     *             ec = co_await client.Send("hello");
+     *             auto [readEc, message] {co_await client.Read()};
+     *             co_await client.Close();
+     *         }, boost::asio::detached);
+     *
+     * @note: Like the underlying stream, allow at most one Read and one Send in
+     *        progress at a time. One coroutine may read while another writes.
+     *        The client connects once: create a new one to reconnect
+     */
+    class AwaitableWebSocketClient
+    {
+    public:
+        using Executor = boost::asio::strand<boost::asio::io_context::executor_type>;
+
+        AwaitableWebSocketClient(
+            const std::string& url,
+            const std::string& endpoint,
+            const std::string& port,
+            boost::asio::io_context& ioc,
+            boost::asio::ssl::context& ctx,
+            const StreamOptions& streamOptions = {}
+        );
+
+        /* @brief: Get the client strand, to spawn coroutines on */
+        Executor GetExecutor() const;
+
+        /* @brief: Resolve, connect, then perform the TLS and WebSocket
+         *         handshakes
+         */
+        boost::asio::awaitable<boost::system::error_code> Connect();
+
+        /* @brief: Write one text message
+         * @note: The message must stay alive until the call completes
+         */
+        boost::asio::awaitable<boost::system::error_code> Send (
+            std::string_view message
+        );
+
+        /* @brief: Read the next message
+         * @note: The view points into the read buffer and is only valid until
+         *        the next Read. Copy what needs to outlive it
+         */
+        boost::asio::awaitable<std::pair<boost::system::error_code, std::string_view>> Read();
+
+        /* @brief: Reserve room in the read buffer for incoming messages
+         * @note: Call it before connecting
+         */
+        void ReserveReadBuffer (
+            size_t nBytes
+        );
+
+        boost::asio::awaitable<boost::system::error_code> Close();
+
+    private:
+        using Stream = boost::beast::websocket::stream<
+            boost::beast::ssl_stream<boost::beast::tcp_stream>
+        >;
+
+        std::string url_ {};
+        std::string endpoint_ {};
+        std::string port_ {};
+
+        /* The resolver and the stream share the strand on which the
+           coroutines run, so every completion resumes them in place */
+        Executor strand_;
+        boost::asio::ip::tcp::resolver resolver_;
+        Stream ws_;
+        boost::beast::flat_buffer rBuffer_ {};
+    };
+}   /* namespace NetworkMonitor */
+
+#endif  /* AWAITABLE_WEBSOCKET_CLIENT_H */
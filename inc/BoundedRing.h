@@ -0,0 +1,150 @@
+/* @brief: Implement a bounded lock-free multi-producer multi-consumer ring.
+ *         Each cell carries a sequence number that tells producers and
+ *         consumers whose turn it is, so pushes and pops only contend on
+ *         one atomic index each and never take a lock.
+ */
+
+#ifndef BOUNDED_RING_H
+#define BOUNDED_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace NetworkMonitor
+{
+    template <typename T>
+    class BoundedRing
+    {
+    public:
+        /* @brief: Create a ring
+         * @note: The capacity is rounded up to a power of 2
+         */
+        explicit BoundedRing (
+            size_t capacity
+        )
+        {
+            size_t size {2};
+            while (size < capacity)
+            {
+                size *= 2;
+            }
+            cells_ = std::make_unique<Cell[]>(size);
+            for (size_t idx {0}; idx < size; ++idx)
+            {
+                cells_[idx].sequence.store(idx, std::memory_order_relaxed);
+            }
+            mask_ = size - 1;
+        }
+
+        BoundedRing (
+            const BoundedRing& copied
+        ) = delete;
+
+        BoundedRing& operator= (
+            const BoundedRing& copied
+        ) = delete;
+
+        /* @brief: Push a value
+         * @return: false if the ring is full. `value` is left untouched
+         */
+        bool TryPush (
+            T& value
+        )
+        {
+            auto pos {head_.load(std::memory_order_relaxed)};
+            while (true)
+            {
+                auto& cell {cells_[pos & mask_]};
+                const auto sequence {cell.sequence.load(std::memory_order_acquire)};
+                const auto diff {static_cast<std::ptrdiff_t>(sequence - pos)};
+                if (diff == 0)
+                {
+                    /* The cell is free for this position: claim it */
+                    if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        cell.value = std::move(value);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    /* The cell still holds the value of the previous lap */
+                    return false;
+                }
+                else
+                {
+                    pos = head_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /* @brief: Pop the oldest value
+         * @return: false if the ring is empty
+         */
+        bool TryPop (
+            T& value
+        )
+        {
+            auto pos {tail_.load(std::memory_order_relaxed)};
+            while (true)
+            {
+                auto& cell {cells_[pos & mask_]};
+                const auto sequence {cell.sequence.load(std::memory_order_acquire)};
+                const auto diff {static_cast<std::ptrdiff_t>(sequence - (pos + 1))};
+                if (diff == 0)
+                {
+                    if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        value = std::move(cell.value);
+                        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = tail_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /* @brief: Get the number of values in the ring
+         * @note: This is a snapshot, other threads may change it right away
+         */
+        size_t Size() const
+        {
+            const auto tail {tail_.load(std::memory_order_relaxed)};
+            const auto head {head_.load(std::memory_order_relaxed)};
+            return head > tail ? head - tail : 0;
+        }
+
+        size_t Capacity() const
+        {
+            return mask_ + 1;
+        }
+
+    private:
+        static constexpr size_t kCacheLineSize {64};
+
+        struct alignas(kCacheLineSize) Cell
+        {
+            std::atomic<size_t> sequence {0};
+            T value {};
+        };
+
+        std::unique_ptr<Cell[]> cells_ {};
+        size_t mask_ {0};
+
+        /* Producers and consumers each get their own cache line */
+        alignas(kCacheLineSize) std::atomic<size_t> head_ {0};
+        alignas(kCacheLineSize) std::atomic<size_t> tail_ {0};
+    };
+}   /* namespace NetworkMonitor */
+
+#endif  /* BOUNDED_RING_H */
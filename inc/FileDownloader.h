@@ -6,9 +6,16 @@
 #ifndef FILE_DOWNLOADER_H
 #define FILE_DOWNLOADER_H
 
+#include <boost/asio.hpp>
 #include <nlohmann/json.hpp>
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <filesystem>
 
 namespace NetworkMonitor
@@ -19,6 +26,200 @@ namespace NetworkMonitor
         const std::filesystem::path& caFile = {}
     );
 
+    /* @brief: Download settings
+     * @member:
+     *         - `etag` validator of the copy we have, sent as If-None-Match
+     *         - `lastModified` HTTP date of the copy we have, sent as
+     *           If-Modified-Since
+     *           With either one, an unchanged file costs a 304 response and
+     *           the destination is left untouched
+     *         - `resume` continue a partial destination file with a Range
+     *           request. If the server ignores the range, the whole file is
+     *           downloaded again
+     *         - `partialValidator` validator of the partial destination file:
+     *           the `etag` or, without one, the `lastModified` of the download
+     *           that wrote it. Sent as If-Range, so that a server whose file
+     *           changed since sends the whole new file instead of a range of
+     *           it. `resume` needs it: without it, or with a weak ETag, the
+     *           whole file is downloaded
+     */
+    struct DownloadOptions
+    {
+        std::string etag {};
+        std::string lastModified {};
+        bool resume {false};
+        std::string partialValidator {};
+    };
+
+    /* @brief: Outcome of a download
+     * @member:
+     *         - `ok` the destination holds the whole file, including when it
+     *           was not modified
+     *         - `notModified` the server answered 304
+     *         - `resumed` the server only sent the missing part of the file
+     *         - `httpStatus` status of the last response, 0 if none
+     *         - `bytesReceived` body bytes received by this download
+     *         - `newConnections` connections opened for this download. 0
+     *           means an existing connection was reused
+     *         - `etag`, `lastModified` validators sent by the server, to pass
+     *           to the next download of the same file. Also set when the
+     *           transfer fails halfway, to resume it
+     *         - `elapsed` total transfer time
+     *         - `error` libcurl or HTTP error, empty on success
+     */
+    struct DownloadResult
+    {
+        bool ok {false};
+        bool notModified {false};
+        bool resumed {false};
+        long httpStatus {0};
+        std::uint64_t bytesReceived {0};
+        long newConnections {0};
+        std::string etag {};
+        std::string lastModified {};
+        std::chrono::microseconds elapsed {0};
+        std::string error {};
+    };
+
+    /* @brief: Reader of a streamed download body, see FileDownloader::Stream
+     * @return: false to reject the body
+     */
+    using BodyConsumer = std::function<bool (std::istream& body)>;
+
+    /* @brief: Blocking downloader that keeps its libcurl handle, and with it
+     *         the open connections and TLS sessions, across downloads
+     * @note: Not thread-safe. Use one downloader per thread
+     */
+    class FileDownloader
+    {
+    public:
+        explicit FileDownloader (
+            const std::filesystem::path& caFile = {}
+        );
+        ~FileDownloader();
+
+        FileDownloader (
+            const FileDownloader& copied
+        ) = delete;
+
+        FileDownloader& operator= (
+            const FileDownloader& copied
+        ) = delete;
+
+        DownloadResult Download (
+            const std::string& fileURL,
+            const std::filesystem::path& destination,
+            const DownloadOptions& options = {}
+        );
+
+        /* @brief: Download a file and read its body as it arrives, without
+         *         an intermediate file
+         *         `consume` runs on this thread while the transfer is in
+         *         progress: reading past the bytes received so far waits for
+         *         the next ones. It is only called for a 200 response, so a
+         *         304 leaves the caller's copy as it is. What it does not
+         *         read is received and dropped
+         *         With a `cacheFile`, the body is also written there, and
+         *         only replaces the previous cache once the whole body was
+         *         received and accepted
+         * @return: `ok` is false if the transfer failed or if `consume`
+         *          rejected the body
+         * @note: `options.resume` is ignored: the body is always read whole
+         */
+        DownloadResult Stream (
+            const std::string& fileURL,
+            const BodyConsumer& consume,
+            const DownloadOptions& options = {},
+            const std::filesystem::path& cacheFile = {}
+        );
+
+        /* libcurl handles, defined with the downloader */
+        struct State;
+
+    private:
+        std::unique_ptr<State> state_ {};
+    };
+
+    /* @brief: Concurrent downloads with libcurl multi, driven by an
+     *         io_context. The transfers share the connections, the TLS
+     *         sessions and the DNS cache
+     *         `maxCachedConnections` idle connections are kept open for
+     *         later downloads. libcurl's default depends on the number of
+     *         downloads in progress, and closes connections as they finish
+     * @note: Everything runs on a strand of the io_context: Download can be
+     *        called from any thread and `onDone` runs on the strand.
+     *        Destroy the downloader once the io_context has stopped running.
+     *        Transfers still in progress then never complete
+     */
+    class MultiFileDownloader
+    {
+    public:
+        using OnDone = std::function<void (const DownloadResult&)>;
+
+        MultiFileDownloader (
+            boost::asio::io_context& ioc,
+            const std::filesystem::path& caFile = {},
+            size_t maxCachedConnections = 16
+        );
+        ~MultiFileDownloader();
+
+        MultiFileDownloader (
+            const MultiFileDownloader& copied
+        ) = delete;
+
+        MultiFileDownloader& operator= (
+            const MultiFileDownloader& copied
+        ) = delete;
+
+        /* @brief: Start a download. It keeps the io_context busy until
+         *         `onDone` runs
+         */
+        void Download (
+            const std::string& fileURL,
+            const std::filesystem::path& destination,
+            const DownloadOptions& options,
+            OnDone onDone
+        );
+
+        /* libcurl handles and sockets, defined with the downloader */
+        struct State;
+
+    private:
+        std::unique_ptr<State> state_ {};
+    };
+
+    /* @brief: Outcome of a JSON parse
+     * @member:
+     *         - `ok` `json` holds the parsed document
+     *         - `errorOffset` byte offset in the input where the parse
+     *           failed. The input size if it ended too early
+     *         - `error` reason of the failure, empty on success
+     */
+    struct JsonParseResult
+    {
+        bool ok {false};
+        nlohmann::json json {};
+        size_t errorOffset {0};
+        std::string error {};
+    };
+
+    /* @brief: Parse a JSON document from a contiguous buffer */
+    JsonParseResult ParseJson (
+        std::string_view buffer
+    );
+
+    /* @brief: Parse a JSON file
+     *         The file is mapped in memory and parsed as one buffer, which is
+     *         several times faster than reading it through an iostream
+     */
+    JsonParseResult LoadJsonFile (
+        const std::filesystem::path& src
+    );
+
+    /* @brief: Parse a JSON file
+     * @return: A null JSON value if the file does not exist or is not valid
+     *          JSON. Use LoadJsonFile to know why
+     */
     nlohmann::json ParseJsonFile (
         const std::filesystem::path& src
     );
@@ -0,0 +1,67 @@
+/* @brief: Implement a symbol table that interns string IDs into small
+ *         integer handles.
+ *         An ID string is hashed once, when it is interned at load time.
+ *         Hot callers then keep the handle and never hash the string again.
+ */
+
+#ifndef ID_TABLE_H
+#define ID_TABLE_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace NetworkMonitor
+{
+    /* Interned ID handle
+       Handles are dense: the n-th interned ID gets handle n */
+    using Handle = std::uint32_t;
+    constexpr Handle kInvalidHandle {std::numeric_limits<Handle>::max()};
+
+    class IdTable
+    {
+    public:
+        /* @brief: Intern an ID
+         * @return: The handle of the ID. An ID that is already in the table
+         *          keeps its handle
+         */
+        Handle Intern (
+            const std::string& id
+        );
+
+        /* @brief: Look up the handle of an ID
+         * @return: kInvalidHandle if the ID has not been interned
+         */
+        Handle Find (
+            const std::string& id
+        ) const;
+
+        /* @brief: Get the ID of a handle
+         * @note: The handle must be valid
+         */
+        const std::string& GetId (
+            Handle handle
+        ) const;
+
+        /* @brief: Remove the IDs interned after the first `size` ones */
+        void Truncate (
+            size_t size
+        );
+
+        /* @brief: Reserve space for `size` IDs */
+        void Reserve (
+            size_t size
+        );
+
+        /* @brief: Number of interned IDs */
+        size_t Size() const;
+
+    private:
+        std::vector<std::string> ids_ {};
+        std::unordered_map<std::string, Handle> handles_ {};
+    };
+}   /* namespace NetworkMonitor */
+
+#endif  /* ID_TABLE_H */
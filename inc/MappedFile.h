@@ -0,0 +1,75 @@
+/* @brief: Implement a read-only memory mapping of a whole file.
+ *         Parsers read the file as one contiguous buffer, straight from the
+ *         page cache, without copying it through an iostream.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace NetworkMonitor
+{
+    /* How a mapped file is read, passed on to the kernel as advice */
+    enum class MappedFileAccess
+    {
+        /* Front to back, once, as parsers do: read ahead aggressively */
+        Sequential,
+
+        /* In any order, for as long as the file is open */
+        Normal,
+    };
+
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+
+        /* @brief: Unmap the file */
+        ~MappedFile();
+
+        MappedFile (
+            const MappedFile& copied
+        ) = delete;
+
+        MappedFile& operator= (
+            const MappedFile& copied
+        ) = delete;
+
+        MappedFile (
+            MappedFile&& moved
+        );
+
+        MappedFile& operator= (
+            MappedFile&& moved
+        );
+
+        /* @brief: Map a file, replacing the current one
+         * @return: false if the file could not be opened or mapped. An empty
+         *          file opens, with an empty view
+         */
+        bool Open (
+            const std::filesystem::path& src,
+            MappedFileAccess access = MappedFileAccess::Sequential
+        );
+
+        void Close();
+
+        bool IsOpen() const;
+
+        /* @brief: Get the file content
+         * @note: The view is valid until the file is closed. Moving the
+         *        file moves the mapping, so the view stays valid
+         */
+        std::string_view GetView() const;
+
+    private:
+        void* mapping_ {nullptr};
+        size_t size_ {0};
+        bool open_ {false};
+    };
+}   /* namespace NetworkMonitor */
+
+#endif  /* MAPPED_FILE_H */
@@ -0,0 +1,264 @@
+/* @brief: Implement the travel time queries shared by TransportNetwork and
+ *         NetworkSnapshot.
+ *         Both store the network graph in the same compressed-sparse-row
+ *         layout, one in vectors and one in a mapped file. The view reads
+ *         that layout through plain pointers, so that both network types
+ *         answer queries with the same code.
+ */
+
+#ifndef NETWORK_GRAPH_VIEW_H
+#define NETWORK_GRAPH_VIEW_H
+
+#include "IdTable.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+namespace NetworkMonitor
+{
+    /* Stop position of a station that a route stops at more than once, like
+       a loop route at its terminus */
+    constexpr Handle kRepeatedStop {kInvalidHandle - 1};
+
+    /* @brief: Get the size of the stop position table of a route
+     * @return: A power of two larger than twice the number of stops, so that
+     *          the table always has empty slots and probes stay short
+     */
+    inline size_t GetRouteStopSlotCount (
+        size_t nStops
+    )
+    {
+        size_t nSlots {1};
+        while (nSlots <= 2 * nStops)
+        {
+            nSlots *= 2;
+        }
+        return nSlots;
+    }
+
+    /* @brief: Get the first slot to probe for a station in a stop position
+     *         table of `nSlots` slots
+     */
+    inline size_t GetRouteStopSlot (
+        Handle station,
+        size_t nSlots
+    )
+    {
+        /* Fibonacci hashing: the high bits of the product are well mixed */
+        return static_cast<size_t>((station * 0x9E3779B97F4A7C15ull) >> 32) & (nSlots - 1);
+    }
+
+    /* @brief: Read-only view over a compressed-sparse-row network graph
+     * @note: `Edge` must have `nextStop` and `travelTime` members,
+     *        `StationStop` must have `route` and `stop` members and
+     *        `RouteStopSlot` must have `station` and `stop` members.
+     *        The outgoing edges of station `s` are `edges[edgeOffsets[s]]` to
+     *        `edges[edgeOffsets[s + 1] - 1]`, and the route stops served at
+     *        it are laid out the same way in `stationStops`, sorted by route
+     *        then by position. `routeTravelTimes` holds the cumulative travel
+     *        time of each route stop.
+     *        The stop position table of route `r` is laid out the same way in
+     *        `routeStopSlots`. It is an open-addressing hash table of
+     *        GetRouteStopSlotCount slots, probed linearly from
+     *        GetRouteStopSlot. Each station the route stops at has one slot
+     *        holding the position of its stop, or kRepeatedStop. Empty slots
+     *        have an invalid station
+     */
+    template <typename Offset, typename Edge, typename StationStop, typename TravelTime,
+              typename RouteStopSlot>
+    class NetworkGraphView
+    {
+    public:
+        NetworkGraphView (
+            size_t nStations,
+            size_t nRoutes,
+            const Offset* edgeOffsets,
+            const Edge* edges,
+            const Offset* stationStopOffsets,
+            const StationStop* stationStops,
+            const TravelTime* routeTravelTimes,
+            const Offset* routeStopSlotOffsets,
+            const RouteStopSlot* routeStopSlots
+        ) : nStations_ {nStations},
+            nRoutes_ {nRoutes},
+            edgeOffsets_ {edgeOffsets},
+            edges_ {edges},
+            stationStopOffsets_ {stationStopOffsets},
+            stationStops_ {stationStops},
+            routeTravelTimes_ {routeTravelTimes},
+            routeStopSlotOffsets_ {routeStopSlotOffsets},
+            routeStopSlots_ {routeStopSlots}
+        {
+        }
+
+        /* @brief: Get the travel time between two adjacent stations
+         * @return: 0 if the stations are the same, unknown or not adjacent
+         */
+        unsigned int GetTravelTime (
+            Handle stationA,
+            Handle stationB
+        ) const
+        {
+            if (stationA == stationB
+                || stationA >= nStations_
+                || stationB >= nStations_)
+                return 0;
+
+            /* Search all edges connecting A -> B and B -> A */
+            for (auto edge {edgeOffsets_[stationA]}; edge < edgeOffsets_[stationA + 1]; ++edge)
+            {
+                if (edges_[edge].nextStop == stationB)
+                    return edges_[edge].travelTime;
+            }
+            for (auto edge {edgeOffsets_[stationB]}; edge < edgeOffsets_[stationB + 1]; ++edge)
+            {
+                if (edges_[edge].nextStop == stationA)
+                    return edges_[edge].travelTime;
+            }
+
+            return 0;
+        }
+
+        /* @brief: Get the travel time between two stations along a route
+         * @return: 0 if the stations are the same or unknown, or if the
+         *          route does not serve station B after station A
+         * @note: Constant time: the stop positions come from the route's
+         *        stop position table, and the travel time is the difference
+         *        of their cumulative travel times. Only a route that stops
+         *        more than once at A or B, like a loop route, searches the
+         *        stops served at the two stations
+         */
+        unsigned int GetTravelTime (
+            Handle route,
+            Handle stationA,
+            Handle stationB
+        ) const
+        {
+            if (stationA == stationB
+                || route >= nRoutes_
+                || stationA >= nStations_
+                || stationB >= nStations_)
+                return 0;
+
+            auto stopA {FindRouteStop(route, stationA)};
+            auto stopB {FindRouteStop(route, stationB)};
+            if (stopA == kInvalidHandle || stopB == kInvalidHandle)
+                return 0;
+
+            if ((stopA == kRepeatedStop || stopB == kRepeatedStop)
+                && !FindRouteRide(route, stationA, stationB, stopA, stopB))
+                return 0;
+
+            /* Station B must come after station A on this route */
+            if (stopB < stopA)
+                return 0;
+
+            return routeTravelTimes_[stopB] - routeTravelTimes_[stopA];
+        }
+
+    private:
+        size_t nStations_ {0};
+        size_t nRoutes_ {0};
+        const Offset* edgeOffsets_ {nullptr};
+        const Edge* edges_ {nullptr};
+        const Offset* stationStopOffsets_ {nullptr};
+        const StationStop* stationStops_ {nullptr};
+        const TravelTime* routeTravelTimes_ {nullptr};
+        const Offset* routeStopSlotOffsets_ {nullptr};
+        const RouteStopSlot* routeStopSlots_ {nullptr};
+
+        /* Find the position of the stop of a route at a station
+           Return kInvalidHandle if the route does not stop at the station,
+           or kRepeatedStop if it stops there more than once */
+        Offset FindRouteStop (
+            Handle route,
+            Handle station
+        ) const
+        {
+            const auto* slots {routeStopSlots_ + routeStopSlotOffsets_[route]};
+            const size_t nSlots {routeStopSlotOffsets_[route + 1] - routeStopSlotOffsets_[route]};
+            if (nSlots == 0)
+                return kInvalidHandle;
+
+            /* The table always has an empty slot. Bound the probes anyway, so
+               that a corrupted snapshot cannot make us loop */
+            auto slot {GetRouteStopSlot(station, nSlots)};
+            for (size_t probe {0}; probe < nSlots; ++probe)
+            {
+                if (slots[slot].station == station)
+                    return slots[slot].stop;
+                if (slots[slot].station == kInvalidHandle)
+                    return kInvalidHandle;
+                slot = (slot + 1) & (nSlots - 1);
+            }
+
+            return kInvalidHandle;
+        }
+
+        /* Find the positions in the route stops of a ride on a route from
+           station A to a later stop at station B. A loop route can stop more
+           than once at a station: we pick the shortest ride
+           Return false if the route does not serve B after A
+           The stops of a route at a station are found by binary search */
+        bool FindRouteRide (
+            Handle route,
+            Handle stationA,
+            Handle stationB,
+            Offset& stopA,
+            Offset& stopB
+        ) const
+        {
+            auto [firstA, lastA] {FindRouteStops(route, stationA)};
+            const auto [firstB, lastB] {FindRouteStops(route, stationB)};
+
+            /* For each stop at B, the best stop at A is the last one before
+               it, as the cumulative travel times never decrease along a
+               route. Both ranges are sorted by position */
+            bool found {false};
+            Offset lastStopA {kInvalidHandle};
+            for (auto stationStopB {firstB}; stationStopB != lastB; ++stationStopB)
+            {
+                const auto candidateB {stationStopB->stop};
+                while (firstA != lastA && firstA->stop < candidateB)
+                {
+                    lastStopA = firstA->stop;
+                    ++firstA;
+                }
+                if (lastStopA == kInvalidHandle)
+                    continue;
+
+                if (!found
+                    || routeTravelTimes_[candidateB] - routeTravelTimes_[lastStopA]
+                        < routeTravelTimes_[stopB] - routeTravelTimes_[stopA])
+                {
+                    stopA = lastStopA;
+                    stopB = candidateB;
+                    found = true;
+                }
+            }
+
+            return found;
+        }
+
+        /* The stops of a route served at a station, as a range of
+           `stationStops_` */
+        std::pair<const StationStop*, const StationStop*> FindRouteStops (
+            Handle route,
+            Handle station
+        ) const
+        {
+            const auto* first {stationStops_ + stationStopOffsets_[station]};
+            const auto* last {stationStops_ + stationStopOffsets_[station + 1]};
+            first = std::lower_bound(first, last, route, [](const StationStop& stationStop, Handle value) {
+                return stationStop.route < value;
+            });
+            last = std::upper_bound(first, last, route, [](Handle value, const StationStop& stationStop) {
+                return value < stationStop.route;
+            });
+            return {first, last};
+        }
+    };
+}   /* namespace NetworkMonitor */
+
+#endif  /* NETWORK_GRAPH_VIEW_H */
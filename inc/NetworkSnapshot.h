@@ -0,0 +1,198 @@
+/* @brief: Implement a binary snapshot format for a fully built
+ *         TransportNetwork.
+ *         A snapshot is written once, for example when the network layout
+ *         changes, and then memory-mapped at start-up. Queries are served
+ *         straight from the mapped file, with no parsing.
+ * @note: Snapshots use the byte order of the machine that wrote them.
+ *        Station, line and route handles are the same as in the network the
+ *        snapshot was written from
+ */
+
+#ifndef NETWORK_SNAPSHOT_H
+#define NETWORK_SNAPSHOT_H
+
+#include "MappedFile.h"
+#include "NetworkGraphView.h"
+#include "TransportNetwork.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace NetworkMonitor
+{
+    class NetworkSnapshot
+    {
+    public:
+        /* Snapshot format version. Bump it on any change to the layout */
+        static constexpr std::uint32_t kVersion {3};
+
+        /* Default constructor: an empty snapshot with no stations */
+        NetworkSnapshot();
+
+        /* Destructor: unmap the file */
+        ~NetworkSnapshot();
+
+        /* A snapshot owns its mapping, so it can be moved but not copied */
+        NetworkSnapshot(
+            const NetworkSnapshot& copied
+        ) = delete;
+
+        NetworkSnapshot(
+            NetworkSnapshot&& moved
+        );
+
+        NetworkSnapshot& operator=(
+            const NetworkSnapshot& copied
+        ) = delete;
+
+        NetworkSnapshot& operator=(
+            NetworkSnapshot&& moved
+        );
+
+        /* @brief: Write a snapshot of a network to a file
+         * @return: false if there was an error while writing the file
+         * @note: Live data (passenger counts, crowding penalties, precomputed
+         *        travel times) is not part of the snapshot
+         */
+        static bool Write (
+            const TransportNetwork& nw,
+            const std::filesystem::path& dst
+        );
+
+        /* @brief: Convert a JSON network layout into a snapshot
+         * @return: false if the layout could not be loaded or the snapshot
+         *          could not be written
+         */
+        static bool ConvertLayout (
+            const std::filesystem::path& layout,
+            const std::filesystem::path& dst
+        );
+
+        /* @brief: Memory-map a snapshot file
+         * @return: false if the file cannot be mapped, is not a snapshot, has
+         *          a different version, has an offset or a handle out of
+         *          bounds or, when `verifyChecksum` is set, is corrupted. The
+         *          snapshot is left untouched in that case
+         * @note: The bounds are always checked, so that no query reads outside
+         *        of the mapping. Verifying the checksum also reads the whole
+         *        file once
+         */
+        bool Open (
+            const std::filesystem::path& src,
+            bool verifyChecksum = true
+        );
+
+        /* @brief: Get the number of stations in the snapshot */
+        size_t GetStationCount() const;
+
+        /* @brief: Get the handle of a station, line or route
+         * @return: kInvalidHandle if it is not in the snapshot
+         */
+        StationHandle GetStationHandle (
+            std::string_view station
+        ) const;
+
+        LineHandle GetLineHandle (
+            std::string_view line
+        ) const;
+
+        RouteHandle GetRouteHandle (
+            std::string_view line,
+            std::string_view route
+        ) const;
+
+        /* @brief: Get the ID or name of a station, or the ID of a route
+         * @note: The handle must be valid. The view points into the mapped
+         *        file and is valid as long as the snapshot is open
+         */
+        std::string_view GetStationId (
+            StationHandle station
+        ) const;
+
+        std::string_view GetStationName (
+            StationHandle station
+        ) const;
+
+        std::string_view GetRouteId (
+            RouteHandle route
+        ) const;
+
+        /* @brief: Same as TransportNetwork::GetRoutesServingStation */
+        std::vector<RouteHandle> GetRoutesServingStation (
+            StationHandle station
+        ) const;
+
+        /* @brief: Same as TransportNetwork::GetTravelTime for 2 adjacent
+         *         stations
+         */
+        unsigned int GetTravelTime (
+            StationHandle stationA,
+            StationHandle stationB
+        ) const;
+
+        /* @brief: Same as TransportNetwork::GetTravelTime for 2 stations on
+         *         a route
+         */
+        unsigned int GetTravelTime (
+            RouteHandle route,
+            StationHandle stationA,
+            StationHandle stationB
+        ) const;
+
+    private:
+        /* File records, defined with the file format */
+        struct Header;
+        struct NamedRecord;
+        struct IndexRecord;
+        struct RouteRecord;
+        struct EdgeRecord;
+        struct StationStopRecord;
+        struct RouteStopSlotRecord;
+
+        MappedFile file_ {};
+
+        /* Sections of the mapped file */
+        const Header* header_ {nullptr};
+        const char* strings_ {nullptr};
+        const std::uint32_t* stringOffsets_ {nullptr};
+        const NamedRecord* stations_ {nullptr};
+        const IndexRecord* stationIndex_ {nullptr};
+        const NamedRecord* lines_ {nullptr};
+        const IndexRecord* lineIndex_ {nullptr};
+        const RouteRecord* routes_ {nullptr};
+        const IndexRecord* routeIndex_ {nullptr};
+        const std::uint32_t* routeStops_ {nullptr};
+        const std::uint32_t* routeTravelTimes_ {nullptr};
+        const std::uint32_t* edgeOffsets_ {nullptr};
+        const EdgeRecord* edges_ {nullptr};
+        const std::uint32_t* stationStopOffsets_ {nullptr};
+        const StationStopRecord* stationStops_ {nullptr};
+        const std::uint32_t* routeStopSlotOffsets_ {nullptr};
+        const RouteStopSlotRecord* routeStopSlots_ {nullptr};
+
+        /* Get a string from the string table */
+        std::string_view GetString (
+            std::uint32_t string
+        ) const;
+
+        /* Binary search an ID in an index sorted by ID */
+        Handle FindId (
+            const IndexRecord* index,
+            size_t nRecords,
+            std::string_view id
+        ) const;
+
+        /* View of the compressed-sparse-row graph, shared with
+           TransportNetwork to answer travel time queries */
+        NetworkGraphView<std::uint32_t, EdgeRecord, StationStopRecord, std::uint32_t,
+                         RouteStopSlotRecord> GetGraphView() const;
+
+        /* Unmap the file and reset all sections */
+        void Close();
+    };
+}   /* namespace NetworkMonitor */
+
+#endif  /* NETWORK_SNAPSHOT_H */
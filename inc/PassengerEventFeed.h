@@ -0,0 +1,49 @@
+/* @brief: Connect the passenger events feed to the ingestion pipeline.
+ *         The bodies of the STOMP MESSAGE frames of a subscription are pushed
+ *         into a PassengerEventPipeline, and the messages lost while the
+ *         client reconnected are recorded as a gap.
+ */
+
+#ifndef PASSENGER_EVENT_FEED_H
+#define PASSENGER_EVENT_FEED_H
+
+#include "PassengerEventPipeline.h"
+#include "StompClient.h"
+#include "StompFrame.h"
+
+#include <boost/system/error_code.hpp>
+
+#include <functional>
+#include <string>
+
+namespace NetworkMonitor
+{
+    /* @brief: Make a subscription message callback that feeds a pipeline
+     *         Each MESSAGE body is pushed as it is.
+     *         StompClientError::MessageGap, which the client passes after a
+     *         reconnection, is recorded with RecordGap. Other errors carry no
+     *         event and are ignored
+     * @note: The pipeline must outlive the subscription
+     */
+    std::function<void (boost::system::error_code, const StompFrame&)> MakePassengerEventHandler (
+        PassengerEventPipeline& pipeline
+    );
+
+    /* @brief: Subscribe to the passenger events and feed them into a pipeline
+     *         The subscription acknowledges messages automatically: the
+     *         pipeline counts the events it drops, and an acknowledgement
+     *         could not bring them back
+     * @return: The subscription ID
+     * @note: Call it from the client callbacks, like StompClient::Subscribe.
+     *        Enable reconnections on the client to have the subscription
+     *        renewed and the lost messages recorded as a gap
+     */
+    std::string SubscribePassengerEvents (
+        StompClient& client,
+        PassengerEventPipeline& pipeline,
+        const std::string& destination = "/passengers",
+        std::function<void (boost::system::error_code, std::string&&)> onSubscribe = nullptr
+    );
+}   /* namespace NetworkMonitor */
+
+#endif  /* PASSENGER_EVENT_FEED_H */
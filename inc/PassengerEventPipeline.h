@@ -0,0 +1,246 @@
+/* @brief: Implement the passenger event ingestion pipeline.
+ *         The receive side (e.g. the StompClient message callback, on the
+ *         WebSocket strand, see PassengerEventFeed.h) pushes raw JSON
+ *         passenger events into a bounded lock-free ring. A pool of worker
+ *         threads pops them, parses them into PassengerEvent objects and
+ *         records them on the network in batches.
+ */
+
+#ifndef PASSENGER_EVENT_PIPELINE_H
+#define PASSENGER_EVENT_PIPELINE_H
+
+#include "BoundedRing.h"
+#include "TransportNetwork.h"
+#include "VersionedTransportNetwork.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace NetworkMonitor
+{
+    /* What Push does when the ring is full */
+    enum class FullRingPolicy
+    {
+        /* Wait for a worker to make room. This stalls the receive side, and
+           only makes sense once the workers are started */
+        Block,
+
+        /* Drop the oldest queued event to make room for the new one */
+        DropOldest,
+
+        /* Drop the new event */
+        CountAndDrop,
+    };
+
+    /* @brief: Pipeline settings
+     * @member:
+     *         - `ringCapacity` number of queued events, rounded up to a power
+     *           of 2
+     *         - `nWorkers` number of parsing threads
+     *         - `batchSize` maximum number of events recorded at once
+     *         - `idleWait` how long an idle worker sleeps before polling the
+     *           ring again
+     */
+    struct IngestionOptions
+    {
+        size_t ringCapacity {4096};
+        unsigned int nWorkers {2};
+        size_t batchSize {64};
+        FullRingPolicy fullRingPolicy {FullRingPolicy::Block};
+        std::chrono::microseconds idleWait {100};
+    };
+
+    /* Latency of a pipeline stage */
+    struct StageLatency
+    {
+        std::uint64_t count {0};
+        std::uint64_t totalNs {0};
+        std::uint64_t maxNs {0};
+    };
+
+    /* @brief: Pipeline counters
+     * @member:
+     *         - `gaps` number of times the feed reported lost events, see
+     *           RecordGap
+     *         - `queueLatency` time an event spent in the ring
+     *         - `parseLatency` time to parse a batch
+     *         - `applyLatency` time to record a batch on the network
+     */
+    struct IngestionStats
+    {
+        std::uint64_t received {0};
+        std::uint64_t dropped {0};
+        std::uint64_t parseErrors {0};
+        std::uint64_t applied {0};
+        std::uint64_t rejected {0};
+        std::uint64_t gaps {0};
+        size_t queueDepth {0};
+        size_t maxQueueDepth {0};
+        StageLatency queueLatency {};
+        StageLatency parseLatency {};
+        StageLatency applyLatency {};
+    };
+
+    class PassengerEventPipeline
+    {
+    public:
+        /* Where parsed events go. Return the number of rejected events */
+        using Sink = std::function<size_t (const PassengerEvent*, size_t)>;
+
+        PassengerEventPipeline (
+            TransportNetwork& network,
+            const IngestionOptions& options = {}
+        );
+
+        /* @brief: Record events on the current version of the network */
+        PassengerEventPipeline (
+            VersionedTransportNetwork& network,
+            const IngestionOptions& options = {}
+        );
+
+        PassengerEventPipeline (
+            Sink sink,
+            const IngestionOptions& options = {}
+        );
+
+        /* @brief: Stop the workers, see Stop */
+        ~PassengerEventPipeline();
+
+        PassengerEventPipeline (
+            const PassengerEventPipeline& copied
+        ) = delete;
+
+        PassengerEventPipeline& operator= (
+            const PassengerEventPipeline& copied
+        ) = delete;
+
+        /* @brief: Start the worker threads */
+        void Start();
+
+        /* @brief: Stop accepting events, process the queued ones and join the
+         *         worker threads
+         */
+        void Stop();
+
+        /* @brief: Queue a JSON passenger event, e.g. the body of a STOMP
+         *         MESSAGE frame
+         * @return: false if the event was dropped. Under DropOldest the new
+         *          event is always queued, but an older one may be dropped
+         * @note: Can be called from multiple threads
+         */
+        bool Push (
+            std::string_view event
+        );
+
+        /* @brief: Record that the feed lost events, e.g. on a
+         *         StompClientError::MessageGap after a reconnection. The
+         *         passenger counts drift by the lost events
+         * @note: Can be called from multiple threads
+         */
+        void RecordGap();
+
+        /* @brief: Get a snapshot of the pipeline counters */
+        IngestionStats GetStats() const;
+
+    private:
+        struct RawEvent
+        {
+            std::string payload {};
+            std::int64_t enqueuedNs {0};
+        };
+
+        struct AtomicLatency
+        {
+            std::atomic<std::uint64_t> count {0};
+            std::atomic<std::uint64_t> totalNs {0};
+            std::atomic<std::uint64_t> maxNs {0};
+
+            void Add (
+                std::uint64_t count,
+                std::uint64_t totalNs,
+                std::uint64_t maxNs
+            );
+
+            StageLatency Load() const;
+        };
+
+        IngestionOptions options_ {};
+        Sink sink_ {};
+        BoundedRing<RawEvent> ring_;
+
+        std::vector<std::thread> workers_ {};
+        std::atomic<bool> running_ {false};
+        std::atomic<bool> stopping_ {false};
+
+        /* Push calls in progress, which Stop waits for */
+        std::atomic<unsigned int> pushing_ {0};
+
+        std::atomic<std::uint64_t> received_ {0};
+        std::atomic<std::uint64_t> dropped_ {0};
+        std::atomic<std::uint64_t> parseErrors_ {0};
+        std::atomic<std::uint64_t> applied_ {0};
+        std::atomic<std::uint64_t> rejected_ {0};
+        std::atomic<std::uint64_t> gaps_ {0};
+        std::atomic<size_t> maxQueueDepth_ {0};
+        AtomicLatency queueLatency_ {};
+        AtomicLatency parseLatency_ {};
+        AtomicLatency applyLatency_ {};
+
+        /* Queue an event under the full ring policy
+           Return false if the event was dropped */
+        bool Enqueue (
+            std::string_view event
+        );
+
+        void RunWorker();
+
+        /* Parse and record a batch. Return false if the batch was empty */
+        bool ProcessBatch (
+            std::vector<RawEvent>& raw,
+            std::vector<PassengerEvent>& events
+        );
+    };
+
+    /* @brief: Generate random JSON passenger events, in the format of the
+     *         network events feed, for tests and benchmarks
+     */
+    class PassengerEventGenerator
+    {
+    public:
+        PassengerEventGenerator (
+            std::vector<Id> stations,
+            unsigned int seed = 0
+        );
+
+        /* @brief: Generate the next event
+         * @return: The JSON event. The view is valid until the next call
+         * @note: `event` receives the generated event, to check the results
+         */
+        std::string_view Next (
+            PassengerEvent& event
+        );
+
+    private:
+        std::vector<Id> stations_ {};
+        std::mt19937 rng_;
+        std::string buffer_ {};
+    };
+
+    /* @brief: Parse a JSON passenger event
+     * @return: false if the event is not valid JSON or misses a field
+     */
+    bool ParsePassengerEvent (
+        std::string_view json,
+        PassengerEvent& event
+    );
+}   /* namespace NetworkMonitor */
+
+#endif  /* PASSENGER_EVENT_PIPELINE_H */
@@ -0,0 +1,202 @@
+/* @brief: Implement a STOMP 1.2 client on top of the WebSocketClient.
+ *         The client connects with credentials, subscribes to destinations,
+ *         acknowledges messages and disconnects. Incoming frames are parsed
+ *         in place from the WebSocket read buffer.
+ */
+
+#ifndef STOMP_CLIENT_H
+#define STOMP_CLIENT_H
+
+#include "StompFrame.h"
+#include "WebSocketClient.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace NetworkMonitor
+{
+    /* STOMP client errors, on top of the WebSocket errors */
+    enum class StompClientError
+    {
+        Ok = 0,
+        CouldNotParseFrame,
+        ConnectRejected,
+        ServerError,
+        UnexpectedFrame,
+
+        /* Passed to the subscription message callback after a reconnection:
+           messages sent while the connection was down are lost */
+        MessageGap,
+    };
+
+    /* @brief: Get the error category of StompClientError codes */
+    const boost::system::error_category& GetStompClientErrorCategory();
+
+    boost::system::error_code make_error_code (
+        StompClientError error
+    );
+
+    /* Acknowledgement modes of a subscription */
+    enum class StompAckMode
+    {
+        Auto,
+        Client,
+        ClientIndividual,
+    };
+
+    class StompClient
+    {
+    public:
+        StompClient (
+            const std::string& url,
+            const std::string& endpoint,
+            const std::string& port,
+            boost::asio::io_context& ioc,
+            boost::asio::ssl::context& ctx,
+            const SendQueueOptions& sendOptions = {},
+            const StreamOptions& streamOptions = {}
+        );
+
+        /* @brief: Connect to the WebSocket server and open a STOMP session
+         *         `onConnect` runs once the server replied with CONNECTED, or
+         *         with the error that prevented the session
+         *         (StompClientError::ConnectRejected if the server replied
+         *         with an ERROR frame)
+         * @note: `onDisconnect` runs when the connection drops, when the
+         *        server sends an ERROR frame during the session, or when a
+         *        reconnection fails (see SetReconnectOptions)
+         */
+        void Connect (
+            const std::string& username,
+            const std::string& password,
+            std::function<void (boost::system::error_code)> onConnect = nullptr,
+            std::function<void (boost::system::error_code)> onDisconnect = nullptr
+        );
+
+        /* @brief: Subscribe to a destination
+         *         `onSubscribe` runs when the server acknowledged the
+         *         subscription with a RECEIPT frame. `onMessage` runs for each
+         *         MESSAGE frame of the subscription; the frame views are only
+         *         valid during the callback
+         * @return: The subscription ID
+         * @note: Call it from the client callbacks, e.g. from `onConnect`:
+         *        subscriptions are only touched on the WebSocket strand
+         */
+        std::string Subscribe (
+            const std::string& destination,
+            StompAckMode ackMode,
+            std::function<void (boost::system::error_code, std::string&&)> onSubscribe = nullptr,
+            std::function<void (boost::system::error_code, const StompFrame&)> onMessage = nullptr
+        );
+
+        /* @brief: Reconnect when the connection drops, see
+         *         WebSocketClient::SetReconnectOptions
+         *         After a reconnection the client logs in again and renews
+         *         the subscriptions. Their `onMessage` callbacks first receive
+         *         StompClientError::MessageGap with an empty frame, so that
+         *         the consumer can account for the lost messages. `onConnect`
+         *         and `onSubscribe` do not run again: if the client gives up
+         *         reconnecting, or cannot log in again, `onDisconnect` runs
+         *         with the error
+         * @note: Call it before connecting
+         */
+        void SetReconnectOptions (
+            const ReconnectOptions& options
+        );
+
+        /* @brief: Get the WebSocket connection counters */
+        WebSocketClientMetrics GetMetrics() const;
+
+        /* @brief: Acknowledge a message
+         * @note: `ackId` is the `ack` header of the MESSAGE frame
+         */
+        void Ack (
+            std::string_view ackId,
+            std::function<void (boost::system::error_code)> onAck = nullptr
+        );
+
+        /* @brief: Send a DISCONNECT frame and close the WebSocket connection */
+        void Close (
+            std::function<void (boost::system::error_code)> onClose = nullptr
+        );
+
+    private:
+        struct Subscription
+        {
+            std::string destination {};
+            StompAckMode ackMode {StompAckMode::Auto};
+            std::function<void (boost::system::error_code, std::string&&)> onSubscribe {nullptr};
+            std::function<void (boost::system::error_code, const StompFrame&)> onMessage {nullptr};
+        };
+
+        std::string url_ {};
+        WebSocketClient ws_;
+
+        std::string username_ {};
+        std::string password_ {};
+        bool connected_ {false};
+        bool hasConnected_ {false};
+
+        /* Indexed by subscription ID */
+        std::vector<Subscription> subscriptions_ {};
+
+        /* Reused for every incoming frame */
+        StompFrame frame_ {};
+
+        std::function<void (boost::system::error_code)> onConnect_ {nullptr};
+        std::function<void (boost::system::error_code)> onDisconnect_ {nullptr};
+
+        void OnWsConnect (
+            const boost::system::error_code& ec
+        );
+
+        void OnWsMessage (
+            const boost::system::error_code& ec,
+            std::string_view message
+        );
+
+        /* Report a STOMP session that could not be opened: to `onConnect` for
+           the first session, to `onDisconnect` after a reconnection */
+        void OnSessionFailed (
+            const boost::system::error_code& ec
+        );
+
+        void OnFrame (
+            const StompFrame& frame
+        );
+
+        /* Send the SUBSCRIBE frame of a subscription */
+        void SendSubscribe (
+            const std::string& id,
+            bool withReceipt
+        );
+
+        /* Look up a subscription from a frame header holding its ID
+           Return nullptr if there is no such subscription */
+        Subscription* FindSubscription (
+            std::string_view id
+        );
+
+        void SendFrame (
+            std::string frame,
+            std::function<void (boost::system::error_code)> onSend = nullptr
+        );
+    };
+}   /* namespace NetworkMonitor */
+
+namespace boost::system
+{
+    template <>
+    struct is_error_code_enum<NetworkMonitor::StompClientError>: std::true_type
+    {
+    };
+}   /* namespace boost::system */
+
+#endif  /* STOMP_CLIENT_H */
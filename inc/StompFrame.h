@@ -0,0 +1,157 @@
+/* @brief: Implement a STOMP 1.2 frame parser and serializer.
+ *         The parser tokenises a frame into views over the input: command,
+ *         headers and body are never copied and parsing never allocates.
+ *         The serializer writes frames into a caller-owned buffer that keeps
+ *         its capacity across frames.
+ * @note: Header values are returned as they appear on the wire. We do not
+ *        undo the STOMP 1.2 header escapes (\n, \c, \\), which the network
+ *        events feed does not use
+ */
+
+#ifndef STOMP_FRAME_H
+#define STOMP_FRAME_H
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace NetworkMonitor
+{
+    /* STOMP frame commands, client and server */
+    enum class StompCommand
+    {
+        Abort,
+        Ack,
+        Begin,
+        Commit,
+        Connect,
+        Connected,
+        Disconnect,
+        Error,
+        Message,
+        Nack,
+        Receipt,
+        Send,
+        Stomp,
+        Subscribe,
+        Unsubscribe,
+    };
+
+    /* Parsing errors */
+    enum class StompError
+    {
+        Ok,
+        EmptyFrame,
+        UndefinedCommand,
+        MissingCommandEol,
+        MissingHeaderSeparator,
+        EmptyHeaderName,
+        TooManyHeaders,
+        MissingBodyEol,
+        InvalidContentLength,
+        MissingNullTerminator,
+    };
+
+    struct StompHeader
+    {
+        std::string_view name {};
+        std::string_view value {};
+    };
+
+    /* @brief: Get the wire representation of a command, e.g. "CONNECT" */
+    std::string_view ToString (
+        StompCommand command
+    );
+
+    std::string_view ToString (
+        StompError error
+    );
+
+    std::ostream& operator<< (
+        std::ostream& os,
+        StompCommand command
+    );
+
+    std::ostream& operator<< (
+        std::ostream& os,
+        StompError error
+    );
+
+    class StompFrame
+    {
+    public:
+        /* Maximum number of headers in a frame. Frames with more headers are
+           rejected, so that parsing does not need to allocate */
+        static constexpr size_t kMaxHeaders {32};
+
+        /* @brief: Parse the first frame of `data`
+         *         The frame ends at its NULL octet, or after `content-length`
+         *         body octets when the header is present. End-of-line octets
+         *         that follow the frame (heart-beats) are skipped
+         * @return: StompError::Ok on success. On failure the frame is empty
+         * @note: The frame views point into `data`, which must outlive them.
+         *        GetSize() tells where the next frame starts
+         */
+        StompError Parse (
+            std::string_view data
+        );
+
+        /* @brief: Get the number of input octets taken by the parsed frame,
+         *         including its NULL octet and trailing end-of-lines
+         */
+        size_t GetSize() const;
+
+        StompCommand GetCommand() const;
+
+        /* @brief: Get the value of a header
+         * @return: An empty view if the header is not in the frame. If a
+         *          header is repeated, the first occurrence wins
+         */
+        std::string_view GetHeaderValue (
+            std::string_view name
+        ) const;
+
+        bool HasHeader (
+            std::string_view name
+        ) const;
+
+        /* @brief: Get the headers in the order they appear in the frame */
+        size_t GetHeaderCount() const;
+
+        const StompHeader& GetHeader (
+            size_t idx
+        ) const;
+
+        std::string_view GetBody() const;
+
+    private:
+        StompCommand command_ {StompCommand::Error};
+        std::array<StompHeader, kMaxHeaders> headers_ {};
+        size_t nHeaders_ {0};
+        std::string_view body_ {};
+        size_t size_ {0};
+
+        StompError Fail (
+            StompError error
+        );
+    };
+
+    /* @brief: Serialize a frame into `buffer`
+     *         The buffer is cleared first. Its capacity is kept, so reusing the
+     *         same buffer does not allocate once it is large enough.
+     *         A `content-length` header is added when the body is not empty
+     * @note: Header names and values are written as-is, see the file note on
+     *        escapes
+     */
+    void SerializeStompFrame (
+        std::string& buffer,
+        StompCommand command,
+        std::initializer_list<StompHeader> headers,
+        std::string_view body = {}
+    );
+}   /* namespace NetworkMonitor */
+
+#endif  /* STOMP_FRAME_H */
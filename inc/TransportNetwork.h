@@ -1,15 +1,76 @@
 #ifndef TRANSPORT_NETWORK_H
 #define TRANSPORT_NETWORK_H
 
+#include "IdTable.h"
+#include "NetworkGraphView.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <limits>
 #include <string>
 #include <vector>
-#include <memory>
-#include <unordered_map>
 
 namespace NetworkMonitor
 {
 using Id = std::string;
 
+/* Interned handles of stations, lines and routes
+   Get them once with TransportNetwork::GetStationHandle/GetLineHandle/
+   GetRouteHandle and use the handle-based overloads on hot paths */
+using StationHandle = Handle;
+using LineHandle = Handle;
+using RouteHandle = Handle;
+
+/* @brief: Read-only view over an array of handles
+ *         A C++17 stand-in for std::span<const Handle>
+ */
+class HandleSpan
+{
+public:
+    HandleSpan() = default;
+
+    HandleSpan(
+        const Handle* data,
+        size_t size
+    ) : data_ {data},
+        size_ {size}
+    {}
+
+    const Handle* begin() const
+    {
+        return data_;
+    }
+
+    const Handle* end() const
+    {
+        return data_ + size_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    Handle operator[](
+        size_t idx
+    ) const
+    {
+        return data_[idx];
+    }
+
+private:
+    const Handle* data_ {nullptr};
+    size_t size_ {0};
+};
+
 /* @brief: Network station
  *         A Station struct is well formed if
  * @member:
@@ -83,11 +144,82 @@ struct PassengerEvent
     Type type {Type::In};
 };
 
+/* @brief: Change of the passenger count at a station
+ *         This is a passenger event with the station already resolved to
+ *         its handle. Several events at the same station can be combined
+ *         into a single delta
+ */
+struct PassengerDelta
+{
+    StationHandle station {kInvalidHandle};
+    long long int delta {0};
+};
+
+/* @brief: Itinerary leg
+ *         Ride `route` of `line` from `boardStation` to `alightStation`
+ */
+struct ItineraryLeg
+{
+    LineHandle line {kInvalidHandle};
+    RouteHandle route {kInvalidHandle};
+    StationHandle boardStation {kInvalidHandle};
+    StationHandle alightStation {kInvalidHandle};
+    unsigned int travelTime {0};
+};
+
+/* @brief: Itinerary between two stations
+ * @member:
+ *         - `legs` ordered legs of the trip. Empty if the trip starts and
+ *           ends at the same station
+ *         - `travelTime` total time spent on board
+ *         - `cost` the cost that was minimized: travel time plus penalties
+ */
+struct Itinerary
+{
+    std::vector<ItineraryLeg> legs {};
+    unsigned int travelTime {0};
+    unsigned int cost {0};
+};
+
+/* @brief: Itinerary search options
+ * @member:
+ *         - `lineChangePenalty` cost added each time the trip changes line.
+ *           Changing route on the same line is free
+ *         - `avoidCrowding` add the crowding penalty of each station the trip
+ *           rides into, see CrowdingModel
+ */
+struct ItineraryOptions
+{
+    unsigned int lineChangePenalty {0};
+    bool avoidCrowding {false};
+};
+
+/* @brief: Crowding cost model
+ *         A station with more than `threshold` passengers costs one extra unit
+ *         of travel time for every `passengersPerUnit` passengers above the
+ *         threshold, up to `maxPenalty`
+ * @member:
+ *         - `passengersPerUnit` 0 disables the crowding penalty
+ */
+struct CrowdingModel
+{
+    long long int threshold {0};
+    long long int passengersPerUnit {0};
+    unsigned int maxPenalty {0};
+};
+
 /* @brief: Underground network representation
+ * @note: Recording passenger events and reading passenger counts is
+ *        thread-safe, also concurrently with the other const queries.
+ *        Changing the network (adding stations and lines, setting travel
+ *        times) must not run concurrently with anything else
  */
 class TransportNetwork
 {
 public:
+    /* Travel time between two stations with no path between them */
+    static constexpr unsigned int kUnreachable {std::numeric_limits<unsigned int>::max()};
+
     /* Default constructor */
     TransportNetwork();
 
@@ -111,7 +243,7 @@ public:
 
     /* Move assignment operator */
     TransportNetwork& operator=(
-        const TransportNetwork&& moved
+        TransportNetwork&& moved
     );
 
     /* @brief: Add a station to the network
@@ -135,14 +267,61 @@ public:
         const Line& line
     );
 
+    /* @brief: Load the network from a JSON network layout
+     *         The `stations`, `lines` and `travel_times` sections are read in
+     *         one pass with a SAX parser, without building the JSON document
+     *         in memory
+     * @return: false if the layout is not valid JSON or does not describe a
+     *          valid network. The network is left untouched in that case
+     * @note: On success, the loaded layout replaces the current network
+     */
+    bool FromJson(
+        std::istream& layout
+    );
+
+    bool FromJson(
+        const std::filesystem::path& src
+    );
+
     /* @brief: Record a passenger event at a station
      * @return: false if the station is not in the network or if the passenger
      *          event is not reconized
+     * @note: Can be called concurrently from multiple threads without locking
      */
     bool RecordPassengerEvent(
         const PassengerEvent& event
     );
 
+    /* @brief: Record a passenger event at a station, by handle
+     * @return: false if the station is not in the network or if the passenger
+     *          event is not reconized
+     */
+    bool RecordPassengerEvent(
+        StationHandle station,
+        PassengerEvent::Type type
+    );
+
+    /* @brief: Record a burst of passenger events
+     *         Events are bucketed by station and each station counter is
+     *         updated once with the combined delta
+     * @return: The number of events that were rejected because the station is
+     *          not in the network or the passenger event is not recognized
+     * @note: Can be called concurrently from multiple threads without locking
+     */
+    size_t RecordPassengerEvents(
+        const PassengerEvent* events,
+        size_t nEvents
+    );
+
+    /* @brief: Record a burst of pre-resolved passenger count changes
+     * @return: The number of deltas that were rejected because the station
+     *          handle is invalid
+     */
+    size_t RecordPassengerEvents(
+        const PassengerDelta* deltas,
+        size_t nDeltas
+    );
+
     /* @brief: Get the number of passengers currently recorded at a station
      * @return: The returned number can be negative. (This happens if we start recording
      *          in the middle of the day and we record more exiting than entering
@@ -152,6 +331,13 @@ public:
         const Id& station
     ) const;
 
+    /* @brief: Get the number of passengers currently recorded at a station,
+     *         by handle
+     */
+    long long int GetPassengerCount(
+        StationHandle station
+    ) const;
+
     /* @brief: Get list of routes serving a given station
      * @return: An empty vector if there was an error getting the list of
      *          routes serving the station, or if the station has legitimately
@@ -162,6 +348,25 @@ public:
         const Id& station
     ) const;
 
+    /* @brief: Get list of routes serving a given station, by handle
+     */
+    std::vector<RouteHandle> GetRoutesServingStation(
+        StationHandle station
+    ) const;
+
+    /* @brief: Get the routes serving a given station, without allocating
+     * @return: The route handles in increasing order, each listed once.
+     *          Empty if the station is not in the network
+     * @note: The view is valid until the network changes
+     */
+    HandleSpan GetRoutesServingStationView(
+        const Id& station
+    ) const;
+
+    HandleSpan GetRoutesServingStationView(
+        StationHandle station
+    ) const;
+
     /* @brief: Set the travel time between 2 adjacent stations
      * @return: false if there was an error while setting the travel time
      *          between the two stations
@@ -204,80 +409,341 @@ public:
         const Id& stationB
     ) const;
 
+    /* @brief: Get the travel time between 2 adjacent stations, by handle
+     */
+    unsigned int GetTravelTime(
+        StationHandle stationA,
+        StationHandle stationB
+    ) const;
+
+    /* @brief: Get the total travel time between any 2 stations on a specific
+     *         route, by handle
+     * @note: A route handle already identifies its line. Constant time, see
+     *        NetworkGraphView
+     */
+    unsigned int GetTravelTime(
+        RouteHandle route,
+        StationHandle stationA,
+        StationHandle stationB
+    ) const;
+
+    /* @brief: Find the fastest itinerary between two stations
+     *         Run a Dijkstra search over the route stops. Riding a route costs
+     *         its travel time, changing line costs the line change penalty.
+     *         When avoiding crowding, riding into a station also costs its
+     *         cached crowding penalty
+     * @return: false if there is no itinerary between the two stations or if
+     *          a station is not in the network
+     * @note: The search uses per-thread scratch buffers and fills the legs of
+     *        `itinerary` in place, so reusing the same `itinerary` object
+     *        across queries does not allocate.
+     *        Can be called concurrently from multiple threads
+     */
+    bool GetFastestItinerary(
+        StationHandle from,
+        StationHandle to,
+        Itinerary& itinerary,
+        const ItineraryOptions& options = {}
+    ) const;
+
+    /* @brief: Find the fastest itinerary between two stations, by ID
+     * @return: An itinerary with no legs and zero cost if there is no
+     *          itinerary between the two stations
+     */
+    Itinerary GetFastestItinerary(
+        const Id& from,
+        const Id& to,
+        const ItineraryOptions& options = {}
+    ) const;
+
+    /* @brief: Precompute the shortest travel time between all pairs of
+     *         stations
+     *         Run one Dijkstra search per origin station, spread across
+     *         `nThreads` threads (0 uses up to all hardware threads, fewer
+     *         on small networks). The result is a dense station-by-station
+     *         matrix, so it is meant for networks of up to a few thousand
+     *         stations.
+     *         SetTravelTime repairs the affected entries of the matrix.
+     *         Adding stations or lines discards it
+     * @note: This is a network change, it must not run concurrently with
+     *        anything else
+     */
+    void PrecomputeTravelTimes(
+        unsigned int nThreads = 0
+    );
+
+    /* @brief: Get the precomputed shortest travel time between 2 stations
+     * @return: kUnreachable if there is no path between the stations, if a
+     *          station is not in the network or if the travel times have not
+     *          been precomputed
+     */
+    unsigned int GetShortestTravelTime(
+        StationHandle from,
+        StationHandle to
+    ) const;
+
+    /* @brief: Set the crowding cost model used by itinerary searches that
+     *         avoid crowding
+     * @note: The penalty of each station is cached and refreshed every time
+     *        its passenger count changes. Setting the model refreshes all of
+     *        them, so it must not run concurrently with anything else
+     */
+    void SetCrowdingModel(
+        const CrowdingModel& model
+    );
+
+    /* @brief: Get the crowding cost model */
+    const CrowdingModel& GetCrowdingModel() const;
+
+    /* @brief: Get the cached crowding penalty of a station
+     * @return: 0 if the station is not in the network
+     */
+    unsigned int GetCrowdingPenalty(
+        StationHandle station
+    ) const;
+
+    /* @brief: Get the number of stations in the network
+     * @note: Station handles go from 0 to the number of stations minus 1
+     */
+    size_t GetStationCount() const;
+
+    /* @brief: Get the handle of a station
+     * @return: kInvalidHandle if the station is not in the network
+     */
+    StationHandle GetStationHandle(
+        const Id& station
+    ) const;
+
+    /* @brief: Get the handle of a line
+     * @return: kInvalidHandle if the line is not in the network
+     */
+    LineHandle GetLineHandle(
+        const Id& line
+    ) const;
+
+    /* @brief: Get the handle of a line route
+     * @return: kInvalidHandle if the route is not in the network or if it
+     *          does not belong to the line
+     */
+    RouteHandle GetRouteHandle(
+        const Id& line,
+        const Id& route
+    ) const;
+
+    /* @brief: Get the ID of a station, line or route handle
+     * @note: The handle must be valid
+     */
+    const Id& GetStationId(
+        StationHandle station
+    ) const;
+
+    const Id& GetLineId(
+        LineHandle line
+    ) const;
+
+    const Id& GetRouteId(
+        RouteHandle route
+    ) const;
+
 private:
-    /* Forward-declare all internal structs */
-    struct GraphNode;
-    struct GraphEdge;
-    struct RouteInternal;
-    struct LineInternal;
-
-    /* Graph node
-       We use this as the internal station representation */
-    struct GraphNode
+    /* SAX handler used by FromJson */
+    class NetworkLayoutHandler;
+
+    /* Snapshots are written straight from the internal arrays */
+    friend class NetworkSnapshot;
+
+    /* Dense index of a station, line or route in the internal arrays.
+       The index of an entity is its interned handle. IDs are only hashed at
+       the API boundary, everything behind it works on indices */
+    using Index = Handle;
+
+    /* Internal station representation */
+    struct StationInternal
     {
-        Id id {};
         std::string name {};
-        long long int passengerCount {0};
-        std::vector<std::shared_ptr<GraphEdge>> edges {};
+    };
+
+    /* Passenger counter of a station, with its cached crowding penalty
+       Each counter sits on its own cache line, so that threads recording
+       events at different stations do not invalidate each other's lines */
+    static constexpr std::size_t kCacheLineSize {64};
+    struct alignas(kCacheLineSize) PassengerCounter
+    {
+        std::atomic<std::int64_t> count {0};
+        std::atomic<unsigned int> penalty {0};
+
+        PassengerCounter() = default;
 
-        /* Find the edge for a specific line route */
-        std::vector<std::shared_ptr<GraphEdge>>::const_iterator FindEdgeForRoute(
-            const std::shared_ptr<RouteInternal>& route
-        ) const;
+        /* Copying is only used when copying or growing the network, which
+           does not run concurrently with event recording */
+        PassengerCounter(
+            const PassengerCounter& copied
+        );
+
+        PassengerCounter& operator=(
+            const PassengerCounter& copied
+        );
     };
-    
+
     /* Graph edge
        We keep one edge for each route going through a node, even if multiple
-       routes go through the same node */
+       routes go through the same node.
+       Edges are stored in compressed-sparse-row form: the outgoing edges of
+       station `s` are `edges_[edgeOffsets_[s]]` to `edges_[edgeOffsets_[s + 1] - 1]`.
+       `stop` is the position of the departure stop in `routeStops_`: a loop
+       route stops more than once at a station, so the station alone does not
+       tell which stop the edge leaves from */
     struct GraphEdge
     {
-        std::shared_ptr<RouteInternal> route {nullptr};
-        std::shared_ptr<GraphNode> nextStop {nullptr};
+        Index nextStop {kInvalidHandle};
+        Index route {kInvalidHandle};
+        Index stop {kInvalidHandle};
         unsigned int travelTime {0};
     };
 
-    /* Internal route representation */
+    /* Internal route representation
+       The route stops are `routeStops_[firstStop]` to
+       `routeStops_[firstStop + nStops - 1]` */
     struct RouteInternal
     {
-        Id id {};
-        std::shared_ptr<LineInternal> line {nullptr};
-        std::shared_ptr<GraphNode> stops {nullptr};
+        Index line {kInvalidHandle};
+        Index firstStop {0};
+        Index nStops {0};
     };
 
-    /* Internal line representation
-       We map line routes by their ID */
+    /* Route stop served at a station
+       `stop` is the position of the stop in `routeStops_` */
+    struct StationStop
+    {
+        Index route {kInvalidHandle};
+        Index stop {kInvalidHandle};
+    };
+
+    /* Slot of a route stop position table, see NetworkGraphView
+       `stop` is the position of the stop in `routeStops_` */
+    struct RouteStopSlot
+    {
+        Index station {kInvalidHandle};
+        Index stop {kInvalidHandle};
+    };
+
+    /* Internal line representation */
     struct LineInternal
     {
-        Id id {};
         std::string name {};
-        std::unordered_map<Id, std::shared_ptr<RouteInternal>> routes {};
+        std::vector<Index> routes {};
     };
 
-    /* Map station and lines by ID. We do not map line routes here, as they
-       are mapped within each line representation */
-    std::unordered_map<Id, std::shared_ptr<GraphNode>> stations_ {};
-    std::unordered_map<Id, std::shared_ptr<LineInternal>> lines_ {};
+    /* Dense storage, indexed by station/line/route index */
+    std::vector<StationInternal> stations_ {};
+    std::vector<PassengerCounter> passengerCounts_ {};
+    CrowdingModel crowdingModel_ {};
+    std::vector<LineInternal> lines_ {};
+    std::vector<RouteInternal> routes_ {};
+    std::vector<Index> routeStops_ {};
+
+    /* Cumulative travel time from the start of the route to each stop,
+       aligned with `routeStops_`. The travel time between two stops of a
+       route is the difference of their entries */
+    std::vector<unsigned int> routeTravelTimes_ {};
+
+    /* Route of each stop, aligned with `routeStops_` */
+    std::vector<Index> stopRoutes_ {};
+
+    /* Position of the stop of each route at each of its stations, as one
+       hash table per route in compressed-sparse-row form. Route stops never
+       change, so the tables are only built for new routes */
+    std::vector<Index> routeStopSlotOffsets_ {0};
+    std::vector<RouteStopSlot> routeStopSlots_ {};
+
+    /* Adjacency in compressed-sparse-row form
+       `edgeOffsets_` has one entry per station plus a final sentinel */
+    std::vector<Index> edgeOffsets_ {0};
+    std::vector<GraphEdge> edges_ {};
+
+    /* Route stops served at each station, in compressed-sparse-row form
+       Unlike the edges, this includes the last stop of each route */
+    std::vector<Index> stationStopOffsets_ {0};
+    std::vector<StationStop> stationStops_ {};
+
+    /* Routes serving each station, in compressed-sparse-row form, sorted
+       and without duplicates */
+    std::vector<Index> stationRouteOffsets_ {0};
+    std::vector<Index> stationRoutes_ {};
+
+    /* Intern station, line and route IDs into their index. Route IDs are
+       unique across all lines, so we intern them globally */
+    IdTable stationIds_ {};
+    IdTable lineIds_ {};
+    IdTable routeIds_ {};
+
+    /* Shortest travel times between all pairs of stations, row-major by
+       origin station. Empty if they were not precomputed */
+    std::vector<unsigned int> travelTimeMatrix_ {};
+
+    /* Shortest travel time of the direct edges from a station to another
+       Return kUnreachable if there is no such edge */
+    unsigned int GetEdgeTravelTime(
+        Index from,
+        Index to
+    ) const;
+
+    /* Fill the travel time matrix row of the given origin stations, spread
+       across `nThreads` threads. With 0, the number of threads depends on the
+       number of origins */
+    void ComputeTravelTimeRows(
+        const std::vector<Index>& origins,
+        unsigned int nThreads
+    );
+
+    /* Repair the travel time matrix after the travel time from a station to
+       an adjacent one changed */
+    void RepairTravelTimes(
+        Index from,
+        Index to,
+        unsigned int oldTravelTime,
+        unsigned int newTravelTime
+    );
+
+    /* Add passengers to a station counter and refresh its crowding penalty */
+    void AddPassengers(
+        Index station,
+        long long int delta
+    );
 
-    /* Get station by id */
-    std::shared_ptr<GraphNode> GetStation(
-        const Id& stationId
+    /* Crowding penalty for a passenger count under the current model */
+    unsigned int ComputeCrowdingPenalty(
+        long long int count
     ) const;
 
-    /* Get line by id */
-    std::shared_ptr<LineInternal> GetLine(
-        const Id& lineId
-    ) const; 
+    /* Sort a batch of deltas by station, combine them and apply each
+       station total once. All deltas must have a valid station */
+    void ApplyPassengerDeltas(
+        std::vector<PassengerDelta>& deltas
+    );
 
-    /* Get route by id */
-    std::shared_ptr<RouteInternal> GetRoute(
-        const Id& lineId,
-        const Id& routeId
-    ) const; 
+    /* View of the compressed-sparse-row graph, shared with NetworkSnapshot
+       to answer travel time queries */
+    NetworkGraphView<Index, GraphEdge, StationStop, unsigned int, RouteStopSlot> GetGraphView() const;
+
+    /* Add a line and its routes, without connecting the route stations
+       Return false and leave the network untouched if the line is not valid */
+    bool AddLineRoutes(
+        const Line& line
+    );
 
     /* This function adds a route to the internal line representation */
     bool AddRouteToLine(
         const Route& route,
-        const std::shared_ptr<LineInternal>& lineInternal
+        Index line
+    );
+
+    /* Merge the edges of the routes from `firstRoute` onwards into the
+       compressed-sparse-row adjacency and into the routes serving each
+       station, build their stop position tables and rebuild the station
+       stops */
+    void IndexNewRoutes(
+        Index firstRoute
     );
 };
     
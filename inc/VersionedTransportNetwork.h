@@ -0,0 +1,151 @@
+/* @brief: Publish immutable versions of a TransportNetwork for hot reloads.
+ *         Readers take a reference to the current version and query it
+ *         without locking, and never take a lock to get it either. A new
+ *         layout is built off to the side and published with a single
+ *         pointer swap; the old version is released once its last reader is
+ *         done with it. Versions do not keep each other alive.
+ *         Live passenger counters carry over to the new version by station ID
+ */
+
+#ifndef VERSIONED_TRANSPORT_NETWORK_H
+#define VERSIONED_TRANSPORT_NETWORK_H
+
+#include "TransportNetwork.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+
+namespace NetworkMonitor
+{
+    /* @brief: One published version of the network
+     *         The layout is immutable. Passenger events can still be recorded,
+     *         because the counters are the only live data in a network
+     */
+    class NetworkVersion
+    {
+    public:
+        NetworkVersion (
+            TransportNetwork network,
+            std::uint64_t version
+        );
+
+        /* Forwards the events recorded on this version after a newer one
+           was published to the version that is current by then */
+        ~NetworkVersion();
+
+        /* @brief: Get the version number. The first version is 1 */
+        std::uint64_t GetVersion() const;
+
+        /* @brief: Get the network, for queries */
+        const TransportNetwork& GetNetwork() const;
+
+        /* @brief: Same as the TransportNetwork passenger event methods
+         * @note: Can be called concurrently from multiple threads, also
+         *        while a new version is being published
+         */
+        bool RecordPassengerEvent (
+            const PassengerEvent& event
+        ) const;
+
+        bool RecordPassengerEvent (
+            StationHandle station,
+            PassengerEvent::Type type
+        ) const;
+
+        size_t RecordPassengerEvents (
+            const PassengerEvent* events,
+            size_t nEvents
+        ) const;
+
+        size_t RecordPassengerEvents (
+            const PassengerDelta* deltas,
+            size_t nDeltas
+        ) const;
+
+    private:
+        friend class VersionedTransportNetwork;
+
+        /* Carries passenger counts over to newer versions */
+        class PassengerCountSync;
+
+        /* Only the thread-safe event methods are used on a published network */
+        mutable TransportNetwork network_;
+        std::uint64_t version_ {0};
+
+        /* Set by the publisher that replaces this version, before the swap.
+           Nothing else touches it until the destructor */
+        mutable std::unique_ptr<PassengerCountSync> sync_ {};
+    };
+
+    class VersionedTransportNetwork
+    {
+    public:
+        /* @brief: Publish the initial network as version 1 */
+        explicit VersionedTransportNetwork (
+            TransportNetwork network = {}
+        );
+
+        /* Versions are shared with readers, so the holder stays in place */
+        VersionedTransportNetwork (
+            const VersionedTransportNetwork& copied
+        ) = delete;
+
+        VersionedTransportNetwork& operator= (
+            const VersionedTransportNetwork& copied
+        ) = delete;
+
+        /* @brief: Get the current version
+         * @note: Never takes a lock, also while a new version is being
+         *        published. Each thread keeps a weak reference to the version
+         *        it got last, and reuses it until the version number changes.
+         *        The weak reference does not keep a replaced version alive.
+         *        Events recorded on a version that has been replaced reach
+         *        the current one when the last reference to the old version
+         *        is released, so do not keep the returned pointer for longer
+         *        than needed
+         */
+        std::shared_ptr<const NetworkVersion> Acquire() const;
+
+        /* @brief: Publish a new network as the next version
+         *         The passenger counts of the current version are carried
+         *         over by station ID. Stations missing from the new network
+         *         lose their count. Events recorded on the old version after
+         *         the swap are carried over when its last reader releases it
+         * @return: The new version number
+         * @note: Publishes are serialized. They never wait for readers
+         */
+        std::uint64_t Publish (
+            TransportNetwork network
+        );
+
+        /* @brief: Load a network layout and publish it, on a separate thread
+         *         The crowding model of the current version carries over
+         * @return: A future that is false if the layout could not be loaded,
+         *          in which case the current version stays in place
+         * @note: Keep the future: its destructor waits for the reload. The
+         *        reload may outlive the holder, in which case it publishes to
+         *        the versions still held by readers
+         */
+        [[nodiscard]] std::future<bool> ReloadAsync (
+            const std::filesystem::path& layout
+        );
+
+    private:
+        friend class NetworkVersion::PassengerCountSync;
+
+        /* Current version and publisher state. The versions hold a weak
+           reference to it, to forward their late events */
+        class State;
+
+        /* Identifies the holder in the reader caches. IDs are never reused,
+           unlike addresses */
+        const std::uint64_t id_;
+
+        std::shared_ptr<State> state_ {};
+    };
+}   /* namespace NetworkMonitor */
+
+#endif  /* VERSIONED_TRANSPORT_NETWORK_H */
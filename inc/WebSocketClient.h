@@ -12,11 +12,132 @@
 #include <boost/beast/ssl.hpp>
 #include <boost/system/error_code.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <random>
 #include <string>
+#include <string_view>
 #include <functional>
+#include <vector>
 
 namespace NetworkMonitor
 {
+    /* @brief: Outbound message queue settings
+     * @member:
+     *         - `highWaterMark` maximum number of bytes waiting to be written.
+     *           Send fails with boost::asio::error::no_buffer_space above it.
+     *           0 means no limit
+     *         - `coalesce` write several queued messages as one WebSocket
+     *           message. Only enable it for protocols whose messages are
+     *           self-delimiting, like STOMP frames
+     *         - `maxCoalescedSize` stop coalescing once a write reaches this
+     *           number of bytes
+     */
+    struct SendQueueOptions
+    {
+        size_t highWaterMark {0};
+        bool coalesce {false};
+        size_t maxCoalescedSize {64 * 1024};
+    };
+
+    /* @brief: permessage-deflate settings (RFC 7692)
+     * @member:
+     *         - `enabled` offer compression to the server. Messages are only
+     *           compressed if the server accepts it
+     *         - `windowBits` LZ77 window size, 9 to 15, in both directions.
+     *           Smaller windows use less memory on both ends but compress
+     *           less
+     *         - `memLevel` zlib memory level, 1 to 9, of our compressor
+     *         - `level` zlib compression level, 0 to 9, of our compressor
+     *         - `threshold` do not compress outgoing messages smaller than
+     *           this, in bytes. Ignored if the Beast release has no
+     *           permessage_deflate::msg_size_threshold (Boost 1.75 and
+     *           older): every message is then compressed
+     *         - `noContextTakeover` reset the compression context after each
+     *           message, in both directions. Uses less memory, but small
+     *           repetitive messages compress much worse
+     */
+    struct CompressionOptions
+    {
+        bool enabled {false};
+        int windowBits {15};
+        int memLevel {4};
+        int level {8};
+        size_t threshold {0};
+        bool noContextTakeover {false};
+    };
+
+    /* @brief: WebSocket stream settings
+     * @member:
+     *         - `autoFragment` split outgoing messages into several frames
+     *         - `readMessageMax` largest incoming message, in bytes. A larger
+     *           message fails the connection. 0 means no limit
+     */
+    struct StreamOptions
+    {
+        CompressionOptions compression {};
+        bool autoFragment {true};
+        size_t readMessageMax {16 * 1024 * 1024};
+    };
+
+    /* @brief: Convert the compression settings to the Boost.Beast option of a
+     *         client stream, with the values clamped to their valid range
+     */
+    boost::beast::websocket::permessage_deflate MakeClientDeflateOptions (
+        const CompressionOptions& options
+    );
+
+    /* @brief: Reconnect policy
+     *         After a failed connection attempt or a dropped connection, the
+     *         client waits `initialDelay`, then `multiplier` times longer after
+     *         each failed attempt, up to `maxDelay`. Each delay is shortened
+     *         by a random fraction of up to `jitter`, so that many clients do
+     *         not reconnect in lockstep
+     * @member:
+     *         - `maxAttempts` number of attempts before giving up. 0 means no
+     *           limit
+     *         - `resumeTlsSession` offer the previous TLS session, so that the
+     *           server can skip the full handshake
+     */
+    struct ReconnectOptions
+    {
+        bool enabled {false};
+        std::chrono::milliseconds initialDelay {100};
+        std::chrono::milliseconds maxDelay {10000};
+        double multiplier {2.0};
+        double jitter {0.5};
+        size_t maxAttempts {0};
+        bool resumeTlsSession {true};
+    };
+
+    /* @brief: Connection counters
+     * @member:
+     *         - `connects` successful connections, including reconnections
+     *         - `reconnects` successful connections after the first one
+     *         - `failedAttempts` failed connection attempts
+     *         - `resumedTlsSessions` connections that resumed a TLS session
+     *         - `lastHandshakeTime`, `totalHandshakeTime` time of the TLS and
+     *           WebSocket handshakes
+     *         - `bytesSent`, `bytesReceived` TLS bytes on the wire, after
+     *           compression and encryption
+     */
+    struct WebSocketClientMetrics
+    {
+        std::uint64_t connects {0};
+        std::uint64_t reconnects {0};
+        std::uint64_t failedAttempts {0};
+        std::uint64_t resumedTlsSessions {0};
+        std::chrono::microseconds lastHandshakeTime {0};
+        std::chrono::microseconds totalHandshakeTime {0};
+        std::uint64_t bytesSent {0};
+        std::uint64_t bytesReceived {0};
+    };
+
     class WebSocketClient
     {
     public:
@@ -25,41 +146,177 @@ namespace NetworkMonitor
             const std::string& endpoint,
             const std::string& port,
             boost::asio::io_context& ioc,
-            boost::asio::ssl::context& ctx
+            boost::asio::ssl::context& ctx,
+            const SendQueueOptions& sendOptions = {},
+            const StreamOptions& streamOptions = {}
         );
         ~WebSocketClient();
 
+        /* @brief: Connect to the server
+         *         With reconnect enabled, a dropped connection calls
+         *         `onDisconnect`, then the client reconnects in the
+         *         background. `onConnect` runs again once it is back, or with
+         *         the last error once the client gives up. Messages sent while
+         *         the connection is down fail with
+         *         boost::asio::error::not_connected
+         */
         void Connect (
             std::function<void (boost::system::error_code)> onConnect = nullptr,
             std::function<void (boost::system::error_code, std::string&&)> onMessage = nullptr,
             std::function<void (boost::system::error_code)> onDisconnect = nullptr
         );
 
+        /* @brief: Same as Connect, but each message is delivered as a view
+         *         over the read buffer, without copying it
+         * @note: The view is only valid for the duration of the callback.
+         *        Copy what needs to outlive it
+         */
+        void ConnectWithMessageView (
+            std::function<void (boost::system::error_code)> onConnect = nullptr,
+            std::function<void (boost::system::error_code, std::string_view)> onMessage = nullptr,
+            std::function<void (boost::system::error_code)> onDisconnect = nullptr
+        );
+
+        /* @brief: Reserve room in the read buffer for incoming messages
+         *         The buffer capacity is kept across reads, so messages up to
+         *         this size never cause a reallocation
+         * @note: Call it before connecting
+         */
+        void ReserveReadBuffer (
+            size_t nBytes
+        );
+
+        /* @brief: Reconnect when the connection drops, see ReconnectOptions
+         *         The resolved endpoints are cached and reused, and resolved
+         *         again if they stop working
+         * @note: Call it before connecting
+         */
+        void SetReconnectOptions (
+            const ReconnectOptions& options
+        );
+
+        /* @brief: Queue a message for sending
+         *         Messages are written one at a time, in order, on the client
+         *         strand. The client owns the message until it is written
+         * @note: Can be called from any thread, also while previous sends are
+         *        still in progress. `onSend` runs on the client strand
+         */
         void Send (
-            const std::string& message,
+            std::string message,
             std::function<void (boost::system::error_code)> onSend = nullptr
         );
 
+        /* @brief: Close the connection
+         * @note: A write in progress completes first. The messages still
+         *        queued fail with operation_aborted
+         */
         void Close (
             std::function<void (boost::system::error_code)> onClose = nullptr
         );
 
+        /* @brief: Get the number of bytes queued and not written yet
+         * @note: Can be called from any thread
+         */
+        size_t GetQueuedBytes() const;
+
+        /* @brief: Get a snapshot of the connection counters
+         * @note: Can be called from any thread
+         */
+        WebSocketClientMetrics GetMetrics() const;
+
     private:
+        using Stream = boost::beast::websocket::stream<
+            boost::beast::ssl_stream<boost::beast::tcp_stream>
+        >;
+
+        struct SslSessionDeleter
+        {
+            void operator() (
+                SSL_SESSION* session
+            ) const;
+        };
+
         std::string url_ {};
         std::string endpoint_ {};
         std::string port_ {};
+        boost::asio::ssl::context& ctx_;
 
+        /* The resolver and timer share the WebSocket strand, so that all
+           handlers are serialized with each other. The stream is replaced on
+           each reconnection, as a TLS stream cannot be reused */
+        boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+        std::optional<Stream> ws_ {};
         boost::asio::ip::tcp::resolver resolver_;
-        boost::beast::websocket::stream<boost::beast::ssl_stream<boost::beast::tcp_stream>> ws_;
         boost::beast::flat_buffer rBuffer_;
 
+        /* Reconnection state, only touched on the strand */
+        ReconnectOptions reconnectOptions_ {};
+        boost::asio::steady_timer reconnectTimer_;
+        boost::asio::ip::tcp::resolver::results_type endpoints_ {};
+        std::unique_ptr<SSL_SESSION, SslSessionDeleter> tlsSession_ {};
+        std::mt19937 rng_ {std::random_device {}()};
+        bool closing_ {false};
+        bool reconnecting_ {false};
+        bool hasConnected_ {false};
+        bool tlsSessionSaved_ {false};
+        size_t attempt_ {0};
+        std::chrono::steady_clock::time_point handshakeStart_ {};
+
+        std::atomic<std::uint64_t> connects_ {0};
+        std::atomic<std::uint64_t> reconnects_ {0};
+        std::atomic<std::uint64_t> failedAttempts_ {0};
+        std::atomic<std::uint64_t> resumedTlsSessions_ {0};
+        std::atomic<std::int64_t> lastHandshakeUs_ {0};
+        std::atomic<std::int64_t> totalHandshakeUs_ {0};
+
+        StreamOptions streamOptions_ {};
+
+        /* Wire byte counts. The counters of the TLS stream start from 0 on
+           each reconnection, so we add those of the previous streams */
+        std::uint64_t previousBytesSent_ {0};
+        std::uint64_t previousBytesReceived_ {0};
+        std::atomic<std::uint64_t> bytesSent_ {0};
+        std::atomic<std::uint64_t> bytesReceived_ {0};
+
+        /* Outbound message queue. Only touched on the strand, apart from the
+           atomic byte count used for backpressure */
+        struct OutboundMessage
+        {
+            std::string data {};
+            std::function<void (boost::system::error_code)> onSend {nullptr};
+        };
+        SendQueueOptions sendOptions_ {};
+        std::atomic<size_t> queuedBytes_ {0};
+        std::deque<OutboundMessage> sendQueue_ {};
+        bool writing_ {false};
+        std::string writeBuffer_ {};
+        std::vector<std::function<void (boost::system::error_code)>> inFlight_ {};
+
+        /* A Close that waits for the write in progress */
+        bool closePending_ {false};
+        std::function<void (boost::system::error_code)> onClose_ {nullptr};
+
+        /* A reconnection that waits for the write in progress, which still
+           runs on the old stream */
+        bool reconnectPending_ {false};
+
         std::function<void (boost::system::error_code)> onConnect_ {nullptr};
         std::function<void (boost::system::error_code, std::string&&)> onMessage_ {nullptr};
+        std::function<void (boost::system::error_code, std::string_view)> onMessageView_ {nullptr};
         std::function<void (boost::system::error_code)> onDisconnect_ {nullptr};
 
+        /* Apply the stream options to a new stream */
+        void ApplyStreamOptions();
+
+        /* Refresh the wire byte counts from the TLS stream */
+        void UpdateWireBytes();
+
+        /* Connect to the cached endpoints, or resolve them first */
+        void StartConnect();
+
         void OnResolve (
             const boost::system::error_code& ec,
-            boost::asio::ip::tcp::resolver::iterator endpoint
+            boost::asio::ip::tcp::resolver::results_type endpoints
         );
 
         void OnConnect (
@@ -74,6 +331,23 @@ namespace NetworkMonitor
             const boost::system::error_code& ec
         );
 
+        /* Retry if the reconnect policy allows it, otherwise report the
+           failure to the user */
+        void OnConnectFailed (
+            const std::string& where,
+            const boost::system::error_code& ec
+        );
+
+        /* Wait for the next backoff delay, then reconnect on a new stream */
+        void ScheduleReconnect();
+
+        /* Replace the stream and connect again. No write may be in progress */
+        void Reconnect();
+
+        /* Keep the TLS session of the connection for the next reconnection
+           Return false if the session is not resumable yet */
+        bool SaveTlsSession();
+
         void ListenToIncomingMessage (
             const boost::system::error_code& ec
         );
@@ -82,6 +356,24 @@ namespace NetworkMonitor
             const boost::system::error_code& ec,
             size_t nBytes
         );
+
+        /* Start writing the next queued messages, if no write is in progress */
+        void WriteNext();
+
+        void OnWrite (
+            const boost::system::error_code& ec
+        );
+
+        /* Fail the queued messages and send the close frame
+           No write must be in progress */
+        void StartClose (
+            std::function<void (boost::system::error_code)> onClose
+        );
+
+        /* Fail all queued messages */
+        void FailQueue (
+            const boost::system::error_code& ec
+        );
     };
 }   /* namespace NetworkMonitor */
 
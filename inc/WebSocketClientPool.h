@@ -0,0 +1,236 @@
+/* @brief: Implement a pool of WebSocket connections to the same server.
+ *         The pool owns an io_context run by a pool of threads. Each
+ *         connection lives on its own strand, so connections progress in
+ *         parallel while the callbacks of a single connection never overlap.
+ *         Subscriptions are spread across the connections.
+ */
+
+#ifndef WEBSOCKET_CLIENT_POOL_H
+#define WEBSOCKET_CLIENT_POOL_H
+
+#include "WebSocketClient.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace NetworkMonitor
+{
+    /* @brief: Pool settings
+     * @member:
+     *         - `nConnections` number of WebSocket connections
+     *         - `nThreads` number of threads running the io_context
+     *         - `reconnectOptions` reconnect policy of each connection. A
+     *           reconnected connection sends the messages of its
+     *           subscriptions again, then those queued while it was down.
+     *           A connection that gives up reconnecting, or that drops
+     *           without reconnections, loses its subscriptions and takes no
+     *           new ones. `onConnect` or `onDisconnect` reports it
+     *         - `drainTimeout` how long Stop waits for the queued messages to
+     *           be written and the connections to close
+     */
+    struct WebSocketPoolOptions
+    {
+        size_t nConnections {4};
+        unsigned int nThreads {2};
+        SendQueueOptions sendOptions {};
+        StreamOptions streamOptions {};
+        ReconnectOptions reconnectOptions {};
+        std::chrono::milliseconds drainTimeout {5000};
+    };
+
+    /* Counters of a single connection */
+    struct ConnectionStats
+    {
+        bool connected {false};
+        size_t nSubscriptions {0};
+        std::uint64_t messagesReceived {0};
+        std::uint64_t bytesReceived {0};
+        std::uint64_t messagesSent {0};
+        std::uint64_t bytesSent {0};
+        std::uint64_t sendErrors {0};
+        std::uint64_t reconnects {0};
+    };
+
+    /* @brief: Pool counters
+     * @member:
+     *         - `elapsed` time since Start
+     *         - `messagesPerSecond`, `bytesPerSecond` receive throughput
+     *           since Start
+     */
+    struct PoolStats
+    {
+        size_t nConnected {0};
+        std::uint64_t messagesReceived {0};
+        std::uint64_t bytesReceived {0};
+        std::uint64_t messagesSent {0};
+        std::uint64_t bytesSent {0};
+        std::uint64_t sendErrors {0};
+        std::uint64_t reconnects {0};
+        std::chrono::duration<double> elapsed {0};
+        double messagesPerSecond {0};
+        double bytesPerSecond {0};
+        std::vector<ConnectionStats> connections {};
+    };
+
+    class WebSocketClientPool
+    {
+    public:
+        /* Connection callbacks receive the index of the connection */
+        using OnConnect = std::function<void (size_t, boost::system::error_code)>;
+        using OnMessage = std::function<void (size_t, boost::system::error_code, std::string_view)>;
+        using OnDisconnect = std::function<void (size_t, boost::system::error_code)>;
+
+        WebSocketClientPool (
+            const std::string& url,
+            const std::string& endpoint,
+            const std::string& port,
+            boost::asio::ssl::context& ctx,
+            const WebSocketPoolOptions& options = {}
+        );
+
+        /* @brief: Stop the pool, see Stop */
+        ~WebSocketClientPool();
+
+        WebSocketClientPool (
+            const WebSocketClientPool& copied
+        ) = delete;
+
+        WebSocketClientPool& operator= (
+            const WebSocketClientPool& copied
+        ) = delete;
+
+        /* @brief: Connect all connections and start the pool threads
+         *         A pool can only be started once
+         * @note: The callbacks run on the pool threads. The callbacks of a
+         *        connection run on its strand: they never overlap with each
+         *        other, but callbacks of different connections do. Messages
+         *        are views over the connection read buffer, see
+         *        WebSocketClient::ConnectWithMessageView
+         */
+        void Start (
+            OnConnect onConnect = nullptr,
+            OnMessage onMessage = nullptr,
+            OnDisconnect onDisconnect = nullptr
+        );
+
+        /* @brief: Stop accepting messages, wait for the queued ones to be
+         *         written, close all connections and join the pool threads
+         *         Gives up and aborts the connections after `drainTimeout`
+         * @note: Do not call it from a pool callback
+         */
+        void Stop();
+
+        /* @brief: Open a subscription on the connection with the fewest
+         *         subscriptions. `message` is the protocol message that opens
+         *         it, e.g. a STOMP SUBSCRIBE frame
+         *         If the connection is not up yet, the message is sent once it
+         *         connects, before its `onConnect` callback. It is sent again
+         *         each time the connection reconnects
+         * @return: The index of the connection, or std::nullopt if the pool is
+         *          stopped or if every connection is gone
+         */
+        std::optional<size_t> Subscribe (
+            std::string message,
+            std::function<void (boost::system::error_code)> onSend = nullptr
+        );
+
+        /* @brief: Send a message on a given connection
+         * @return: false if the pool is stopped or the index is out of range
+         * @note: Can be called from any thread, see WebSocketClient::Send
+         */
+        bool Send (
+            size_t connection,
+            std::string message,
+            std::function<void (boost::system::error_code)> onSend = nullptr
+        );
+
+        size_t GetConnectionCount() const;
+
+        /* @brief: Get a snapshot of the pool counters */
+        PoolStats GetStats() const;
+
+    private:
+        struct PendingMessage
+        {
+            std::string data {};
+            std::function<void (boost::system::error_code)> onSend {nullptr};
+        };
+
+        struct Connection
+        {
+            std::unique_ptr<WebSocketClient> client {};
+
+            /* Guards `connected`, `pending` and `subscriptions`, so that a
+               subscription is either sent right away or flushed on connect,
+               never lost */
+            mutable std::mutex mutex {};
+            bool connected {false};
+            std::vector<PendingMessage> pending {};
+
+            /* Messages of the subscriptions sent on this connection, to renew
+               them when it reconnects */
+            std::vector<std::string> subscriptions {};
+
+            /* Written under the pool subscribe mutex. Counts the pending and
+               the sent subscriptions */
+            std::atomic<size_t> nSubscriptions {0};
+
+            /* The connection is gone for good and takes no subscriptions.
+               Guarded by the pool subscribe mutex */
+            bool failed {false};
+
+            std::atomic<std::uint64_t> messagesReceived {0};
+            std::atomic<std::uint64_t> bytesReceived {0};
+            std::atomic<std::uint64_t> messagesSent {0};
+            std::atomic<std::uint64_t> bytesSent {0};
+            std::atomic<std::uint64_t> sendErrors {0};
+        };
+
+        WebSocketPoolOptions options_ {};
+        boost::asio::io_context ioc_ {};
+        std::optional<boost::asio::executor_work_guard<
+            boost::asio::io_context::executor_type
+        >> work_ {};
+        std::vector<std::unique_ptr<Connection>> connections_ {};
+        std::vector<std::thread> threads_ {};
+
+        std::atomic<bool> running_ {false};
+        std::atomic<bool> stopping_ {false};
+        std::chrono::steady_clock::time_point startTime_ {};
+        std::mutex subscribeMutex_ {};
+
+        /* Counts the connections closed by Stop */
+        std::mutex closeMutex_ {};
+        std::condition_variable closeCv_ {};
+        size_t nClosed_ {0};
+
+        /* Forget the subscriptions of a connection that is gone for good
+           Return the pending ones, to fail them */
+        std::vector<PendingMessage> DropSubscriptions (
+            Connection& connection
+        );
+
+        void SendOn (
+            Connection& connection,
+            std::string message,
+            std::function<void (boost::system::error_code)> onSend
+        );
+    };
+}   /* namespace NetworkMonitor */
+
+#endif  /* WEBSOCKET_CLIENT_POOL_H */
@@ -0,0 +1,132 @@
+#include "AwaitableWebSocketClient.h"
+#include "WebSocketClient.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using NetworkMonitor::AwaitableWebSocketClient;
+using NetworkMonitor::StreamOptions;
+
+using boost::asio::awaitable;
+using boost::asio::redirect_error;
+using boost::asio::use_awaitable;
+
+/* Public methods */
+AwaitableWebSocketClient::AwaitableWebSocketClient (
+    const std::string& url,
+    const std::string& endpoint,
+    const std::string& port,
+    boost::asio::io_context& ioc,
+    boost::asio::ssl::context& ctx,
+    const StreamOptions& streamOptions
+) : url_ {url},
+    endpoint_ {endpoint},
+    port_ {port},
+    strand_ {boost::asio::make_strand(ioc)},
+    resolver_ {strand_},
+    ws_ {strand_, ctx}
+{
+    ws_.set_option(NetworkMonitor::MakeClientDeflateOptions(streamOptions.compression));
+    ws_.auto_fragment(streamOptions.autoFragment);
+    ws_.read_message_max(streamOptions.readMessageMax);
+}
+
+AwaitableWebSocketClient::Executor AwaitableWebSocketClient::GetExecutor() const
+{
+    return strand_;
+}
+
+awaitable<boost::system::error_code> AwaitableWebSocketClient::Connect()
+{
+    boost::system::error_code ec {};
+    const auto endpoints {co_await resolver_.async_resolve(url_, port_,
+        redirect_error(use_awaitable, ec)
+    )};
+    if (ec)
+    {
+        co_return ec;
+    }
+
+    /* Same timeouts as the callback client: 5 seconds to connect the TCP
+       socket, then whatever Boost.Beast recommends */
+    auto& tcp {boost::beast::get_lowest_layer(ws_)};
+    tcp.expires_after(std::chrono::seconds(5));
+    co_await tcp.async_connect(endpoints, redirect_error(use_awaitable, ec));
+    if (ec)
+    {
+        co_return ec;
+    }
+    tcp.expires_never();
+    ws_.set_option(
+        boost::beast::websocket::stream_base::timeout::suggested(
+            boost::beast::role_type::client
+        )
+    );
+
+    co_await ws_.next_layer().async_handshake(boost::asio::ssl::stream_base::client,
+        redirect_error(use_awaitable, ec)
+    );
+    if (ec)
+    {
+        co_return ec;
+    }
+    co_await ws_.async_handshake(url_, endpoint_, redirect_error(use_awaitable, ec));
+    if (ec)
+    {
+        co_return ec;
+    }
+    ws_.text(true);
+    co_return ec;
+}
+
+awaitable<boost::system::error_code> AwaitableWebSocketClient::Send (
+    std::string_view message
+)
+{
+    boost::system::error_code ec {};
+    co_await ws_.async_write(boost::asio::buffer(message.data(), message.size()),
+        redirect_error(use_awaitable, ec)
+    );
+    co_return ec;
+}
+
+awaitable<std::pair<boost::system::error_code, std::string_view>> AwaitableWebSocketClient::Read()
+{
+    /* Drop the previous message, keeping the buffer capacity */
+    rBuffer_.consume(rBuffer_.size());
+
+    boost::system::error_code ec {};
+    co_await ws_.async_read(rBuffer_, redirect_error(use_awaitable, ec));
+    if (ec)
+    {
+        co_return std::make_pair(ec, std::string_view {});
+    }
+    const auto data {rBuffer_.cdata()};
+    co_return std::make_pair(ec, std::string_view {
+        static_cast<const char*>(data.data()), data.size()
+    });
+}
+
+void AwaitableWebSocketClient::ReserveReadBuffer (
+    size_t nBytes
+)
+{
+    rBuffer_.reserve(nBytes);
+}
+
+awaitable<boost::system::error_code> AwaitableWebSocketClient::Close()
+{
+    boost::system::error_code ec {};
+    co_await ws_.async_close(boost::beast::websocket::close_code::none,
+        redirect_error(use_awaitable, ec)
+    );
+    co_return ec;
+}
@@ -3,16 +3,332 @@
  */
 
 #include <FileDownloader.h>
+#include <MappedFile.h>
 
+#include <boost/asio.hpp>
 #include <nlohmann/json.hpp>
 #include <curl/curl.h>
 
 #include <stdio.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <iostream>
+#include <limits>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <streambuf>
 #include <string>
 #include <string.h>
+#include <string_view>
 #include <filesystem>
 #include <fstream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using NetworkMonitor::DownloadOptions;
+using NetworkMonitor::DownloadResult;
+using NetworkMonitor::FileDownloader;
+using NetworkMonitor::MappedFile;
+using NetworkMonitor::MultiFileDownloader;
+
+namespace
+{
+    /* One download: what to fetch, where to write it and what the server
+       answered so far. Shared by the blocking and the multi downloaders */
+    struct Transfer
+    {
+        std::string url {};
+        std::filesystem::path destination {};
+        DownloadOptions options {};
+
+        /* Size of the partial file we ask the rest of */
+        std::uint64_t offset {0};
+
+        std::FILE* file {nullptr};
+        curl_slist* headers {nullptr};
+
+        /* When streaming, the body bytes not read yet. The destination, if
+           any, only gets a copy */
+        std::string* body {nullptr};
+        char errBuff[CURL_ERROR_SIZE] {};
+
+        /* From the response headers. With redirects, only the last response
+           counts */
+        long status {0};
+        std::optional<std::uint64_t> rangeStart {};
+        std::optional<std::uint64_t> rangeTotal {};
+        std::string etag {};
+        std::string lastModified {};
+
+        Transfer() = default;
+
+        Transfer (
+            const Transfer& copied
+        ) = delete;
+
+        Transfer& operator= (
+            const Transfer& copied
+        ) = delete;
+
+        ~Transfer()
+        {
+            if (file != nullptr)
+            {
+                fclose(file);
+            }
+            curl_slist_free_all(headers);
+        }
+    };
+
+    bool EqualsNoCase (
+        std::string_view a,
+        std::string_view b
+    )
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+            [](char ca, char cb) {
+                return std::tolower(static_cast<unsigned char>(ca))
+                    == std::tolower(static_cast<unsigned char>(cb));
+            }
+        );
+    }
+
+    size_t OnHeader (
+        char* buffer,
+        size_t size,
+        size_t nItems,
+        void* userData
+    )
+    {
+        auto& transfer {*static_cast<Transfer*>(userData)};
+        const auto nBytes {size * nItems};
+        std::string_view line {buffer, nBytes};
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+        {
+            line.remove_suffix(1);
+        }
+
+        /* A status line starts a new response */
+        if (line.substr(0, 5) == "HTTP/")
+        {
+            const auto space {line.find(' ')};
+            transfer.status = space == std::string_view::npos ? 0
+                : std::atol(std::string {line.substr(space + 1, 3)}.c_str());
+            transfer.rangeStart.reset();
+            transfer.rangeTotal.reset();
+            transfer.etag.clear();
+            transfer.lastModified.clear();
+            return nBytes;
+        }
+
+        const auto colon {line.find(':')};
+        if (colon == std::string_view::npos)
+        {
+            return nBytes;
+        }
+        const auto name {line.substr(0, colon)};
+        auto value {line.substr(colon + 1)};
+        while (!value.empty() && value.front() == ' ')
+        {
+            value.remove_prefix(1);
+        }
+        if (EqualsNoCase(name, "ETag"))
+        {
+            transfer.etag = value;
+        }
+        else if (EqualsNoCase(name, "Last-Modified"))
+        {
+            transfer.lastModified = value;
+        }
+        else if (EqualsNoCase(name, "Content-Range") && value.substr(0, 6) == "bytes ")
+        {
+            /* "bytes first-last/size", or a star instead of the range */
+            const auto range {value.substr(6)};
+            if (!range.empty() && range.front() != '*')
+            {
+                transfer.rangeStart = std::strtoull(std::string {range}.c_str(), nullptr, 10);
+            }
+            const auto slash {range.find('/')};
+            if (slash != std::string_view::npos && range.substr(slash + 1) != "*")
+            {
+                transfer.rangeTotal = std::strtoull(
+                    std::string {range.substr(slash + 1)}.c_str(), nullptr, 10
+                );
+            }
+        }
+        return nBytes;
+    }
+
+    size_t OnWrite (
+        char* data,
+        size_t size,
+        size_t nMembers,
+        void* userData
+    )
+    {
+        auto& transfer {*static_cast<Transfer*>(userData)};
+        const auto nBytes {size * nMembers};
+
+        /* Keep error pages out of the destination */
+        if (transfer.status != 200 && transfer.status != 206)
+        {
+            return nBytes;
+        }
+        if (transfer.body != nullptr)
+        {
+            transfer.body->append(data, nBytes);
+            if (transfer.destination.empty())
+            {
+                return nBytes;
+            }
+        }
+        if (transfer.file == nullptr)
+        {
+            /* Only append what follows the partial file, anything else
+               replaces it */
+            const bool append {transfer.status == 206};
+            if (append && transfer.rangeStart != transfer.offset)
+            {
+                return 0;
+            }
+            transfer.file = fopen(transfer.destination.string().c_str(), append ? "ab" : "wb");
+            if (transfer.file == nullptr)
+            {
+                return 0;
+            }
+        }
+        return fwrite(data, 1, nBytes, transfer.file);
+    }
+
+    void SetupTransfer (
+        CURL* curl,
+        Transfer& transfer,
+        const std::filesystem::path& caFile
+    )
+    {
+        curl_easy_setopt(curl, CURLOPT_URL, transfer.url.c_str());
+        curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, transfer.errBuff);
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        if (!caFile.empty())
+        {
+            curl_easy_setopt(curl, CURLOPT_CAINFO, caFile.string().c_str());
+        }
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, OnHeader);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, OnWrite);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+
+        const auto& options {transfer.options};
+        if (!options.etag.empty())
+        {
+            transfer.headers = curl_slist_append(transfer.headers,
+                ("If-None-Match: " + options.etag).c_str());
+        }
+        if (!options.lastModified.empty())
+        {
+            transfer.headers = curl_slist_append(transfer.headers,
+                ("If-Modified-Since: " + options.lastModified).c_str());
+        }
+
+        /* Not CURLOPT_RESUME_FROM: it fails when the server ignores the
+           range, while we just take the whole file.
+           A range is only safe against the file the partial download came
+           from: If-Range makes the server send the whole file if it changed.
+           Weak ETags cannot be used with If-Range */
+        const auto& validator {options.partialValidator};
+        std::error_code ec {};
+        const auto size {std::filesystem::file_size(transfer.destination, ec)};
+        if (options.resume
+            && !validator.empty()
+            && validator.compare(0, 2, "W/") != 0
+            && !ec
+            && size > 0)
+        {
+            transfer.offset = size;
+            transfer.headers = curl_slist_append(transfer.headers,
+                ("If-Range: " + validator).c_str());
+            curl_easy_setopt(curl, CURLOPT_RANGE, (std::to_string(size) + "-").c_str());
+        }
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer.headers);
+    }
+
+    DownloadResult FinishTransfer (
+        CURL* curl,
+        Transfer& transfer,
+        CURLcode res
+    )
+    {
+        if (transfer.file != nullptr)
+        {
+            if (fclose(transfer.file) != 0 && res == CURLE_OK)
+            {
+                res = CURLE_WRITE_ERROR;
+            }
+            transfer.file = nullptr;
+        }
+
+        DownloadResult result {};
+        result.httpStatus = transfer.status;
+        result.notModified = transfer.status == 304;
+        result.resumed = transfer.status == 206;
+        result.etag = transfer.etag;
+        result.lastModified = transfer.lastModified;
+
+        curl_off_t bytesReceived {0};
+        curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &bytesReceived);
+        result.bytesReceived = bytesReceived;
+        curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &result.newConnections);
+        curl_off_t elapsedUs {0};
+        curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &elapsedUs);
+        result.elapsed = std::chrono::microseconds {elapsedUs};
+
+        if (res != CURLE_OK)
+        {
+            result.error = transfer.errBuff[0] != 0 ? transfer.errBuff : curl_easy_strerror(res);
+            return result;
+        }
+        switch (transfer.status)
+        {
+        case 200:
+        {
+            /* An empty body never opened the destination */
+            if (bytesReceived == 0 && !transfer.destination.empty())
+            {
+                std::ofstream {transfer.destination, std::ios::binary | std::ios::trunc};
+            }
+            result.ok = true;
+            break;
+        }
+        case 206:
+        case 304:
+        {
+            result.ok = true;
+            break;
+        }
+        case 416:
+        {
+            /* Nothing left to resume: the partial file is already whole */
+            result.ok = transfer.offset > 0 && transfer.rangeTotal == transfer.offset;
+            if (!result.ok)
+            {
+                result.error = "HTTP status 416";
+            }
+            break;
+        }
+        default:
+        {
+            result.error = "HTTP status " + std::to_string(transfer.status);
+            break;
+        }
+        }
+        return result;
+    }
+}   /* namespace */
 
 bool NetworkMonitor::DownloadFile (
     const std::string& fileURL,
@@ -73,24 +389,646 @@ bool NetworkMonitor::DownloadFile (
     return res == CURLE_OK;
 }
 
-nlohmann::json NetworkMonitor::ParseJsonFile (
-    const std::filesystem::path& src
+/* The easy handle runs on a multi handle of its own, so that a streamed
+   download only moves the transfer forward when its reader needs more bytes.
+   The handles keep the open connections, TLS sessions and DNS cache across
+   downloads */
+struct FileDownloader::State
+{
+    std::filesystem::path caFile {};
+    CURL* curl {nullptr};
+    CURLM* multi {nullptr};
+
+    /* Outcome of the transfer, once it is no longer running */
+    bool running {false};
+    CURLcode res {CURLE_OK};
+
+    ~State()
+    {
+        Stop(CURLE_ABORTED_BY_CALLBACK);
+        curl_easy_cleanup(curl);
+        curl_multi_cleanup(multi);
+    }
+
+    /* Get the handles ready for a new transfer */
+    bool Reset()
+    {
+        /* A consumer that threw left its transfer running */
+        Stop(CURLE_ABORTED_BY_CALLBACK);
+        if (curl == nullptr)
+        {
+            curl = curl_easy_init();
+        }
+        if (multi == nullptr)
+        {
+            /* Without a limit, the connection cache shrinks with the number
+               of transfers and would close the connection after each one */
+            multi = curl_multi_init();
+            curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, 4L);
+        }
+        if (curl == nullptr || multi == nullptr)
+        {
+            return false;
+        }
+
+        /* Reset the options of the previous download */
+        curl_easy_reset(curl);
+        return true;
+    }
+
+    void Start()
+    {
+        running = curl_multi_add_handle(multi, curl) == CURLM_OK;
+        res = running ? CURLE_OK : CURLE_FAILED_INIT;
+    }
+
+    void Stop (
+        CURLcode result
+    )
+    {
+        if (running)
+        {
+            curl_multi_remove_handle(multi, curl);
+            running = false;
+            res = result;
+        }
+    }
+
+    /* Let libcurl move the transfer forward, without waiting */
+    void Perform()
+    {
+        int nRunning {0};
+        if (curl_multi_perform(multi, &nRunning) != CURLM_OK)
+        {
+            Stop(CURLE_RECV_ERROR);
+            return;
+        }
+        int nMessages {0};
+        while (CURLMsg* message {curl_multi_info_read(multi, &nMessages)})
+        {
+            /* The message is freed with the handle */
+            if (message->msg == CURLMSG_DONE)
+            {
+                const auto result {message->data.result};
+                Stop(result);
+            }
+        }
+    }
+
+    /* Wait for socket activity or for a libcurl timeout */
+    void Wait()
+    {
+        if (curl_multi_poll(multi, nullptr, 0, 1000, nullptr) != CURLM_OK)
+        {
+            Stop(CURLE_RECV_ERROR);
+        }
+    }
+
+    /* Run the transfer until `body` has bytes or the transfer completes */
+    void Receive (
+        const std::string& body
+    )
+    {
+        while (running && body.empty())
+        {
+            Perform();
+            if (running && body.empty())
+            {
+                Wait();
+            }
+        }
+    }
+
+    /* Run the transfer to completion */
+    CURLcode Run()
+    {
+        while (running)
+        {
+            Perform();
+            if (running)
+            {
+                Wait();
+            }
+        }
+        return res;
+    }
+};
+
+namespace
+{
+    /* Stream buffer over the body of a download in progress. Reading past
+       the bytes received so far runs the transfer until more arrive, so the
+       reader works on each chunk while the next one is on its way */
+    class BodyBuffer: public std::streambuf
+    {
+    public:
+        BodyBuffer (
+            FileDownloader::State& state,
+            std::string& body
+        ) : state_ {state},
+            body_ {body}
+        {}
+
+    protected:
+        int_type underflow() override
+        {
+            /* Bytes received before the first read are still unread */
+            if (gptr() != nullptr)
+            {
+                body_.clear();
+            }
+            state_.Receive(body_);
+            if (body_.empty())
+            {
+                return traits_type::eof();
+            }
+            setg(body_.data(), body_.data(), body_.data() + body_.size());
+            return traits_type::to_int_type(body_.front());
+        }
+
+    private:
+        FileDownloader::State& state_;
+        std::string& body_;
+    };
+}   /* namespace */
+
+FileDownloader::FileDownloader (
+    const std::filesystem::path& caFile
+) : state_ {std::make_unique<State>()}
+{
+    state_->caFile = caFile;
+}
+
+FileDownloader::~FileDownloader() = default;
+
+DownloadResult FileDownloader::Download (
+    const std::string& fileURL,
+    const std::filesystem::path& destination,
+    const DownloadOptions& options
+)
+{
+    if (!state_->Reset())
+    {
+        DownloadResult result {};
+        result.error = "curl_easy_init failed";
+        return result;
+    }
+
+    Transfer transfer {};
+    transfer.url = fileURL;
+    transfer.destination = destination;
+    transfer.options = options;
+    SetupTransfer(state_->curl, transfer, state_->caFile);
+    state_->Start();
+    return FinishTransfer(state_->curl, transfer, state_->Run());
+}
+
+DownloadResult FileDownloader::Stream (
+    const std::string& fileURL,
+    const BodyConsumer& consume,
+    const DownloadOptions& options,
+    const std::filesystem::path& cacheFile
 )
 {
-    nlohmann::json parsed {};
-    if (!std::filesystem::exists(src))
+    if (!state_->Reset())
+    {
+        DownloadResult result {};
+        result.error = "curl_easy_init failed";
+        return result;
+    }
+
+    std::string body {};
+    Transfer transfer {};
+    transfer.url = fileURL;
+    transfer.options = options;
+    transfer.body = &body;
+
+    /* A body cannot be read from the middle */
+    transfer.options.resume = false;
+
+    /* The copy goes to a file next to the cache, which only replaces the
+       cache once the whole body was received and accepted */
+    if (!cacheFile.empty())
+    {
+        transfer.destination = cacheFile;
+        transfer.destination += ".part";
+    }
+    SetupTransfer(state_->curl, transfer, state_->caFile);
+    state_->Start();
+
+    /* Wait for the first body bytes, or for a response without a body */
+    state_->Receive(body);
+    bool accepted {true};
+    if (transfer.status == 200)
+    {
+        BodyBuffer buffer {*state_, body};
+        std::istream stream {&buffer};
+        accepted = consume(stream);
+
+        /* Skip what the consumer did not read, to finish the copy and keep
+           the connection */
+        if (accepted)
+        {
+            stream.clear();
+            stream.ignore(std::numeric_limits<std::streamsize>::max());
+        }
+    }
+    if (accepted)
+    {
+        state_->Run();
+    }
+    else
+    {
+        state_->Stop(CURLE_ABORTED_BY_CALLBACK);
+    }
+
+    auto result {FinishTransfer(state_->curl, transfer, state_->res)};
+    if (!accepted)
+    {
+        result.ok = false;
+        result.error = "Body rejected";
+    }
+    if (!transfer.destination.empty())
+    {
+        std::error_code ec {};
+        if (result.ok && transfer.status == 200)
+        {
+            std::filesystem::rename(transfer.destination, cacheFile, ec);
+            if (ec)
+            {
+                result.ok = false;
+                result.error = "Could not write " + cacheFile.string() + ": " + ec.message();
+            }
+        }
+        std::filesystem::remove(transfer.destination, ec);
+    }
+    return result;
+}
+
+/* All members are only touched on the strand */
+struct MultiFileDownloader::State
+{
+    using tcp = boost::asio::ip::tcp;
+
+    /* A socket libcurl opened through us, so that we can wait on it. Its
+       waits run on the strand */
+    struct Socket
+    {
+        tcp::socket socket;
+        int what {CURL_POLL_NONE};
+        bool reading {false};
+        bool writing {false};
+    };
+
+    /* A download in progress, with the easy handle it runs on */
+    struct Download
+    {
+        Transfer transfer {};
+        OnDone onDone {nullptr};
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work;
+
+        Download (
+            boost::asio::io_context& ioc,
+            OnDone onDone
+        ) : onDone {std::move(onDone)},
+            work {boost::asio::make_work_guard(ioc)}
+        {}
+    };
+
+    boost::asio::io_context& ioc;
+    boost::asio::strand<boost::asio::io_context::executor_type> strand;
+    boost::asio::steady_timer timer;
+    std::filesystem::path caFile {};
+
+    CURLM* multi {nullptr};
+    CURLSH* share {nullptr};
+    std::vector<CURL*> idle {};
+    std::unordered_map<curl_socket_t, std::shared_ptr<Socket>> sockets {};
+    std::unordered_map<CURL*, std::unique_ptr<Download>> downloads {};
+
+    State (
+        boost::asio::io_context& ioc
+    ) : ioc {ioc},
+        strand {boost::asio::make_strand(ioc)},
+        timer {strand}
+    {
+        multi = curl_multi_init();
+        curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, OnSocket);
+        curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, this);
+        curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, OnTimer);
+        curl_multi_setopt(multi, CURLMOPT_TIMERDATA, this);
+
+        /* The multi handle already shares its connections. Also share the
+           TLS sessions, so that parallel connections to the same host resume
+           them, and the DNS cache. No locks: only the strand uses them */
+        share = curl_share_init();
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    }
+
+    ~State()
     {
-        return parsed;
+        /* libcurl closes the sockets through us while cleaning up, so the
+           socket map must still be alive */
+        for (auto& [curl, download]: downloads)
+        {
+            curl_multi_remove_handle(multi, curl);
+            curl_easy_cleanup(curl);
+        }
+        downloads.clear();
+        for (auto* curl: idle)
+        {
+            curl_easy_cleanup(curl);
+        }
+        curl_multi_cleanup(multi);
+        curl_share_cleanup(share);
     }
+
+    void Start (
+        std::unique_ptr<Download> download
+    )
+    {
+        CURL* curl {nullptr};
+        if (!idle.empty())
+        {
+            curl = idle.back();
+            idle.pop_back();
+            curl_easy_reset(curl);
+        }
+        else
+        {
+            curl = curl_easy_init();
+        }
+        if (curl == nullptr)
+        {
+            DownloadResult result {};
+            result.error = "curl_easy_init failed";
+            if (download->onDone)
+            {
+                download->onDone(result);
+            }
+            return;
+        }
+
+        SetupTransfer(curl, download->transfer, caFile);
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        curl_easy_setopt(curl, CURLOPT_OPENSOCKETFUNCTION, OnOpenSocket);
+        curl_easy_setopt(curl, CURLOPT_OPENSOCKETDATA, this);
+        curl_easy_setopt(curl, CURLOPT_CLOSESOCKETFUNCTION, OnCloseSocket);
+        curl_easy_setopt(curl, CURLOPT_CLOSESOCKETDATA, this);
+        downloads.emplace(curl, std::move(download));
+
+        /* libcurl asks for a timeout, and the transfer starts when it
+           expires */
+        curl_multi_add_handle(multi, curl);
+    }
+
+    /* Let libcurl act on a socket or on the timeout, then complete the
+       finished downloads */
+    void Act (
+        curl_socket_t fd,
+        int events
+    )
+    {
+        int nRunning {0};
+        curl_multi_socket_action(multi, fd, events, &nRunning);
+
+        int nMessages {0};
+        while (CURLMsg* message {curl_multi_info_read(multi, &nMessages)})
+        {
+            if (message->msg != CURLMSG_DONE)
+            {
+                continue;
+            }
+            /* The message is freed with the handle */
+            auto* curl {message->easy_handle};
+            const auto res {message->data.result};
+            curl_multi_remove_handle(multi, curl);
+
+            auto node {downloads.extract(curl)};
+            auto& download {*node.mapped()};
+            const auto result {FinishTransfer(curl, download.transfer, res)};
+            idle.push_back(curl);
+            if (download.onDone)
+            {
+                download.onDone(result);
+            }
+        }
+    }
+
+    /* Wait for the events libcurl is interested in, if we do not already */
+    void Watch (
+        const std::shared_ptr<Socket>& socket
+    )
+    {
+        if ((socket->what & CURL_POLL_IN) && !socket->reading)
+        {
+            socket->reading = true;
+            Wait(socket, tcp::socket::wait_read, CURL_CSELECT_IN);
+        }
+        if ((socket->what & CURL_POLL_OUT) && !socket->writing)
+        {
+            socket->writing = true;
+            Wait(socket, tcp::socket::wait_write, CURL_CSELECT_OUT);
+        }
+    }
+
+    void Wait (
+        const std::shared_ptr<Socket>& socket,
+        tcp::socket::wait_type type,
+        int events
+    )
+    {
+        const auto fd {socket->socket.native_handle()};
+        socket->socket.async_wait(type,
+            [this, weak = std::weak_ptr<Socket> {socket}, fd, type, events](auto ec) {
+                auto socket {weak.lock()};
+                if (socket == nullptr)
+                {
+                    return;
+                }
+                (type == tcp::socket::wait_read ? socket->reading : socket->writing) = false;
+                if (ec != boost::asio::error::operation_aborted)
+                {
+                    Act(fd, ec ? CURL_CSELECT_ERR : events);
+                }
+
+                /* libcurl may have closed the socket meanwhile, or asked for
+                   the events again while a cancelled wait was pending */
+                if (socket->socket.is_open())
+                {
+                    Watch(socket);
+                }
+            }
+        );
+    }
+
+    static curl_socket_t OnOpenSocket (
+        void* userData,
+        curlsocktype purpose,
+        curl_sockaddr* address
+    )
+    {
+        auto& state {*static_cast<State*>(userData)};
+        if (purpose != CURLSOCKTYPE_IPCXN
+            || (address->family != AF_INET && address->family != AF_INET6))
+        {
+            return CURL_SOCKET_BAD;
+        }
+        auto socket {std::make_shared<Socket>(Socket {tcp::socket {state.strand}})};
+        boost::system::error_code ec {};
+        socket->socket.open(address->family == AF_INET ? tcp::v4() : tcp::v6(), ec);
+        if (ec)
+        {
+            return CURL_SOCKET_BAD;
+        }
+        const auto fd {socket->socket.native_handle()};
+        state.sockets[fd] = std::move(socket);
+        return fd;
+    }
+
+    static int OnCloseSocket (
+        void* userData,
+        curl_socket_t fd
+    )
+    {
+        auto& state {*static_cast<State*>(userData)};
+        const auto it {state.sockets.find(fd)};
+        if (it != state.sockets.end())
+        {
+            /* Cancels the pending waits */
+            boost::system::error_code ec {};
+            it->second->socket.close(ec);
+            state.sockets.erase(it);
+        }
+        return 0;
+    }
+
+    static int OnSocket (
+        CURL*,
+        curl_socket_t fd,
+        int what,
+        void* userData,
+        void*
+    )
+    {
+        auto& state {*static_cast<State*>(userData)};
+        const auto it {state.sockets.find(fd)};
+        if (it == state.sockets.end())
+        {
+            return 0;
+        }
+        auto& socket {it->second};
+        if (what == CURL_POLL_REMOVE)
+        {
+            socket->what = CURL_POLL_NONE;
+            boost::system::error_code ec {};
+            socket->socket.cancel(ec);
+            return 0;
+        }
+        socket->what = what;
+        state.Watch(socket);
+        return 0;
+    }
+
+    static int OnTimer (
+        CURLM*,
+        long timeoutMs,
+        void* userData
+    )
+    {
+        /* -1 deletes the timer. Do not act from here: libcurl does not
+           expect to be called back into */
+        auto& state {*static_cast<State*>(userData)};
+        state.timer.cancel();
+        if (timeoutMs >= 0)
+        {
+            state.timer.expires_after(std::chrono::milliseconds(timeoutMs));
+            state.timer.async_wait([&state](auto ec) {
+                if (!ec)
+                {
+                    state.Act(CURL_SOCKET_TIMEOUT, 0);
+                }
+            });
+        }
+        return 0;
+    }
+};
+
+MultiFileDownloader::MultiFileDownloader (
+    boost::asio::io_context& ioc,
+    const std::filesystem::path& caFile,
+    size_t maxCachedConnections
+) : state_ {std::make_unique<State>(ioc)}
+{
+    state_->caFile = caFile;
+    curl_multi_setopt(state_->multi, CURLMOPT_MAXCONNECTS,
+                      static_cast<long>(std::max<size_t>(maxCachedConnections, 1)));
+}
+
+MultiFileDownloader::~MultiFileDownloader() = default;
+
+void MultiFileDownloader::Download (
+    const std::string& fileURL,
+    const std::filesystem::path& destination,
+    const DownloadOptions& options,
+    OnDone onDone
+)
+{
+    auto download {std::make_unique<State::Download>(state_->ioc, std::move(onDone))};
+    download->transfer.url = fileURL;
+    download->transfer.destination = destination;
+    download->transfer.options = options;
+    boost::asio::post(state_->strand, [this, download = std::move(download)]() mutable {
+        state_->Start(std::move(download));
+    });
+}
+
+NetworkMonitor::JsonParseResult NetworkMonitor::ParseJson (
+    std::string_view buffer
+)
+{
+    /* Parse the buffer in place, without copying it */
+    JsonParseResult result {};
     try
     {
-        std::ifstream file {src};
-        file >> parsed;
+        result.json = nlohmann::json::parse(buffer.begin(), buffer.end());
+        result.ok = true;
+    }
+    catch (const nlohmann::json::parse_error& e)
+    {
+        /* `byte` counts the characters read, including the one that failed */
+        result.errorOffset = std::min<size_t>(e.byte > 0 ? e.byte - 1 : 0, buffer.size());
+        result.error = e.what();
     }
-    catch(...)
+
+    return result;
+}
+
+NetworkMonitor::JsonParseResult NetworkMonitor::LoadJsonFile (
+    const std::filesystem::path& src
+)
+{
+    MappedFile file {};
+    if (!file.Open(src))
     {
-        /* Return an empty object */
+        JsonParseResult result {};
+        result.error = "Could not open " + src.string();
+        return result;
     }
-    
-    return parsed;
-}
\ No newline at end of file
+
+    return ParseJson(file.GetView());
+}
+
+nlohmann::json NetworkMonitor::ParseJsonFile (
+    const std::filesystem::path& src
+)
+{
+    auto result {LoadJsonFile(src)};
+    if (!result.ok)
+    {
+        return {};
+    }
+
+    return std::move(result.json);
+}
@@ -0,0 +1,61 @@
+#include "IdTable.h"
+
+#include <string>
+
+using NetworkMonitor::Handle;
+using NetworkMonitor::IdTable;
+
+Handle IdTable::Intern (
+    const std::string& id
+)
+{
+    auto [it, inserted] {handles_.emplace(id, static_cast<Handle>(ids_.size()))};
+    if (inserted)
+    {
+        ids_.push_back(id);
+    }
+
+    return it->second;
+}
+
+Handle IdTable::Find (
+    const std::string& id
+) const
+{
+    auto it {handles_.find(id)};
+    if (it == handles_.end())
+        return kInvalidHandle;
+
+    return it->second;
+}
+
+const std::string& IdTable::GetId (
+    Handle handle
+) const
+{
+    return ids_[handle];
+}
+
+void IdTable::Truncate (
+    size_t size
+)
+{
+    while (ids_.size() > size)
+    {
+        handles_.erase(ids_.back());
+        ids_.pop_back();
+    }
+}
+
+void IdTable::Reserve (
+    size_t size
+)
+{
+    ids_.reserve(size);
+    handles_.reserve(size);
+}
+
+size_t IdTable::Size() const
+{
+    return ids_.size();
+}
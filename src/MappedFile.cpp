@@ -0,0 +1,100 @@
+#include "MappedFile.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string_view>
+#include <utility>
+
+using NetworkMonitor::MappedFile;
+using NetworkMonitor::MappedFileAccess;
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile (
+    MappedFile&& moved
+) : mapping_ {std::exchange(moved.mapping_, nullptr)},
+    size_ {std::exchange(moved.size_, 0)},
+    open_ {std::exchange(moved.open_, false)}
+{}
+
+MappedFile& MappedFile::operator= (
+    MappedFile&& moved
+)
+{
+    if (this != &moved)
+    {
+        Close();
+        mapping_ = std::exchange(moved.mapping_, nullptr);
+        size_ = std::exchange(moved.size_, 0);
+        open_ = std::exchange(moved.open_, false);
+    }
+    return *this;
+}
+
+bool MappedFile::Open (
+    const std::filesystem::path& src,
+    MappedFileAccess access
+)
+{
+    Close();
+    const int fd {::open(src.c_str(), O_RDONLY)};
+    if (fd < 0)
+        return false;
+
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    /* mmap does not map empty files */
+    const auto size {static_cast<size_t>(info.st_size)};
+    void* mapping {nullptr};
+    if (size > 0)
+    {
+        mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    /* The mapping stays valid after closing the file */
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    if (mapping != nullptr && access == MappedFileAccess::Sequential)
+    {
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+    }
+    mapping_ = mapping;
+    size_ = size;
+    open_ = true;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mapping_ != nullptr)
+    {
+        ::munmap(mapping_, size_);
+    }
+    mapping_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+bool MappedFile::IsOpen() const
+{
+    return open_;
+}
+
+std::string_view MappedFile::GetView() const
+{
+    return {static_cast<const char*>(mapping_), size_};
+}
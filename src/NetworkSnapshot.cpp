@@ -0,0 +1,696 @@
+#include "MappedFile.h"
+#include "NetworkSnapshot.h"
+#include "TransportNetwork.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+using NetworkMonitor::Handle;
+using NetworkMonitor::MappedFile;
+using NetworkMonitor::MappedFileAccess;
+using NetworkMonitor::StationHandle;
+using NetworkMonitor::LineHandle;
+using NetworkMonitor::RouteHandle;
+using NetworkMonitor::NetworkGraphView;
+using NetworkMonitor::NetworkSnapshot;
+using NetworkMonitor::TransportNetwork;
+
+/* File format
+   The file starts with a fixed-size header followed by sections. Each section
+   is an array of 32-bit words or of records made of 32-bit words, and starts
+   at an 8-byte aligned offset recorded in the header. The checksum covers
+   the whole file, with the checksum field set to 0 */
+struct NetworkSnapshot::Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint64_t checksum;
+    std::uint64_t fileSize;
+
+    std::uint32_t nStrings;
+    std::uint32_t nStations;
+    std::uint32_t nLines;
+    std::uint32_t nRoutes;
+    std::uint32_t nRouteStops;
+    std::uint32_t nEdges;
+    std::uint32_t nRouteStopSlots;
+    std::uint32_t padding;
+
+    std::uint64_t strings;
+    std::uint64_t stringOffsets;
+    std::uint64_t stations;
+    std::uint64_t stationIndex;
+    std::uint64_t lines;
+    std::uint64_t lineIndex;
+    std::uint64_t routes;
+    std::uint64_t routeIndex;
+    std::uint64_t routeStops;
+    std::uint64_t routeTravelTimes;
+    std::uint64_t edgeOffsets;
+    std::uint64_t edges;
+    std::uint64_t stationStopOffsets;
+    std::uint64_t stationStops;
+    std::uint64_t routeStopSlotOffsets;
+    std::uint64_t routeStopSlots;
+};
+
+/* Station or line: strings in the string table */
+struct NetworkSnapshot::NamedRecord
+{
+    std::uint32_t id;
+    std::uint32_t name;
+};
+
+/* ID lookup entry. Index sections are sorted by ID */
+struct NetworkSnapshot::IndexRecord
+{
+    std::uint32_t id;
+    std::uint32_t handle;
+};
+
+struct NetworkSnapshot::RouteRecord
+{
+    std::uint32_t id;
+    std::uint32_t line;
+    std::uint32_t firstStop;
+    std::uint32_t nStops;
+};
+
+struct NetworkSnapshot::EdgeRecord
+{
+    std::uint32_t nextStop;
+    std::uint32_t route;
+    std::uint32_t travelTime;
+};
+
+struct NetworkSnapshot::StationStopRecord
+{
+    std::uint32_t route;
+    std::uint32_t stop;
+};
+
+/* Slot of a route stop position table, see NetworkGraphView */
+struct NetworkSnapshot::RouteStopSlotRecord
+{
+    std::uint32_t station;
+    std::uint32_t stop;
+};
+
+static constexpr char kMagic[8] {'N', 'M', 'S', 'N', 'A', 'P', '\0', '\0'};
+
+/* FNV-1a, 64 bits. Pass the previous hash to chain several buffers */
+static std::uint64_t Checksum (
+    const char* data,
+    size_t size,
+    std::uint64_t hash = 14695981039346656037ull
+)
+{
+    for (size_t idx {0}; idx < size; ++idx)
+    {
+        hash ^= static_cast<unsigned char>(data[idx]);
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/* Snapshot builder
+   Appends 8-byte aligned sections to an in-memory image of the file */
+class SnapshotBuilder
+{
+public:
+    SnapshotBuilder (
+        size_t headerSize
+    ) : image_(headerSize, 0)
+    {}
+
+    template <typename T>
+    std::uint64_t AddSection (
+        const std::vector<T>& values
+    )
+    {
+        image_.resize((image_.size() + 7) & ~size_t {7}, 0);
+        const auto offset {image_.size()};
+        const auto* bytes {reinterpret_cast<const char*>(values.data())};
+        image_.insert(image_.end(), bytes, bytes + values.size() * sizeof(T));
+
+        return offset;
+    }
+
+    std::uint32_t AddString (
+        std::string_view string
+    )
+    {
+        stringOffsets_.push_back(static_cast<std::uint32_t>(strings_.size()));
+        strings_.insert(strings_.end(), string.begin(), string.end());
+
+        return static_cast<std::uint32_t>(stringOffsets_.size() - 1);
+    }
+
+    std::vector<char>& GetStrings()
+    {
+        return strings_;
+    }
+
+    std::vector<std::uint32_t>& GetStringOffsets()
+    {
+        return stringOffsets_;
+    }
+
+    std::vector<char>& GetImage()
+    {
+        return image_;
+    }
+
+private:
+    std::vector<char> image_ {};
+    std::vector<char> strings_ {};
+    std::vector<std::uint32_t> stringOffsets_ {};
+};
+
+/* Public methods */
+NetworkSnapshot::NetworkSnapshot() = default;
+
+NetworkSnapshot::~NetworkSnapshot()
+{
+    Close();
+}
+
+NetworkSnapshot::NetworkSnapshot (
+    NetworkSnapshot&& moved
+)
+{
+    *this = std::move(moved);
+}
+
+NetworkSnapshot& NetworkSnapshot::operator= (
+    NetworkSnapshot&& moved
+)
+{
+    if (this != &moved)
+    {
+        Close();
+        file_ = std::move(moved.file_);
+        header_ = std::exchange(moved.header_, nullptr);
+        strings_ = moved.strings_;
+        stringOffsets_ = moved.stringOffsets_;
+        stations_ = moved.stations_;
+        stationIndex_ = moved.stationIndex_;
+        lines_ = moved.lines_;
+        lineIndex_ = moved.lineIndex_;
+        routes_ = moved.routes_;
+        routeIndex_ = moved.routeIndex_;
+        routeStops_ = moved.routeStops_;
+        routeTravelTimes_ = moved.routeTravelTimes_;
+        edgeOffsets_ = moved.edgeOffsets_;
+        edges_ = moved.edges_;
+        stationStopOffsets_ = moved.stationStopOffsets_;
+        stationStops_ = moved.stationStops_;
+        routeStopSlotOffsets_ = moved.routeStopSlotOffsets_;
+        routeStopSlots_ = moved.routeStopSlots_;
+    }
+
+    return *this;
+}
+
+bool NetworkSnapshot::Write (
+    const TransportNetwork& nw,
+    const std::filesystem::path& dst
+)
+{
+    using Index = std::uint32_t;
+    Header header {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(Header);
+    header.nStations = static_cast<std::uint32_t>(nw.stations_.size());
+    header.nLines = static_cast<std::uint32_t>(nw.lines_.size());
+    header.nRoutes = static_cast<std::uint32_t>(nw.routes_.size());
+    header.nRouteStops = static_cast<std::uint32_t>(nw.routeStops_.size());
+    header.nEdges = static_cast<std::uint32_t>(nw.edges_.size());
+    header.nRouteStopSlots = static_cast<std::uint32_t>(nw.routeStopSlots_.size());
+
+    SnapshotBuilder builder {sizeof(Header)};
+
+    /* Records and ID indices. The strings go to the string table */
+    auto makeIndex {[](const auto& records, auto getId) {
+        std::vector<IndexRecord> index(records.size());
+        for (Index handle {0}; handle < records.size(); ++handle)
+        {
+            index[handle] = IndexRecord {records[handle].id, handle};
+        }
+        std::sort(index.begin(), index.end(), [&getId](const auto& a, const auto& b) {
+            return getId(a.id) < getId(b.id);
+        });
+        return index;
+    }};
+    auto getString {[&builder](std::uint32_t string) {
+        const auto& offsets {builder.GetStringOffsets()};
+        const auto& strings {builder.GetStrings()};
+        const auto end {string + 1 < offsets.size() ? offsets[string + 1] : strings.size()};
+        return std::string_view {strings.data() + offsets[string], end - offsets[string]};
+    }};
+
+    std::vector<NamedRecord> stations(header.nStations);
+    for (Index station {0}; station < header.nStations; ++station)
+    {
+        stations[station].id = builder.AddString(nw.GetStationId(station));
+        stations[station].name = builder.AddString(nw.stations_[station].name);
+    }
+    std::vector<NamedRecord> lines(header.nLines);
+    for (Index line {0}; line < header.nLines; ++line)
+    {
+        lines[line].id = builder.AddString(nw.GetLineId(line));
+        lines[line].name = builder.AddString(nw.lines_[line].name);
+    }
+    std::vector<RouteRecord> routes(header.nRoutes);
+    for (Index route {0}; route < header.nRoutes; ++route)
+    {
+        const auto& routeInternal {nw.routes_[route]};
+        routes[route] = RouteRecord {
+            builder.AddString(nw.GetRouteId(route)),
+            routeInternal.line,
+            routeInternal.firstStop,
+            routeInternal.nStops
+        };
+    }
+    const auto stationIndex {makeIndex(stations, getString)};
+    const auto lineIndex {makeIndex(lines, getString)};
+    const auto routeIndex {makeIndex(routes, getString)};
+
+    std::vector<EdgeRecord> edges(header.nEdges);
+    for (size_t edge {0}; edge < edges.size(); ++edge)
+    {
+        const auto& graphEdge {nw.edges_[edge]};
+        edges[edge] = EdgeRecord {graphEdge.nextStop, graphEdge.route, graphEdge.travelTime};
+    }
+    std::vector<StationStopRecord> stationStops(nw.stationStops_.size());
+    for (size_t stop {0}; stop < stationStops.size(); ++stop)
+    {
+        const auto& stationStop {nw.stationStops_[stop]};
+        stationStops[stop] = StationStopRecord {stationStop.route, stationStop.stop};
+    }
+    std::vector<std::uint32_t> routeTravelTimes(
+        nw.routeTravelTimes_.begin(), nw.routeTravelTimes_.end()
+    );
+    std::vector<RouteStopSlotRecord> routeStopSlots(header.nRouteStopSlots);
+    for (size_t slot {0}; slot < routeStopSlots.size(); ++slot)
+    {
+        const auto& routeStopSlot {nw.routeStopSlots_[slot]};
+        routeStopSlots[slot] = RouteStopSlotRecord {routeStopSlot.station, routeStopSlot.stop};
+    }
+
+    /* Sections */
+    builder.GetStringOffsets().push_back(static_cast<std::uint32_t>(builder.GetStrings().size()));
+    header.nStrings = static_cast<std::uint32_t>(builder.GetStringOffsets().size() - 1);
+    header.strings = builder.AddSection(builder.GetStrings());
+    header.stringOffsets = builder.AddSection(builder.GetStringOffsets());
+    header.stations = builder.AddSection(stations);
+    header.stationIndex = builder.AddSection(stationIndex);
+    header.lines = builder.AddSection(lines);
+    header.lineIndex = builder.AddSection(lineIndex);
+    header.routes = builder.AddSection(routes);
+    header.routeIndex = builder.AddSection(routeIndex);
+    header.routeStops = builder.AddSection(nw.routeStops_);
+    header.routeTravelTimes = builder.AddSection(routeTravelTimes);
+    header.edgeOffsets = builder.AddSection(nw.edgeOffsets_);
+    header.edges = builder.AddSection(edges);
+    header.stationStopOffsets = builder.AddSection(nw.stationStopOffsets_);
+    header.stationStops = builder.AddSection(stationStops);
+    header.routeStopSlotOffsets = builder.AddSection(nw.routeStopSlotOffsets_);
+    header.routeStopSlots = builder.AddSection(routeStopSlots);
+
+    /* Finish the header. The checksum covers the header too, with the
+       checksum field itself set to 0 */
+    auto& image {builder.GetImage()};
+    header.fileSize = image.size();
+    header.checksum = 0;
+    header.checksum = Checksum(
+        image.data() + sizeof(Header),
+        image.size() - sizeof(Header),
+        Checksum(reinterpret_cast<const char*>(&header), sizeof(Header))
+    );
+    std::memcpy(image.data(), &header, sizeof(Header));
+
+    /* Readers may have the current snapshot mapped: never rewrite it in
+       place. Write a new file next to it and rename it over the old one, so
+       they keep their mapping of the old inode */
+    auto tmp {dst};
+    tmp += ".tmp";
+    bool ok {false};
+    {
+        std::ofstream file {tmp, std::ios::binary | std::ios::trunc};
+        file.write(image.data(), static_cast<std::streamsize>(image.size()));
+        file.flush();
+        ok = static_cast<bool>(file);
+    }
+    std::error_code ec {};
+    if (ok)
+    {
+        std::filesystem::rename(tmp, dst, ec);
+        ok = !ec;
+    }
+    if (!ok)
+    {
+        std::filesystem::remove(tmp, ec);
+    }
+
+    return ok;
+}
+
+bool NetworkSnapshot::ConvertLayout (
+    const std::filesystem::path& layout,
+    const std::filesystem::path& dst
+)
+{
+    TransportNetwork nw {};
+    if (!nw.FromJson(layout))
+        return false;
+
+    return Write(nw, dst);
+}
+
+bool NetworkSnapshot::Open (
+    const std::filesystem::path& src,
+    bool verifyChecksum
+)
+{
+    /* Queries read the snapshot in any order, for as long as it is open */
+    MappedFile file {};
+    if (!file.Open(src, MappedFileAccess::Normal) || file.GetView().size() < sizeof(Header))
+        return false;
+
+    /* Validate the header before trusting any offset */
+    const auto size {file.GetView().size()};
+    const auto* data {file.GetView().data()};
+    const auto* header {reinterpret_cast<const Header*>(data)};
+    bool ok {
+        std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0
+        && header->version == kVersion
+        && header->headerSize == sizeof(Header)
+        && header->fileSize == size
+    };
+    auto checkSection {[size, &ok](std::uint64_t offset, std::uint64_t count, size_t recordSize) {
+        ok = ok && offset % 8 == 0 && offset <= size && count * recordSize <= size - offset;
+    }};
+    checkSection(header->strings, 0, 1);
+    checkSection(header->stringOffsets, header->nStrings + 1ull, sizeof(std::uint32_t));
+    checkSection(header->stations, header->nStations, sizeof(NamedRecord));
+    checkSection(header->stationIndex, header->nStations, sizeof(IndexRecord));
+    checkSection(header->lines, header->nLines, sizeof(NamedRecord));
+    checkSection(header->lineIndex, header->nLines, sizeof(IndexRecord));
+    checkSection(header->routes, header->nRoutes, sizeof(RouteRecord));
+    checkSection(header->routeIndex, header->nRoutes, sizeof(IndexRecord));
+    checkSection(header->routeStops, header->nRouteStops, sizeof(std::uint32_t));
+    checkSection(header->routeTravelTimes, header->nRouteStops, sizeof(std::uint32_t));
+    checkSection(header->edgeOffsets, header->nStations + 1ull, sizeof(std::uint32_t));
+    checkSection(header->edges, header->nEdges, sizeof(EdgeRecord));
+    checkSection(header->stationStopOffsets, header->nStations + 1ull, sizeof(std::uint32_t));
+    checkSection(header->stationStops, header->nRouteStops, sizeof(StationStopRecord));
+    checkSection(header->routeStopSlotOffsets, header->nRoutes + 1ull, sizeof(std::uint32_t));
+    checkSection(header->routeStopSlots, header->nRouteStopSlots, sizeof(RouteStopSlotRecord));
+    if (ok && verifyChecksum)
+    {
+        auto headerCopy {*header};
+        headerCopy.checksum = 0;
+        ok = Checksum(
+            data + sizeof(Header),
+            size - sizeof(Header),
+            Checksum(reinterpret_cast<const char*>(&headerCopy), sizeof(Header))
+        ) == header->checksum;
+    }
+
+    /* The checksum only catches accidents. Check every offset and handle
+       that the queries follow, so that even a crafted file cannot make them
+       read out of the mapping */
+    if (ok)
+    {
+        const auto nStrings {header->nStrings};
+        const auto nStations {header->nStations};
+        const auto nLines {header->nLines};
+        const auto nRoutes {header->nRoutes};
+        const auto nRouteStops {header->nRouteStops};
+        /* Offset arrays start at 0, never decrease and end at their section
+           size */
+        auto checkOffsets {[&ok](const std::uint32_t* offsets, size_t count, std::uint64_t end) {
+            ok = ok && offsets[0] == 0 && offsets[count] == end;
+            for (size_t idx {0}; ok && idx < count; ++idx)
+            {
+                ok = offsets[idx] <= offsets[idx + 1];
+            }
+        }};
+        const auto* stringOffsets {reinterpret_cast<const std::uint32_t*>(data + header->stringOffsets)};
+        ok = stringOffsets[nStrings] <= size - header->strings;
+        checkOffsets(stringOffsets, nStrings, stringOffsets[nStrings]);
+        checkOffsets(
+            reinterpret_cast<const std::uint32_t*>(data + header->edgeOffsets),
+            nStations,
+            header->nEdges
+        );
+        checkOffsets(
+            reinterpret_cast<const std::uint32_t*>(data + header->stationStopOffsets),
+            nStations,
+            nRouteStops
+        );
+        checkOffsets(
+            reinterpret_cast<const std::uint32_t*>(data + header->routeStopSlotOffsets),
+            nRoutes,
+            header->nRouteStopSlots
+        );
+
+        auto checkNamed {[&ok, nStrings](const NamedRecord* records, size_t count) {
+            for (size_t idx {0}; ok && idx < count; ++idx)
+            {
+                ok = records[idx].id < nStrings && records[idx].name < nStrings;
+            }
+        }};
+        checkNamed(reinterpret_cast<const NamedRecord*>(data + header->stations), nStations);
+        checkNamed(reinterpret_cast<const NamedRecord*>(data + header->lines), nLines);
+
+        auto checkIndex {[&ok, nStrings](const IndexRecord* records, size_t count) {
+            for (size_t idx {0}; ok && idx < count; ++idx)
+            {
+                ok = records[idx].id < nStrings && records[idx].handle < count;
+            }
+        }};
+        checkIndex(reinterpret_cast<const IndexRecord*>(data + header->stationIndex), nStations);
+        checkIndex(reinterpret_cast<const IndexRecord*>(data + header->lineIndex), nLines);
+        checkIndex(reinterpret_cast<const IndexRecord*>(data + header->routeIndex), nRoutes);
+
+        const auto* routes {reinterpret_cast<const RouteRecord*>(data + header->routes)};
+        for (size_t route {0}; ok && route < nRoutes; ++route)
+        {
+            const auto& record {routes[route]};
+            ok = record.id < nStrings
+                && record.line < nLines
+                && static_cast<std::uint64_t>(record.firstStop) + record.nStops <= nRouteStops;
+        }
+        const auto* routeStops {reinterpret_cast<const std::uint32_t*>(data + header->routeStops)};
+        for (size_t stop {0}; ok && stop < nRouteStops; ++stop)
+        {
+            ok = routeStops[stop] < nStations;
+        }
+        const auto* edges {reinterpret_cast<const EdgeRecord*>(data + header->edges)};
+        for (size_t edge {0}; ok && edge < header->nEdges; ++edge)
+        {
+            ok = edges[edge].nextStop < nStations && edges[edge].route < nRoutes;
+        }
+        const auto* stationStops {reinterpret_cast<const StationStopRecord*>(data + header->stationStops)};
+        for (size_t stop {0}; ok && stop < nRouteStops; ++stop)
+        {
+            ok = stationStops[stop].route < nRoutes && stationStops[stop].stop < nRouteStops;
+        }
+        const auto* routeStopSlots {reinterpret_cast<const RouteStopSlotRecord*>(data + header->routeStopSlots)};
+        for (size_t slot {0}; ok && slot < header->nRouteStopSlots; ++slot)
+        {
+            const auto& record {routeStopSlots[slot]};
+            ok = (record.station == kInvalidHandle && record.stop == kInvalidHandle)
+                || (record.station < nStations
+                    && (record.stop < nRouteStops || record.stop == kRepeatedStop));
+        }
+    }
+    if (!ok)
+        return false;
+
+    /* Moving the file keeps its mapping in place */
+    Close();
+    file_ = std::move(file);
+    header_ = header;
+    strings_ = data + header->strings;
+    stringOffsets_ = reinterpret_cast<const std::uint32_t*>(data + header->stringOffsets);
+    stations_ = reinterpret_cast<const NamedRecord*>(data + header->stations);
+    stationIndex_ = reinterpret_cast<const IndexRecord*>(data + header->stationIndex);
+    lines_ = reinterpret_cast<const NamedRecord*>(data + header->lines);
+    lineIndex_ = reinterpret_cast<const IndexRecord*>(data + header->lineIndex);
+    routes_ = reinterpret_cast<const RouteRecord*>(data + header->routes);
+    routeIndex_ = reinterpret_cast<const IndexRecord*>(data + header->routeIndex);
+    routeStops_ = reinterpret_cast<const std::uint32_t*>(data + header->routeStops);
+    routeTravelTimes_ = reinterpret_cast<const std::uint32_t*>(data + header->routeTravelTimes);
+    edgeOffsets_ = reinterpret_cast<const std::uint32_t*>(data + header->edgeOffsets);
+    edges_ = reinterpret_cast<const EdgeRecord*>(data + header->edges);
+    stationStopOffsets_ = reinterpret_cast<const std::uint32_t*>(data + header->stationStopOffsets);
+    stationStops_ = reinterpret_cast<const StationStopRecord*>(data + header->stationStops);
+    routeStopSlotOffsets_ = reinterpret_cast<const std::uint32_t*>(data + header->routeStopSlotOffsets);
+    routeStopSlots_ = reinterpret_cast<const RouteStopSlotRecord*>(data + header->routeStopSlots);
+
+    return true;
+}
+
+size_t NetworkSnapshot::GetStationCount() const
+{
+    return header_ == nullptr ? 0 : header_->nStations;
+}
+
+StationHandle NetworkSnapshot::GetStationHandle (
+    std::string_view station
+) const
+{
+    return FindId(stationIndex_, GetStationCount(), station);
+}
+
+LineHandle NetworkSnapshot::GetLineHandle (
+    std::string_view line
+) const
+{
+    return FindId(lineIndex_, header_ == nullptr ? 0 : header_->nLines, line);
+}
+
+RouteHandle NetworkSnapshot::GetRouteHandle (
+    std::string_view line,
+    std::string_view route
+) const
+{
+    const auto lineHandle {GetLineHandle(line)};
+    if (lineHandle == kInvalidHandle)
+        return kInvalidHandle;
+
+    const auto routeHandle {FindId(routeIndex_, header_->nRoutes, route)};
+    if (routeHandle == kInvalidHandle || routes_[routeHandle].line != lineHandle)
+        return kInvalidHandle;
+
+    return routeHandle;
+}
+
+std::string_view NetworkSnapshot::GetStationId (
+    StationHandle station
+) const
+{
+    return GetString(stations_[station].id);
+}
+
+std::string_view NetworkSnapshot::GetStationName (
+    StationHandle station
+) const
+{
+    return GetString(stations_[station].name);
+}
+
+std::string_view NetworkSnapshot::GetRouteId (
+    RouteHandle route
+) const
+{
+    return GetString(routes_[route].id);
+}
+
+std::vector<RouteHandle> NetworkSnapshot::GetRoutesServingStation (
+    StationHandle station
+) const
+{
+    std::vector<RouteHandle> routes {};
+    if (station >= GetStationCount())
+        return routes;
+
+    /* The stops served at a station are sorted by route, so a route that
+       stops twice at the station, like a loop route at its terminus, repeats
+       the last entry. List it once, as TransportNetwork does */
+    for (auto stop {stationStopOffsets_[station]}; stop < stationStopOffsets_[station + 1]; ++stop)
+    {
+        const auto route {stationStops_[stop].route};
+        if (routes.empty() || routes.back() != route)
+        {
+            routes.push_back(route);
+        }
+    }
+
+    return routes;
+}
+
+unsigned int NetworkSnapshot::GetTravelTime (
+    StationHandle stationA,
+    StationHandle stationB
+) const
+{
+    return GetGraphView().GetTravelTime(stationA, stationB);
+}
+
+unsigned int NetworkSnapshot::GetTravelTime (
+    RouteHandle route,
+    StationHandle stationA,
+    StationHandle stationB
+) const
+{
+    return GetGraphView().GetTravelTime(route, stationA, stationB);
+}
+
+/* Private methods */
+std::string_view NetworkSnapshot::GetString (
+    std::uint32_t string
+) const
+{
+    return std::string_view {
+        strings_ + stringOffsets_[string],
+        stringOffsets_[string + 1] - stringOffsets_[string]
+    };
+}
+
+Handle NetworkSnapshot::FindId (
+    const IndexRecord* index,
+    size_t nRecords,
+    std::string_view id
+) const
+{
+    if (nRecords == 0)
+        return kInvalidHandle;
+
+    const auto* last {index + nRecords};
+    const auto* record {std::lower_bound(index, last, id, [this](const auto& record, auto id) {
+        return GetString(record.id) < id;
+    })};
+    if (record == last || GetString(record->id) != id)
+        return kInvalidHandle;
+
+    return record->handle;
+}
+
+NetworkGraphView<std::uint32_t, NetworkSnapshot::EdgeRecord,
+                 NetworkSnapshot::StationStopRecord, std::uint32_t,
+                 NetworkSnapshot::RouteStopSlotRecord>
+NetworkSnapshot::GetGraphView() const
+{
+    return NetworkGraphView<std::uint32_t, EdgeRecord, StationStopRecord, std::uint32_t, RouteStopSlotRecord> {
+        GetStationCount(),
+        header_ == nullptr ? 0 : header_->nRoutes,
+        edgeOffsets_,
+        edges_,
+        stationStopOffsets_,
+        stationStops_,
+        routeTravelTimes_,
+        routeStopSlotOffsets_,
+        routeStopSlots_
+    };
+}
+
+void NetworkSnapshot::Close()
+{
+    file_.Close();
+    header_ = nullptr;
+}
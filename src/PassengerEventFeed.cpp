@@ -0,0 +1,49 @@
+#include "PassengerEventFeed.h"
+#include "PassengerEventPipeline.h"
+#include "StompClient.h"
+#include "StompFrame.h"
+
+#include <boost/system/error_code.hpp>
+
+#include <functional>
+#include <string>
+#include <utility>
+
+using NetworkMonitor::PassengerEventPipeline;
+using NetworkMonitor::StompAckMode;
+using NetworkMonitor::StompClient;
+using NetworkMonitor::StompClientError;
+using NetworkMonitor::StompFrame;
+
+std::function<void (boost::system::error_code, const StompFrame&)> NetworkMonitor::MakePassengerEventHandler (
+    PassengerEventPipeline& pipeline
+)
+{
+    return [&pipeline](auto ec, const StompFrame& frame) {
+        if (ec == StompClientError::MessageGap)
+        {
+            pipeline.RecordGap();
+            return;
+        }
+        if (ec)
+            return;
+
+        /* Push copies the body, whose view is only valid during the call */
+        pipeline.Push(frame.GetBody());
+    };
+}
+
+std::string NetworkMonitor::SubscribePassengerEvents (
+    StompClient& client,
+    PassengerEventPipeline& pipeline,
+    const std::string& destination,
+    std::function<void (boost::system::error_code, std::string&&)> onSubscribe
+)
+{
+    return client.Subscribe(
+        destination,
+        StompAckMode::Auto,
+        std::move(onSubscribe),
+        MakePassengerEventHandler(pipeline)
+    );
+}
@@ -0,0 +1,362 @@
+#include "PassengerEventPipeline.h"
+#include "TransportNetwork.h"
+#include "VersionedTransportNetwork.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using NetworkMonitor::FullRingPolicy;
+using NetworkMonitor::IngestionOptions;
+using NetworkMonitor::IngestionStats;
+using NetworkMonitor::PassengerEvent;
+using NetworkMonitor::PassengerEventGenerator;
+using NetworkMonitor::PassengerEventPipeline;
+using NetworkMonitor::StageLatency;
+using NetworkMonitor::TransportNetwork;
+using NetworkMonitor::VersionedTransportNetwork;
+
+static std::int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+/* Relaxed atomic max */
+template <typename T>
+static void StoreMax (
+    std::atomic<T>& target,
+    T value
+)
+{
+    auto current {target.load(std::memory_order_relaxed)};
+    while (current < value
+           && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+/* Free functions */
+bool NetworkMonitor::ParsePassengerEvent (
+    std::string_view json,
+    PassengerEvent& event
+)
+{
+    const auto parsed = nlohmann::json::parse(json.begin(), json.end(), nullptr, false);
+    if (parsed.is_discarded() || !parsed.is_object())
+        return false;
+
+    const auto type {parsed.find("passenger_event")};
+    const auto station {parsed.find("station_id")};
+    if (type == parsed.end() || !type->is_string()
+        || station == parsed.end() || !station->is_string())
+        return false;
+
+    const auto& typeName {type->get_ref<const std::string&>()};
+    if (typeName == "in")
+    {
+        event.type = PassengerEvent::Type::In;
+    }
+    else if (typeName == "out")
+    {
+        event.type = PassengerEvent::Type::Out;
+    }
+    else
+    {
+        return false;
+    }
+    event.stationId = station->get<std::string>();
+    return true;
+}
+
+/* PassengerEventPipeline */
+PassengerEventPipeline::PassengerEventPipeline (
+    TransportNetwork& network,
+    const IngestionOptions& options
+) : PassengerEventPipeline(
+        [&network](const PassengerEvent* events, size_t nEvents) {
+            return network.RecordPassengerEvents(events, nEvents);
+        },
+        options
+    )
+{}
+
+PassengerEventPipeline::PassengerEventPipeline (
+    VersionedTransportNetwork& network,
+    const IngestionOptions& options
+) : PassengerEventPipeline(
+        [&network](const PassengerEvent* events, size_t nEvents) {
+            return network.Acquire()->RecordPassengerEvents(events, nEvents);
+        },
+        options
+    )
+{}
+
+PassengerEventPipeline::PassengerEventPipeline (
+    Sink sink,
+    const IngestionOptions& options
+) : options_ {options},
+    sink_ {std::move(sink)},
+    ring_ {options.ringCapacity}
+{}
+
+PassengerEventPipeline::~PassengerEventPipeline()
+{
+    Stop();
+}
+
+void PassengerEventPipeline::Start()
+{
+    if (running_.exchange(true))
+        return;
+
+    stopping_ = false;
+    const auto nWorkers {std::max(options_.nWorkers, 1u)};
+    for (unsigned int worker {0}; worker < nWorkers; ++worker)
+    {
+        workers_.emplace_back([this]() {
+            RunWorker();
+        });
+    }
+}
+
+void PassengerEventPipeline::Stop()
+{
+    stopping_ = true;
+    for (auto& worker: workers_)
+    {
+        worker.join();
+    }
+    workers_.clear();
+    running_ = false;
+
+    /* A concurrent Push may have checked `stopping_` before we set it, and
+       still be queueing its event */
+    while (pushing_.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    /* Record what a concurrent Push queued after the workers left */
+    std::vector<RawEvent> raw {};
+    std::vector<PassengerEvent> events {};
+    while (ProcessBatch(raw, events))
+    {
+    }
+}
+
+bool PassengerEventPipeline::Push (
+    std::string_view event
+)
+{
+    received_.fetch_add(1, std::memory_order_relaxed);
+
+    /* Stop waits for the pushes in progress. Both sides use sequentially
+       consistent operations: either Stop sees this push, or the push sees
+       `stopping_` */
+    pushing_.fetch_add(1);
+    const auto pushed {Enqueue(event)};
+    pushing_.fetch_sub(1, std::memory_order_release);
+    return pushed;
+}
+
+void PassengerEventPipeline::RecordGap()
+{
+    gaps_.fetch_add(1, std::memory_order_relaxed);
+}
+
+IngestionStats PassengerEventPipeline::GetStats() const
+{
+    IngestionStats stats {};
+    stats.received = received_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.parseErrors = parseErrors_.load(std::memory_order_relaxed);
+    stats.applied = applied_.load(std::memory_order_relaxed);
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+    stats.gaps = gaps_.load(std::memory_order_relaxed);
+    stats.queueDepth = ring_.Size();
+    stats.maxQueueDepth = maxQueueDepth_.load(std::memory_order_relaxed);
+    stats.queueLatency = queueLatency_.Load();
+    stats.parseLatency = parseLatency_.Load();
+    stats.applyLatency = applyLatency_.Load();
+    return stats;
+}
+
+/* Private methods */
+void PassengerEventPipeline::AtomicLatency::Add (
+    std::uint64_t count,
+    std::uint64_t totalNs,
+    std::uint64_t maxNs
+)
+{
+    this->count.fetch_add(count, std::memory_order_relaxed);
+    this->totalNs.fetch_add(totalNs, std::memory_order_relaxed);
+    StoreMax(this->maxNs, maxNs);
+}
+
+StageLatency PassengerEventPipeline::AtomicLatency::Load() const
+{
+    return StageLatency {
+        count.load(std::memory_order_relaxed),
+        totalNs.load(std::memory_order_relaxed),
+        maxNs.load(std::memory_order_relaxed)
+    };
+}
+
+bool PassengerEventPipeline::Enqueue (
+    std::string_view event
+)
+{
+    if (stopping_.load())
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    RawEvent raw {std::string {event}, NowNs()};
+    switch (options_.fullRingPolicy)
+    {
+    case FullRingPolicy::Block:
+    {
+        while (!ring_.TryPush(raw))
+        {
+            if (stopping_.load(std::memory_order_relaxed))
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        break;
+    }
+    case FullRingPolicy::DropOldest:
+    {
+        RawEvent oldest {};
+        while (!ring_.TryPush(raw))
+        {
+            if (ring_.TryPop(oldest))
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        break;
+    }
+    case FullRingPolicy::CountAndDrop:
+    default:
+    {
+        if (!ring_.TryPush(raw))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        break;
+    }
+    }
+
+    StoreMax(maxQueueDepth_, ring_.Size());
+    return true;
+}
+
+void PassengerEventPipeline::RunWorker()
+{
+    std::vector<RawEvent> raw {};
+    std::vector<PassengerEvent> events {};
+    raw.reserve(options_.batchSize);
+    events.reserve(options_.batchSize);
+    while (true)
+    {
+        if (ProcessBatch(raw, events))
+            continue;
+
+        /* The ring was empty. Only leave once stopping, so that the events
+           queued before Stop are all recorded */
+        if (stopping_.load(std::memory_order_relaxed))
+            break;
+        std::this_thread::sleep_for(options_.idleWait);
+    }
+}
+
+bool PassengerEventPipeline::ProcessBatch (
+    std::vector<RawEvent>& raw,
+    std::vector<PassengerEvent>& events
+)
+{
+    raw.clear();
+    RawEvent item {};
+    const auto batchSize {std::max<size_t>(options_.batchSize, 1)};
+    while (raw.size() < batchSize && ring_.TryPop(item))
+    {
+        raw.push_back(std::move(item));
+    }
+    if (raw.empty())
+        return false;
+
+    /* Queue stage */
+    const auto dequeuedNs {NowNs()};
+    std::uint64_t queueTotalNs {0};
+    std::uint64_t queueMaxNs {0};
+    for (const auto& event: raw)
+    {
+        const auto latency {static_cast<std::uint64_t>(dequeuedNs - event.enqueuedNs)};
+        queueTotalNs += latency;
+        queueMaxNs = std::max(queueMaxNs, latency);
+    }
+    queueLatency_.Add(raw.size(), queueTotalNs, queueMaxNs);
+
+    /* Parse stage */
+    events.resize(raw.size());
+    size_t nEvents {0};
+    for (const auto& event: raw)
+    {
+        if (ParsePassengerEvent(event.payload, events[nEvents]))
+        {
+            ++nEvents;
+        }
+    }
+    const auto parsedNs {NowNs()};
+    parseErrors_.fetch_add(raw.size() - nEvents, std::memory_order_relaxed);
+    const auto parseNs {static_cast<std::uint64_t>(parsedNs - dequeuedNs)};
+    parseLatency_.Add(1, parseNs, parseNs);
+
+    /* Apply stage */
+    const auto rejected {sink_(events.data(), nEvents)};
+    const auto applyNs {static_cast<std::uint64_t>(NowNs() - parsedNs)};
+    applyLatency_.Add(1, applyNs, applyNs);
+    applied_.fetch_add(nEvents - rejected, std::memory_order_relaxed);
+    rejected_.fetch_add(rejected, std::memory_order_relaxed);
+
+    return true;
+}
+
+/* PassengerEventGenerator */
+PassengerEventGenerator::PassengerEventGenerator (
+    std::vector<Id> stations,
+    unsigned int seed
+) : stations_ {std::move(stations)},
+    rng_ {seed}
+{}
+
+std::string_view PassengerEventGenerator::Next (
+    PassengerEvent& event
+)
+{
+    event.stationId = stations_[rng_() % stations_.size()];
+    event.type = rng_() % 2 == 0 ? PassengerEvent::Type::In : PassengerEvent::Type::Out;
+
+    buffer_.clear();
+    buffer_ += R"({"datetime":"2020-11-01T07:18:50.234000Z","passenger_event":")";
+    buffer_ += event.type == PassengerEvent::Type::In ? "in" : "out";
+    buffer_ += R"(","station_id":")";
+    buffer_ += event.stationId;
+    buffer_ += R"("})";
+    return buffer_;
+}
@@ -0,0 +1,407 @@
+#include "StompClient.h"
+#include "StompFrame.h"
+#include "WebSocketClient.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <charconv>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using NetworkMonitor::StompAckMode;
+using NetworkMonitor::StompClient;
+using NetworkMonitor::StompClientError;
+using NetworkMonitor::StompCommand;
+using NetworkMonitor::StompError;
+using NetworkMonitor::StompFrame;
+using NetworkMonitor::WebSocketClientMetrics;
+
+static void Log (const std::string& where, std::string_view what)
+{
+    std::cerr << "[" << std::setw(20) << where << "] " << what << std::endl;
+}
+
+namespace
+{
+    class StompClientErrorCategory: public boost::system::error_category
+    {
+    public:
+        const char* name() const noexcept override
+        {
+            return "StompClient";
+        }
+
+        std::string message(int ev) const override
+        {
+            switch (static_cast<StompClientError>(ev))
+            {
+            case StompClientError::Ok:
+                return "Ok";
+            case StompClientError::CouldNotParseFrame:
+                return "Could not parse the STOMP frame";
+            case StompClientError::ConnectRejected:
+                return "The server rejected the STOMP connection";
+            case StompClientError::ServerError:
+                return "The server sent an ERROR frame";
+            case StompClientError::UnexpectedFrame:
+                return "Unexpected STOMP frame";
+            case StompClientError::MessageGap:
+                return "Messages may have been lost while reconnecting";
+            default:
+                return "Unknown StompClient error";
+            }
+        }
+    };
+}   /* namespace */
+
+/* Free functions */
+const boost::system::error_category& NetworkMonitor::GetStompClientErrorCategory()
+{
+    static const StompClientErrorCategory category {};
+    return category;
+}
+
+boost::system::error_code NetworkMonitor::make_error_code (
+    StompClientError error
+)
+{
+    return {static_cast<int>(error), GetStompClientErrorCategory()};
+}
+
+/* Public methods */
+StompClient::StompClient (
+    const std::string& url,
+    const std::string& endpoint,
+    const std::string& port,
+    boost::asio::io_context& ioc,
+    boost::asio::ssl::context& ctx,
+    const SendQueueOptions& sendOptions,
+    const StreamOptions& streamOptions
+) : url_ {url},
+    ws_ {url, endpoint, port, ioc, ctx, sendOptions, streamOptions}
+{}
+
+void StompClient::Connect (
+    const std::string& username,
+    const std::string& password,
+    std::function<void (boost::system::error_code)> onConnect,
+    std::function<void (boost::system::error_code)> onDisconnect
+)
+{
+    username_ = username;
+    password_ = password;
+    connected_ = false;
+    hasConnected_ = false;
+    onConnect_ = onConnect;
+    onDisconnect_ = onDisconnect;
+
+    ws_.ConnectWithMessageView(
+        [this](auto ec) {
+            OnWsConnect(ec);
+        },
+        [this](auto ec, auto message) {
+            OnWsMessage(ec, message);
+        },
+        [this](auto ec) {
+            connected_ = false;
+            if (onDisconnect_)
+            {
+                onDisconnect_(ec);
+            }
+        }
+    );
+}
+
+std::string StompClient::Subscribe (
+    const std::string& destination,
+    StompAckMode ackMode,
+    std::function<void (boost::system::error_code, std::string&&)> onSubscribe,
+    std::function<void (boost::system::error_code, const StompFrame&)> onMessage
+)
+{
+    auto id {std::to_string(subscriptions_.size())};
+    subscriptions_.push_back({
+        destination, ackMode, std::move(onSubscribe), std::move(onMessage)
+    });
+    SendSubscribe(id, true);
+    return id;
+}
+
+void StompClient::SetReconnectOptions (
+    const ReconnectOptions& options
+)
+{
+    ws_.SetReconnectOptions(options);
+}
+
+WebSocketClientMetrics StompClient::GetMetrics() const
+{
+    return ws_.GetMetrics();
+}
+
+void StompClient::Ack (
+    std::string_view ackId,
+    std::function<void (boost::system::error_code)> onAck
+)
+{
+    std::string frame {};
+    SerializeStompFrame(frame, StompCommand::Ack, {
+        {"id", ackId},
+    });
+    SendFrame(std::move(frame), std::move(onAck));
+}
+
+void StompClient::Close (
+    std::function<void (boost::system::error_code)> onClose
+)
+{
+    std::string frame {};
+    SerializeStompFrame(frame, StompCommand::Disconnect, {});
+    SendFrame(std::move(frame), [this, onClose](auto ec) {
+        connected_ = false;
+        if (ec)
+        {
+            Log("Close", ec.message());
+        }
+        ws_.Close(onClose);
+    });
+}
+
+/* Private methods */
+void StompClient::OnWsConnect (
+    const boost::system::error_code& ec
+)
+{
+    if (ec)
+    {
+        OnSessionFailed(ec);
+        return;
+    }
+
+    std::string frame {};
+    SerializeStompFrame(frame, StompCommand::Stomp, {
+        {"accept-version", "1.2"},
+        {"host", url_},
+        {"login", username_},
+        {"passcode", password_},
+    });
+    SendFrame(std::move(frame), [this](auto ec) {
+        if (ec)
+        {
+            OnSessionFailed(ec);
+        }
+    });
+}
+
+void StompClient::OnWsMessage (
+    const boost::system::error_code& ec,
+    std::string_view message
+)
+{
+    if (ec)
+    {
+        return;
+    }
+
+    /* A WebSocket message may carry several frames */
+    while (!message.empty())
+    {
+        const auto error {frame_.Parse(message)};
+        if (error == StompError::EmptyFrame)
+        {
+            /* Heart-beat */
+            break;
+        }
+        if (error != StompError::Ok)
+        {
+            Log("OnWsMessage", ToString(error));
+            if (!connected_)
+            {
+                OnSessionFailed(StompClientError::CouldNotParseFrame);
+            }
+            break;
+        }
+        OnFrame(frame_);
+        message.remove_prefix(frame_.GetSize());
+    }
+}
+
+void StompClient::OnSessionFailed (
+    const boost::system::error_code& ec
+)
+{
+    /* After a reconnection the user already had a session: the failure ends
+       it rather than the connection attempt */
+    const auto& callback {hasConnected_ ? onDisconnect_ : onConnect_};
+    if (callback)
+    {
+        callback(ec);
+    }
+}
+
+void StompClient::OnFrame (
+    const StompFrame& frame
+)
+{
+    switch (frame.GetCommand())
+    {
+    case StompCommand::Connected:
+    {
+        if (connected_)
+        {
+            break;
+        }
+        connected_ = true;
+
+        /* First session: hand over to the user */
+        if (!hasConnected_)
+        {
+            hasConnected_ = true;
+            if (onConnect_)
+            {
+                onConnect_(StompClientError::Ok);
+            }
+            break;
+        }
+
+        /* Reconnected: renew the subscriptions, and tell each consumer that
+           it may have missed messages */
+        static const StompFrame emptyFrame {};
+        for (size_t idx {0}; idx < subscriptions_.size(); ++idx)
+        {
+            SendSubscribe(std::to_string(idx), false);
+            if (subscriptions_[idx].onMessage)
+            {
+                subscriptions_[idx].onMessage(StompClientError::MessageGap, emptyFrame);
+            }
+        }
+        break;
+    }
+    case StompCommand::Error:
+    {
+        Log("OnFrame", frame.GetHeaderValue("message"));
+        if (!connected_)
+        {
+            OnSessionFailed(StompClientError::ConnectRejected);
+        }
+        else if (onDisconnect_)
+        {
+            onDisconnect_(StompClientError::ServerError);
+        }
+        break;
+    }
+    case StompCommand::Receipt:
+    {
+        const auto id {frame.GetHeaderValue("receipt-id")};
+        auto* subscription {FindSubscription(id)};
+        if (subscription != nullptr && subscription->onSubscribe)
+        {
+            subscription->onSubscribe(StompClientError::Ok, std::string {id});
+        }
+        break;
+    }
+    case StompCommand::Message:
+    {
+        auto* subscription {FindSubscription(frame.GetHeaderValue("subscription"))};
+        if (subscription == nullptr)
+        {
+            Log("OnFrame", "Message for an unknown subscription");
+            break;
+        }
+        if (subscription->onMessage)
+        {
+            subscription->onMessage(StompClientError::Ok, frame);
+        }
+        break;
+    }
+    default:
+    {
+        Log("OnFrame", ToString(frame.GetCommand()));
+        break;
+    }
+    }
+}
+
+void StompClient::SendSubscribe (
+    const std::string& id,
+    bool withReceipt
+)
+{
+    auto* subscription {FindSubscription(id)};
+    if (subscription == nullptr)
+    {
+        return;
+    }
+
+    std::string_view ack {"auto"};
+    switch (subscription->ackMode)
+    {
+    case StompAckMode::Client:
+        ack = "client";
+        break;
+    case StompAckMode::ClientIndividual:
+        ack = "client-individual";
+        break;
+    default:
+        break;
+    }
+
+    /* The receipt tells us when the subscription is in place. We use the
+       subscription ID as receipt ID */
+    std::string frame {};
+    if (withReceipt)
+    {
+        SerializeStompFrame(frame, StompCommand::Subscribe, {
+            {"id", id},
+            {"destination", subscription->destination},
+            {"ack", ack},
+            {"receipt", id},
+        });
+    }
+    else
+    {
+        SerializeStompFrame(frame, StompCommand::Subscribe, {
+            {"id", id},
+            {"destination", subscription->destination},
+            {"ack", ack},
+        });
+    }
+    SendFrame(std::move(frame), [this, id, withReceipt](auto ec) {
+        auto* subscription {FindSubscription(id)};
+        if (ec && withReceipt && subscription != nullptr && subscription->onSubscribe)
+        {
+            subscription->onSubscribe(ec, std::string {id});
+        }
+    });
+}
+
+StompClient::Subscription* StompClient::FindSubscription (
+    std::string_view id
+)
+{
+    size_t idx {0};
+    const auto result {std::from_chars(id.data(), id.data() + id.size(), idx)};
+    if (id.empty()
+        || result.ec != std::errc {}
+        || result.ptr != id.data() + id.size()
+        || idx >= subscriptions_.size())
+        return nullptr;
+
+    return &subscriptions_[idx];
+}
+
+void StompClient::SendFrame (
+    std::string frame,
+    std::function<void (boost::system::error_code)> onSend
+)
+{
+    /* Frames are sent from the caller's thread (Ack, Close) and from the
+       WebSocket strand (STOMP, SUBSCRIBE on reconnect): each one is
+       serialized into its own string, which the send queue then owns */
+    ws_.Send(std::move(frame), std::move(onSend));
+}
@@ -0,0 +1,310 @@
+#include "StompFrame.h"
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using NetworkMonitor::StompCommand;
+using NetworkMonitor::StompError;
+using NetworkMonitor::StompFrame;
+using NetworkMonitor::StompHeader;
+
+/* Wire representation of each command */
+static constexpr std::array<std::pair<StompCommand, std::string_view>, 15> kCommands {{
+    {StompCommand::Abort, "ABORT"},
+    {StompCommand::Ack, "ACK"},
+    {StompCommand::Begin, "BEGIN"},
+    {StompCommand::Commit, "COMMIT"},
+    {StompCommand::Connect, "CONNECT"},
+    {StompCommand::Connected, "CONNECTED"},
+    {StompCommand::Disconnect, "DISCONNECT"},
+    {StompCommand::Error, "ERROR"},
+    {StompCommand::Message, "MESSAGE"},
+    {StompCommand::Nack, "NACK"},
+    {StompCommand::Receipt, "RECEIPT"},
+    {StompCommand::Send, "SEND"},
+    {StompCommand::Stomp, "STOMP"},
+    {StompCommand::Subscribe, "SUBSCRIBE"},
+    {StompCommand::Unsubscribe, "UNSUBSCRIBE"},
+}};
+
+/* Read a line ending with LF or CRLF, starting at `pos`
+   On success, `pos` moves past the end-of-line */
+static bool ReadLine (
+    std::string_view data,
+    size_t& pos,
+    std::string_view& line
+)
+{
+    const auto eol {data.find('\n', pos)};
+    if (eol == std::string_view::npos)
+        return false;
+
+    line = data.substr(pos, eol - pos);
+    if (!line.empty() && line.back() == '\r')
+    {
+        line.remove_suffix(1);
+    }
+    pos = eol + 1;
+    return true;
+}
+
+/* Skip the end-of-lines starting at `pos` */
+static size_t SkipEols (
+    std::string_view data,
+    size_t pos
+)
+{
+    while (pos < data.size())
+    {
+        if (data[pos] == '\n')
+        {
+            ++pos;
+        }
+        else if (data[pos] == '\r' && pos + 1 < data.size() && data[pos + 1] == '\n')
+        {
+            pos += 2;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return pos;
+}
+
+/* Free functions */
+std::string_view NetworkMonitor::ToString (
+    StompCommand command
+)
+{
+    for (const auto& [value, name]: kCommands)
+    {
+        if (value == command)
+            return name;
+    }
+    return "";
+}
+
+std::string_view NetworkMonitor::ToString (
+    StompError error
+)
+{
+    switch (error)
+    {
+    case StompError::Ok:
+        return "Ok";
+    case StompError::EmptyFrame:
+        return "EmptyFrame";
+    case StompError::UndefinedCommand:
+        return "UndefinedCommand";
+    case StompError::MissingCommandEol:
+        return "MissingCommandEol";
+    case StompError::MissingHeaderSeparator:
+        return "MissingHeaderSeparator";
+    case StompError::EmptyHeaderName:
+        return "EmptyHeaderName";
+    case StompError::TooManyHeaders:
+        return "TooManyHeaders";
+    case StompError::MissingBodyEol:
+        return "MissingBodyEol";
+    case StompError::InvalidContentLength:
+        return "InvalidContentLength";
+    case StompError::MissingNullTerminator:
+        return "MissingNullTerminator";
+    default:
+        return "";
+    }
+}
+
+std::ostream& NetworkMonitor::operator<< (
+    std::ostream& os,
+    StompCommand command
+)
+{
+    return os << ToString(command);
+}
+
+std::ostream& NetworkMonitor::operator<< (
+    std::ostream& os,
+    StompError error
+)
+{
+    return os << ToString(error);
+}
+
+void NetworkMonitor::SerializeStompFrame (
+    std::string& buffer,
+    StompCommand command,
+    std::initializer_list<StompHeader> headers,
+    std::string_view body
+)
+{
+    buffer.clear();
+    buffer += ToString(command);
+    buffer += '\n';
+    for (const auto& header: headers)
+    {
+        buffer += header.name;
+        buffer += ':';
+        buffer += header.value;
+        buffer += '\n';
+    }
+    if (!body.empty())
+    {
+        /* Format the length on the stack, to keep the buffer the only
+           allocation */
+        std::array<char, 24> length {};
+        const auto result {std::to_chars(length.data(), length.data() + length.size(), body.size())};
+        buffer += "content-length:";
+        buffer.append(length.data(), result.ptr);
+        buffer += '\n';
+    }
+    buffer += '\n';
+    buffer += body;
+    buffer += '\0';
+}
+
+/* Public methods */
+StompError StompFrame::Parse (
+    std::string_view data
+)
+{
+    nHeaders_ = 0;
+    body_ = {};
+    size_ = 0;
+
+    /* Heart-beats may come before the frame */
+    size_t pos {SkipEols(data, 0)};
+    if (pos == data.size())
+        return Fail(StompError::EmptyFrame);
+
+    /* Command */
+    std::string_view line {};
+    if (!ReadLine(data, pos, line))
+        return Fail(StompError::MissingCommandEol);
+    bool found {false};
+    for (const auto& [command, name]: kCommands)
+    {
+        if (line == name)
+        {
+            command_ = command;
+            found = true;
+            break;
+        }
+    }
+    if (!found)
+        return Fail(StompError::UndefinedCommand);
+
+    /* Headers, up to the blank line */
+    while (true)
+    {
+        if (!ReadLine(data, pos, line))
+            return Fail(StompError::MissingBodyEol);
+        if (line.empty())
+            break;
+
+        const auto colon {line.find(':')};
+        if (colon == std::string_view::npos)
+            return Fail(StompError::MissingHeaderSeparator);
+        if (colon == 0)
+            return Fail(StompError::EmptyHeaderName);
+        if (nHeaders_ == kMaxHeaders)
+            return Fail(StompError::TooManyHeaders);
+        headers_[nHeaders_++] = StompHeader {line.substr(0, colon), line.substr(colon + 1)};
+    }
+
+    /* Body: `content-length` octets if the header is present, otherwise up to
+       the first NULL octet */
+    size_t end {std::string_view::npos};
+    if (HasHeader("content-length"))
+    {
+        const auto value {GetHeaderValue("content-length")};
+        size_t length {0};
+        const auto result {std::from_chars(value.data(), value.data() + value.size(), length)};
+        if (result.ec != std::errc {} || result.ptr != value.data() + value.size())
+            return Fail(StompError::InvalidContentLength);
+        if (length < data.size() - pos && data[pos + length] == '\0')
+        {
+            end = pos + length;
+        }
+    }
+    else
+    {
+        end = data.find('\0', pos);
+    }
+    if (end == std::string_view::npos)
+        return Fail(StompError::MissingNullTerminator);
+
+    body_ = data.substr(pos, end - pos);
+    size_ = SkipEols(data, end + 1);
+    return StompError::Ok;
+}
+
+size_t StompFrame::GetSize() const
+{
+    return size_;
+}
+
+StompCommand StompFrame::GetCommand() const
+{
+    return command_;
+}
+
+std::string_view StompFrame::GetHeaderValue (
+    std::string_view name
+) const
+{
+    for (size_t idx {0}; idx < nHeaders_; ++idx)
+    {
+        if (headers_[idx].name == name)
+            return headers_[idx].value;
+    }
+    return {};
+}
+
+bool StompFrame::HasHeader (
+    std::string_view name
+) const
+{
+    for (size_t idx {0}; idx < nHeaders_; ++idx)
+    {
+        if (headers_[idx].name == name)
+            return true;
+    }
+    return false;
+}
+
+size_t StompFrame::GetHeaderCount() const
+{
+    return nHeaders_;
+}
+
+const StompHeader& StompFrame::GetHeader (
+    size_t idx
+) const
+{
+    return headers_[idx];
+}
+
+std::string_view StompFrame::GetBody() const
+{
+    return body_;
+}
+
+/* Private methods */
+StompError StompFrame::Fail (
+    StompError error
+)
+{
+    command_ = StompCommand::Error;
+    nHeaders_ = 0;
+    body_ = {};
+    size_ = 0;
+    return error;
+}
@@ -1,16 +1,104 @@
 #include "TransportNetwork.h"
+#include "MappedFile.h"
+
+#include <nlohmann/json.hpp>
 
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <limits>
 #include <stdexcept>
-#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
 
 using NetworkMonitor::Id;
+using NetworkMonitor::StationHandle;
+using NetworkMonitor::LineHandle;
+using NetworkMonitor::HandleSpan;
+using NetworkMonitor::RouteHandle;
 using NetworkMonitor::Station;
 using NetworkMonitor::Route;
 using NetworkMonitor::Line;
 using NetworkMonitor::PassengerEvent;
+using NetworkMonitor::PassengerDelta;
 using NetworkMonitor::TransportNetwork;
+using NetworkMonitor::NetworkGraphView;
+using NetworkMonitor::Itinerary;
+using NetworkMonitor::ItineraryLeg;
+using NetworkMonitor::ItineraryOptions;
+using NetworkMonitor::CrowdingModel;
+
+namespace
+{
+    /* Per-thread scratch buffers of the itinerary search
+       They grow to the largest network searched on the thread and are then
+       reused, so that a search does not allocate. Entries are only valid if
+       their visit stamp matches the current generation, which saves clearing
+       the buffers before each search */
+    struct ItineraryScratch
+    {
+        struct HeapEntry
+        {
+            unsigned int cost {0};
+            NetworkMonitor::Handle stop {NetworkMonitor::kInvalidHandle};
+
+            bool operator>(const HeapEntry& other) const
+            {
+                return cost > other.cost;
+            }
+        };
+
+        std::vector<unsigned int> cost {};
+        std::vector<NetworkMonitor::Handle> predecessor {};
+        std::vector<std::uint32_t> visit {};
+        std::vector<HeapEntry> heap {};
+        std::vector<NetworkMonitor::Handle> path {};
+        std::uint32_t generation {0};
+
+        void Reset(
+            size_t nStops
+        )
+        {
+            if (visit.size() < nStops)
+            {
+                cost.resize(nStops);
+                predecessor.resize(nStops);
+                visit.resize(nStops, 0);
+                heap.reserve(2 * nStops);
+                path.reserve(nStops);
+            }
+            heap.clear();
+            path.clear();
+            if (++generation == 0)
+            {
+                std::fill(visit.begin(), visit.end(), 0);
+                generation = 1;
+            }
+        }
+
+        /* Lower the cost of a stop if the new cost is better */
+        void Relax(
+            NetworkMonitor::Handle stop,
+            unsigned int newCost,
+            NetworkMonitor::Handle from
+        )
+        {
+            if (visit[stop] == generation && cost[stop] <= newCost)
+                return;
+
+            visit[stop] = generation;
+            cost[stop] = newCost;
+            predecessor[stop] = from;
+            heap.push_back({newCost, stop});
+            std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry> {});
+        }
+    };
+}
 
 bool Station::operator==(const Station& other) const
 {
@@ -27,6 +115,303 @@ bool Line::operator==(const Line& other) const
     return id == other.id;
 }
 
+/* SAX handler building a TransportNetwork from the JSON network layout
+   We follow our position in the document with a stack of contexts. Stations
+   are added as soon as they are parsed. The layout lists the lines before
+   the stations they serve, so lines and travel times are kept until the end
+   of the document. They are small compared to a full JSON document */
+class TransportNetwork::NetworkLayoutHandler: public nlohmann::json_sax<nlohmann::json>
+{
+public:
+    NetworkLayoutHandler (
+        TransportNetwork& nw
+    ) : nw_ {nw}
+    {}
+
+    bool null() override
+    {
+        return Value();
+    }
+
+    bool boolean(bool) override
+    {
+        return Value();
+    }
+
+    bool number_integer(number_integer_t value) override
+    {
+        /* We never read negative numbers: travel times are unsigned */
+        if (value < 0)
+            return GetValueKind() == ValueKind::Any;
+        return Number(static_cast<number_unsigned_t>(value));
+    }
+
+    bool number_unsigned(number_unsigned_t value) override
+    {
+        return Number(value);
+    }
+
+    bool number_float(number_float_t, const string_t&) override
+    {
+        return Value();
+    }
+
+    bool string(string_t& value) override
+    {
+        if (GetValueKind() == ValueKind::Number)
+            return false;
+
+        switch (Top())
+        {
+        case Context::Station:
+            if (key_ == "station_id")
+                station_.id = std::move(value);
+            else if (key_ == "name")
+                station_.name = std::move(value);
+            break;
+        case Context::Line:
+            if (key_ == "line_id")
+                lines_.back().id = std::move(value);
+            else if (key_ == "name")
+                lines_.back().name = std::move(value);
+            break;
+        case Context::Route:
+        {
+            auto& route {lines_.back().routes.back()};
+            if (key_ == "route_id")
+                route.id = std::move(value);
+            else if (key_ == "direction")
+                route.direction = std::move(value);
+            else if (key_ == "line_id")
+                route.lineId = std::move(value);
+            else if (key_ == "start_station_id")
+                route.startStationId = std::move(value);
+            else if (key_ == "end_station_id")
+                route.endStationId = std::move(value);
+            break;
+        }
+        case Context::RouteStops:
+            lines_.back().routes.back().stops.push_back(std::move(value));
+            ++nRouteStops_;
+            break;
+        case Context::TravelTime:
+            if (key_ == "start_station_id")
+                travelTimes_.back().stationA = std::move(value);
+            else if (key_ == "end_station_id")
+                travelTimes_.back().stationB = std::move(value);
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    bool binary(binary_t&) override
+    {
+        return Value();
+    }
+
+    bool start_object(std::size_t) override
+    {
+        switch (Top())
+        {
+        case Context::None:
+            contexts_.push_back(Context::Root);
+            break;
+        case Context::Stations:
+            station_ = Station {};
+            contexts_.push_back(Context::Station);
+            break;
+        case Context::Lines:
+            lines_.emplace_back();
+            contexts_.push_back(Context::Line);
+            break;
+        case Context::Routes:
+            lines_.back().routes.emplace_back();
+            contexts_.push_back(Context::Route);
+            break;
+        case Context::TravelTimes:
+            travelTimes_.emplace_back();
+            contexts_.push_back(Context::TravelTime);
+            break;
+        default:
+            contexts_.push_back(Context::Ignore);
+            break;
+        }
+        return true;
+    }
+
+    bool key(string_t& value) override
+    {
+        key_ = std::move(value);
+        return true;
+    }
+
+    bool end_object() override
+    {
+        const auto context {Top()};
+        contexts_.pop_back();
+        if (context == Context::Station)
+        {
+            /* Stations do not depend on anything else, add them right away */
+            return !station_.id.empty() && nw_.AddStation(station_);
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) override
+    {
+        const auto context {Top()};
+        if (context == Context::Root && key_ == "stations")
+            contexts_.push_back(Context::Stations);
+        else if (context == Context::Root && key_ == "lines")
+            contexts_.push_back(Context::Lines);
+        else if (context == Context::Root && key_ == "travel_times")
+            contexts_.push_back(Context::TravelTimes);
+        else if (context == Context::Line && key_ == "routes")
+            contexts_.push_back(Context::Routes);
+        else if (context == Context::Route && key_ == "route_stops")
+            contexts_.push_back(Context::RouteStops);
+        else
+            contexts_.push_back(Context::Ignore);
+        return true;
+    }
+
+    bool end_array() override
+    {
+        contexts_.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override
+    {
+        return false;
+    }
+
+    /* Add the lines and travel times once all stations are known */
+    bool Finish()
+    {
+        /* We know the exact size of the route arrays now */
+        nw_.routeStops_.reserve(nw_.routeStops_.size() + nRouteStops_);
+        nw_.lines_.reserve(nw_.lines_.size() + lines_.size());
+
+        /* Index all the routes at once, instead of once per line */
+        const auto firstRoute {static_cast<Index>(nw_.routes_.size())};
+        bool ok {true};
+        for (const auto& line: lines_)
+        {
+            ok &= nw_.AddLineRoutes(line);
+        }
+        nw_.IndexNewRoutes(firstRoute);
+        for (const auto& travelTime: travelTimes_)
+        {
+            ok &= nw_.SetTravelTime(travelTime.stationA, travelTime.stationB, travelTime.travelTime);
+        }
+
+        return ok;
+    }
+
+private:
+    enum class Context
+    {
+        None,
+        Root,
+        Stations,
+        Station,
+        Lines,
+        Line,
+        Routes,
+        Route,
+        RouteStops,
+        TravelTimes,
+        TravelTime,
+        Ignore
+    };
+
+    struct TravelTime
+    {
+        Id stationA {};
+        Id stationB {};
+        unsigned int travelTime {0};
+    };
+
+    TransportNetwork& nw_;
+    std::vector<Context> contexts_ {};
+    std::string key_ {};
+    Station station_ {};
+    std::vector<Line> lines_ {};
+    std::vector<TravelTime> travelTimes_ {};
+    size_t nRouteStops_ {0};
+
+    Context Top() const
+    {
+        return contexts_.empty() ? Context::None : contexts_.back();
+    }
+
+    /* Kind of value expected at the current position. Values we do not
+       read can be of any kind */
+    enum class ValueKind
+    {
+        Any,
+        Number,
+        String
+    };
+
+    ValueKind GetValueKind() const
+    {
+        switch (Top())
+        {
+        case Context::Station:
+            if (key_ == "station_id" || key_ == "name")
+                return ValueKind::String;
+            break;
+        case Context::Line:
+            if (key_ == "line_id" || key_ == "name")
+                return ValueKind::String;
+            break;
+        case Context::Route:
+            if (key_ == "route_id" || key_ == "direction" || key_ == "line_id"
+                || key_ == "start_station_id" || key_ == "end_station_id")
+                return ValueKind::String;
+            break;
+        case Context::RouteStops:
+            return ValueKind::String;
+        case Context::TravelTime:
+            if (key_ == "travel_time")
+                return ValueKind::Number;
+            if (key_ == "start_station_id" || key_ == "end_station_id")
+                return ValueKind::String;
+            break;
+        default:
+            break;
+        }
+        return ValueKind::Any;
+    }
+
+    /* Null, boolean, float and binary values are only accepted where we do
+       not read the value */
+    bool Value()
+    {
+        return GetValueKind() == ValueKind::Any;
+    }
+
+    bool Number(number_unsigned_t value)
+    {
+        switch (GetValueKind())
+        {
+        case ValueKind::Number:
+            if (value > std::numeric_limits<unsigned int>::max())
+                return false;
+            travelTimes_.back().travelTime = static_cast<unsigned int>(value);
+            return true;
+        case ValueKind::String:
+            return false;
+        default:
+            return true;
+        }
+    }
+};
+
 /* Default constructor */
 TransportNetwork::TransportNetwork() = default;
 
@@ -53,23 +438,1046 @@ TransportNetwork& TransportNetwork::operator=(
     TransportNetwork&& moved
 ) = default;
 
+TransportNetwork::PassengerCounter::PassengerCounter (
+    const PassengerCounter& copied
+) : count {copied.count.load(std::memory_order_relaxed)},
+    penalty {copied.penalty.load(std::memory_order_relaxed)}
+{}
+
+TransportNetwork::PassengerCounter& TransportNetwork::PassengerCounter::operator= (
+    const PassengerCounter& copied
+)
+{
+    count.store(copied.count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    penalty.store(copied.penalty.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+}
+
+/* Public methods */
 bool TransportNetwork::AddStation (
     const Station& station
 )
 {
     /* Cannot add a station that is already in the network */
-    if (GetStation(station.id) != nullptr)
+    if (GetStationHandle(station.id) != kInvalidHandle)
+        return false;
+
+    /* Create a new station and start with no passengers, no edges.
+       The new station owns an empty range at the end of the edge array */
+    stationIds_.Intern(station.id);
+    stations_.push_back(StationInternal {
+        station.name
+    });
+    passengerCounts_.emplace_back();
+    edgeOffsets_.push_back(edgeOffsets_.back());
+    stationStopOffsets_.push_back(stationStopOffsets_.back());
+    stationRouteOffsets_.push_back(stationRouteOffsets_.back());
+    travelTimeMatrix_.clear();
+
+    return true;
+}
+
+bool TransportNetwork::AddLine (
+    const Line& line
+)
+{
+    const auto firstRoute {static_cast<Index>(routes_.size())};
+    if (!AddLineRoutes(line))
+        return false;
+
+    /* Connect the stations of the new routes */
+    IndexNewRoutes(firstRoute);
+    travelTimeMatrix_.clear();
+
+    return true;
+}
+
+bool TransportNetwork::FromJson (
+    std::istream& layout
+)
+{
+    /* Load into a new network, so that we leave this one untouched if the
+       layout is not valid */
+    TransportNetwork nw {};
+    NetworkLayoutHandler handler {nw};
+    const bool parsed {nlohmann::json::sax_parse(layout, &handler)};
+    if (!parsed || !handler.Finish())
+        return false;
+
+    *this = std::move(nw);
+    return true;
+}
+
+bool TransportNetwork::FromJson (
+    const std::filesystem::path& src
+)
+{
+    /* Parse the mapped file as one buffer rather than through an iostream */
+    MappedFile file {};
+    if (!file.Open(src))
+        return false;
+
+    const auto layout {file.GetView()};
+    TransportNetwork nw {};
+    NetworkLayoutHandler handler {nw};
+    const bool parsed {nlohmann::json::sax_parse(layout.begin(), layout.end(), &handler)};
+    if (!parsed || !handler.Finish())
         return false;
-    
-    /* Create a new station node and add it to the map
-       and start with no passengers, no edges */
-    auto node {std::make_shared<GraphNode>(GraphNode {
-        station.id,
-        station.name,
-        0,
+
+    *this = std::move(nw);
+    return true;
+}
+
+bool TransportNetwork::RecordPassengerEvent (
+    const PassengerEvent& event
+)
+{
+    return RecordPassengerEvent(GetStationHandle(event.stationId), event.type);
+}
+
+bool TransportNetwork::RecordPassengerEvent (
+    StationHandle station,
+    PassengerEvent::Type type
+)
+{
+    if (station >= stations_.size())
+        return false;
+
+    switch (type)
+    {
+    case PassengerEvent::Type::In:
+        AddPassengers(station, 1);
+        return true;
+    case PassengerEvent::Type::Out:
+        AddPassengers(station, -1);
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t TransportNetwork::RecordPassengerEvents (
+    const PassengerEvent* events,
+    size_t nEvents
+)
+{
+    /* Each thread reuses its own scratch buffer across bursts */
+    thread_local std::vector<PassengerDelta> deltas {};
+    deltas.clear();
+
+    size_t rejected {0};
+    for (size_t idx {0}; idx < nEvents; ++idx)
+    {
+        const auto station {GetStationHandle(events[idx].stationId)};
+        if (station == kInvalidHandle)
+        {
+            ++rejected;
+            continue;
+        }
+        switch (events[idx].type)
+        {
+        case PassengerEvent::Type::In:
+            deltas.push_back({station, 1});
+            break;
+        case PassengerEvent::Type::Out:
+            deltas.push_back({station, -1});
+            break;
+        default:
+            ++rejected;
+            break;
+        }
+    }
+    ApplyPassengerDeltas(deltas);
+
+    return rejected;
+}
+
+size_t TransportNetwork::RecordPassengerEvents (
+    const PassengerDelta* deltas,
+    size_t nDeltas
+)
+{
+    thread_local std::vector<PassengerDelta> valid {};
+    valid.clear();
+
+    size_t rejected {0};
+    for (size_t idx {0}; idx < nDeltas; ++idx)
+    {
+        if (deltas[idx].station >= stations_.size())
+        {
+            ++rejected;
+            continue;
+        }
+        valid.push_back(deltas[idx]);
+    }
+    ApplyPassengerDeltas(valid);
+
+    return rejected;
+}
+
+long long int TransportNetwork::GetPassengerCount (
+    const Id& station
+) const
+{
+    const auto handle {GetStationHandle(station)};
+    if (handle == kInvalidHandle)
+    {
+        throw std::runtime_error("Could not find station in the network: " + station);
+    }
+
+    return GetPassengerCount(handle);
+}
+
+long long int TransportNetwork::GetPassengerCount (
+    StationHandle station
+) const
+{
+    if (station >= stations_.size())
+    {
+        throw std::runtime_error("Invalid station handle");
+    }
+
+    return passengerCounts_[station].count.load(std::memory_order_relaxed);
+}
+
+std::vector<Id> TransportNetwork::GetRoutesServingStation (
+    const Id& station
+) const
+{
+    const auto routes {GetRoutesServingStationView(station)};
+    std::vector<Id> ids {};
+    ids.reserve(routes.size());
+    for (const auto route: routes)
+    {
+        ids.push_back(routeIds_.GetId(route));
+    }
+
+    return ids;
+}
+
+std::vector<RouteHandle> TransportNetwork::GetRoutesServingStation (
+    StationHandle station
+) const
+{
+    const auto routes {GetRoutesServingStationView(station)};
+    return {routes.begin(), routes.end()};
+}
+
+HandleSpan TransportNetwork::GetRoutesServingStationView (
+    const Id& station
+) const
+{
+    return GetRoutesServingStationView(GetStationHandle(station));
+}
+
+HandleSpan TransportNetwork::GetRoutesServingStationView (
+    StationHandle station
+) const
+{
+    if (station >= stations_.size())
+        return {};
+
+    /* The reverse index also lists the routes that end at the station, which
+       have no edge leaving from it */
+    const auto first {stationRouteOffsets_[station]};
+    return {stationRoutes_.data() + first, stationRouteOffsets_[station + 1] - first};
+}
+
+bool TransportNetwork::SetTravelTime (
+    const Id& stationA,
+    const Id& stationB,
+    const unsigned int travelTime
+)
+{
+    const auto indexA {GetStationHandle(stationA)};
+    const auto indexB {GetStationHandle(stationB)};
+    if (indexA == kInvalidHandle || indexB == kInvalidHandle)
+        return false;
+
+    /* Search all edges connecting A -> B and B -> A
+       We use a lambda to avoid code duplication.
+       When an edge changes, we shift the cumulative travel times of all the
+       following stops on its route */
+    bool foundAnyEdge {false};
+    auto setTravelTime {[this, &foundAnyEdge, travelTime](auto from, auto to) {
+        const auto oldTravelTime {GetEdgeTravelTime(from, to)};
+        for (auto edge {edgeOffsets_[from]}; edge < edgeOffsets_[from + 1]; ++edge)
+        {
+            auto& graphEdge {edges_[edge]};
+            if (graphEdge.nextStop != to)
+                continue;
+
+            foundAnyEdge = true;
+            if (graphEdge.travelTime == travelTime)
+                continue;
+
+            const auto& route {routes_[graphEdge.route]};
+            const auto last {route.firstStop + route.nStops};
+            for (auto next {graphEdge.stop + 1}; next < last; ++next)
+            {
+                /* Unsigned wrap-around also handles shorter travel times */
+                routeTravelTimes_[next] += travelTime - graphEdge.travelTime;
+            }
+            graphEdge.travelTime = travelTime;
+        }
+        if (!travelTimeMatrix_.empty() && oldTravelTime != kUnreachable)
+        {
+            RepairTravelTimes(from, to, oldTravelTime, travelTime);
+        }
+    }};
+    setTravelTime(indexA, indexB);
+    setTravelTime(indexB, indexA);
+
+    return foundAnyEdge;
+}
+
+unsigned int TransportNetwork::GetTravelTime (
+    const Id& stationA,
+    const Id& stationB
+) const
+{
+    /* Check if the stations are the same */
+    if (stationA == stationB)
+        return 0;
+
+    return GetTravelTime(GetStationHandle(stationA), GetStationHandle(stationB));
+}
+
+unsigned int TransportNetwork::GetTravelTime (
+    const Id& line,
+    const Id& route,
+    const Id& stationA,
+    const Id& stationB
+) const
+{
+    /* Check if the stations are the same */
+    if (stationA == stationB)
+        return 0;
+
+    return GetTravelTime(
+        GetRouteHandle(line, route),
+        GetStationHandle(stationA),
+        GetStationHandle(stationB)
+    );
+}
+
+unsigned int TransportNetwork::GetTravelTime (
+    StationHandle stationA,
+    StationHandle stationB
+) const
+{
+    return GetGraphView().GetTravelTime(stationA, stationB);
+}
+
+unsigned int TransportNetwork::GetTravelTime (
+    RouteHandle route,
+    StationHandle stationA,
+    StationHandle stationB
+) const
+{
+    return GetGraphView().GetTravelTime(route, stationA, stationB);
+}
+
+bool TransportNetwork::GetFastestItinerary (
+    StationHandle from,
+    StationHandle to,
+    Itinerary& itinerary,
+    const ItineraryOptions& options
+) const
+{
+    itinerary.legs.clear();
+    itinerary.travelTime = 0;
+    itinerary.cost = 0;
+    if (from >= stations_.size() || to >= stations_.size())
+        return false;
+    if (from == to)
+        return true;
+
+    thread_local ItineraryScratch scratch {};
+    scratch.Reset(routeStops_.size());
+
+    /* The search states are the route stops: being at a station on a given
+       route. We can start on any route serving the origin station */
+    for (auto stop {stationStopOffsets_[from]}; stop < stationStopOffsets_[from + 1]; ++stop)
+    {
+        scratch.Relax(stationStops_[stop].stop, 0, kInvalidHandle);
+    }
+
+    Index target {kInvalidHandle};
+    while (!scratch.heap.empty())
+    {
+        std::pop_heap(scratch.heap.begin(), scratch.heap.end(),
+                      std::greater<ItineraryScratch::HeapEntry> {});
+        const auto [cost, stop] {scratch.heap.back()};
+        scratch.heap.pop_back();
+
+        /* Skip stale heap entries */
+        if (cost > scratch.cost[stop])
+            continue;
+
+        const auto station {routeStops_[stop]};
+        if (station == to)
+        {
+            target = stop;
+            break;
+        }
+
+        /* Ride to the next stop of the route */
+        const auto route {stopRoutes_[stop]};
+        const auto& routeInternal {routes_[route]};
+        if (stop + 1 < routeInternal.firstStop + routeInternal.nStops)
+        {
+            auto rideCost {routeTravelTimes_[stop + 1] - routeTravelTimes_[stop]};
+            if (options.avoidCrowding)
+            {
+                rideCost += passengerCounts_[routeStops_[stop + 1]].penalty.load(
+                    std::memory_order_relaxed
+                );
+            }
+            scratch.Relax(stop + 1, cost + rideCost, stop);
+        }
+
+        /* Change to another route serving the same station
+           We only change route when arriving at a station: changing twice in
+           a row is never cheaper than changing once */
+        const auto predecessor {scratch.predecessor[stop]};
+        if (predecessor == kInvalidHandle || routeStops_[predecessor] == station)
+            continue;
+        for (auto other {stationStopOffsets_[station]}; other < stationStopOffsets_[station + 1]; ++other)
+        {
+            const auto& stationStop {stationStops_[other]};
+            if (stationStop.stop == stop)
+                continue;
+
+            const bool changeLine {routes_[stationStop.route].line != routeInternal.line};
+            scratch.Relax(
+                stationStop.stop,
+                cost + (changeLine ? options.lineChangePenalty : 0),
+                stop
+            );
+        }
+    }
+    if (target == kInvalidHandle)
+        return false;
+
+    /* Walk back the predecessors, then split the path into legs: one for each
+       run of consecutive stops on the same route. A loop route can also
+       "change" to its own first stop at its terminus: that starts a new leg
+       too, as the stops are no longer consecutive */
+    for (auto stop {target}; stop != kInvalidHandle; stop = scratch.predecessor[stop])
+    {
+        scratch.path.push_back(stop);
+    }
+    std::reverse(scratch.path.begin(), scratch.path.end());
+    for (size_t first {0}; first < scratch.path.size();)
+    {
+        const auto boardStop {scratch.path[first]};
+        auto last {first};
+        while (last + 1 < scratch.path.size()
+               && scratch.path[last + 1] == scratch.path[last] + 1
+               && stopRoutes_[scratch.path[last + 1]] == stopRoutes_[boardStop])
+        {
+            ++last;
+        }
+        const auto alightStop {scratch.path[last]};
+        first = last + 1;
+
+        /* Changing route right at the origin is not a leg */
+        if (alightStop == boardStop)
+            continue;
+
+        const auto route {stopRoutes_[boardStop]};
+        const auto travelTime {routeTravelTimes_[alightStop] - routeTravelTimes_[boardStop]};
+        itinerary.legs.push_back(ItineraryLeg {
+            routes_[route].line,
+            route,
+            routeStops_[boardStop],
+            routeStops_[alightStop],
+            travelTime
+        });
+        itinerary.travelTime += travelTime;
+    }
+    itinerary.cost = scratch.cost[target];
+
+    return true;
+}
+
+Itinerary TransportNetwork::GetFastestItinerary (
+    const Id& from,
+    const Id& to,
+    const ItineraryOptions& options
+) const
+{
+    Itinerary itinerary {};
+    GetFastestItinerary(GetStationHandle(from), GetStationHandle(to), itinerary, options);
+
+    return itinerary;
+}
+
+void TransportNetwork::PrecomputeTravelTimes (
+    unsigned int nThreads
+)
+{
+    const auto nStations {stations_.size()};
+    travelTimeMatrix_.assign(nStations * nStations, kUnreachable);
+
+    std::vector<Index> origins(nStations);
+    for (Index station {0}; station < nStations; ++station)
+    {
+        origins[station] = station;
+    }
+    ComputeTravelTimeRows(origins, nThreads);
+}
+
+unsigned int TransportNetwork::GetShortestTravelTime (
+    StationHandle from,
+    StationHandle to
+) const
+{
+    if (travelTimeMatrix_.empty() || from >= stations_.size() || to >= stations_.size())
+        return kUnreachable;
+
+    return travelTimeMatrix_[from * stations_.size() + to];
+}
+
+void TransportNetwork::SetCrowdingModel (
+    const CrowdingModel& model
+)
+{
+    crowdingModel_ = model;
+    for (auto& counter: passengerCounts_)
+    {
+        counter.penalty.store(
+            ComputeCrowdingPenalty(counter.count.load(std::memory_order_relaxed)),
+            std::memory_order_relaxed
+        );
+    }
+}
+
+const CrowdingModel& TransportNetwork::GetCrowdingModel() const
+{
+    return crowdingModel_;
+}
+
+unsigned int TransportNetwork::GetCrowdingPenalty (
+    StationHandle station
+) const
+{
+    if (station >= stations_.size())
+        return 0;
+
+    return passengerCounts_[station].penalty.load(std::memory_order_relaxed);
+}
+
+size_t TransportNetwork::GetStationCount() const
+{
+    return stations_.size();
+}
+
+StationHandle TransportNetwork::GetStationHandle (
+    const Id& station
+) const
+{
+    return stationIds_.Find(station);
+}
+
+LineHandle TransportNetwork::GetLineHandle (
+    const Id& line
+) const
+{
+    return lineIds_.Find(line);
+}
+
+RouteHandle TransportNetwork::GetRouteHandle (
+    const Id& line,
+    const Id& route
+) const
+{
+    const auto lineHandle {GetLineHandle(line)};
+    if (lineHandle == kInvalidHandle)
+        return kInvalidHandle;
+
+    const auto routeHandle {routeIds_.Find(route)};
+    if (routeHandle == kInvalidHandle || routes_[routeHandle].line != lineHandle)
+        return kInvalidHandle;
+
+    return routeHandle;
+}
+
+const Id& TransportNetwork::GetStationId (
+    StationHandle station
+) const
+{
+    return stationIds_.GetId(station);
+}
+
+const Id& TransportNetwork::GetLineId (
+    LineHandle line
+) const
+{
+    return lineIds_.GetId(line);
+}
+
+const Id& TransportNetwork::GetRouteId (
+    RouteHandle route
+) const
+{
+    return routeIds_.GetId(route);
+}
+
+/* Private methods */
+bool TransportNetwork::AddLineRoutes (
+    const Line& line
+)
+{
+    /* Cannot add a line that is already in the network */
+    if (GetLineHandle(line.id) != kInvalidHandle)
+        return false;
+
+    const auto lineIndex {lineIds_.Intern(line.id)};
+    const auto firstRoute {static_cast<Index>(routes_.size())};
+    const auto firstStop {routeStops_.size()};
+    lines_.push_back(LineInternal {
+        line.name,
         {}
-    })};
-    stations_.emplace(station.id, std::move(node));
+    });
+
+    /* Add routes to the line. If any of them fails we roll back everything
+       we appended so that the network is left untouched */
+    for (const auto& route: line.routes)
+    {
+        if (!AddRouteToLine(route, lineIndex))
+        {
+            routeIds_.Truncate(firstRoute);
+            routes_.resize(firstRoute);
+            routeStops_.resize(firstStop);
+            lineIds_.Truncate(lineIndex);
+            lines_.pop_back();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void TransportNetwork::ApplyPassengerDeltas (
+    std::vector<PassengerDelta>& deltas
+)
+{
+    std::sort(deltas.begin(), deltas.end(), [](const auto& a, const auto& b) {
+        return a.station < b.station;
+    });
+
+    auto delta {deltas.begin()};
+    while (delta != deltas.end())
+    {
+        const auto station {delta->station};
+        long long int total {0};
+        for (; delta != deltas.end() && delta->station == station; ++delta)
+        {
+            total += delta->delta;
+        }
+        if (total != 0)
+        {
+            AddPassengers(station, total);
+        }
+    }
+}
+
+unsigned int TransportNetwork::GetEdgeTravelTime (
+    Index from,
+    Index to
+) const
+{
+    auto travelTime {kUnreachable};
+    for (auto edge {edgeOffsets_[from]}; edge < edgeOffsets_[from + 1]; ++edge)
+    {
+        if (edges_[edge].nextStop == to)
+        {
+            travelTime = std::min(travelTime, edges_[edge].travelTime);
+        }
+    }
+
+    return travelTime;
+}
+
+void TransportNetwork::ComputeTravelTimeRows (
+    const std::vector<Index>& origins,
+    unsigned int nThreads
+)
+{
+    /* Starting a thread costs about as much as a few searches on a network
+       of a few thousand stations. By default, each thread gets enough origins
+       to pay for itself, so that small repairs run on the calling thread */
+    constexpr size_t kMinOriginsPerThread {32};
+    const auto nStations {stations_.size()};
+    if (nThreads == 0)
+    {
+        nThreads = std::clamp<size_t>(
+            origins.size() / kMinOriginsPerThread,
+            1,
+            std::max(1u, std::thread::hardware_concurrency())
+        );
+    }
+    nThreads = std::min<unsigned int>(nThreads, std::max<size_t>(1, origins.size()));
+
+    /* Each thread picks the next origin until there are none left, and runs
+       a Dijkstra search writing straight into the origin's matrix row. Rows
+       are disjoint, so threads never write to the same entry */
+    std::atomic<size_t> nextOrigin {0};
+    auto worker {[this, &origins, &nextOrigin, nStations]() {
+        using HeapEntry = std::pair<unsigned int, Index>;
+        std::vector<HeapEntry> heap {};
+        heap.reserve(edges_.size() + 1);
+        for (auto idx {nextOrigin++}; idx < origins.size(); idx = nextOrigin++)
+        {
+            const auto origin {origins[idx]};
+            auto* row {travelTimeMatrix_.data() + origin * nStations};
+            std::fill(row, row + nStations, kUnreachable);
+            row[origin] = 0;
+            heap.assign(1, {0, origin});
+            while (!heap.empty())
+            {
+                std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry> {});
+                const auto [travelTime, station] {heap.back()};
+                heap.pop_back();
+                if (travelTime > row[station])
+                    continue;
+
+                for (auto edge {edgeOffsets_[station]}; edge < edgeOffsets_[station + 1]; ++edge)
+                {
+                    const auto& graphEdge {edges_[edge]};
+                    const auto nextTravelTime {travelTime + graphEdge.travelTime};
+                    if (nextTravelTime < row[graphEdge.nextStop])
+                    {
+                        row[graphEdge.nextStop] = nextTravelTime;
+                        heap.push_back({nextTravelTime, graphEdge.nextStop});
+                        std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry> {});
+                    }
+                }
+            }
+        }
+    }};
+
+    std::vector<std::thread> threads {};
+    for (unsigned int thread {1}; thread < nThreads; ++thread)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+}
+
+void TransportNetwork::RepairTravelTimes (
+    Index from,
+    Index to,
+    unsigned int oldTravelTime,
+    unsigned int newTravelTime
+)
+{
+    const auto nStations {stations_.size()};
+    const auto* matrix {travelTimeMatrix_.data()};
+    auto at {[matrix, nStations](Index a, Index b) {
+        return matrix[a * nStations + b];
+    }};
+
+    /* The edge `from -> to` had the shortest travel time among its parallel
+       edges, so its new travel time is the new edge weight */
+    if (newTravelTime < oldTravelTime)
+    {
+        /* A shorter edge can only improve paths, through the edge itself.
+           Shortest paths to `from` and from `to` do not use the edge, so we
+           can read them while updating the matrix in place */
+        for (Index origin {0}; origin < nStations; ++origin)
+        {
+            const auto toFrom {at(origin, from)};
+            if (toFrom == kUnreachable)
+                continue;
+
+            auto* row {travelTimeMatrix_.data() + origin * nStations};
+            for (Index destination {0}; destination < nStations; ++destination)
+            {
+                const auto fromTo {at(to, destination)};
+                if (fromTo == kUnreachable)
+                    continue;
+
+                row[destination] = std::min(row[destination], toFrom + newTravelTime + fromTo);
+            }
+        }
+    }
+    else if (newTravelTime > oldTravelTime)
+    {
+        /* A longer edge can only worsen the paths that went through it. We
+           only search again from the origins that used it to reach `to` */
+        std::vector<Index> origins {};
+        for (Index origin {0}; origin < nStations; ++origin)
+        {
+            const auto toFrom {at(origin, from)};
+            if (toFrom != kUnreachable && toFrom + oldTravelTime == at(origin, to))
+            {
+                origins.push_back(origin);
+            }
+        }
+        ComputeTravelTimeRows(origins, 0);
+    }
+}
+
+void TransportNetwork::AddPassengers (
+    Index station,
+    long long int delta
+)
+{
+    /* Counters are independent of each other and of the rest of the
+       network, so a relaxed increment is enough */
+    auto& counter {passengerCounts_[station]};
+    auto count {counter.count.fetch_add(delta, std::memory_order_relaxed) + delta};
+
+    /* Without a crowding model every penalty stays 0. SetCrowdingModel
+       recomputes them all when the model changes */
+    if (crowdingModel_.passengersPerUnit <= 0)
+        return;
+
+    /* Another thread may change the count between our increment and our
+       penalty update, and store its penalty before ours. We check the count
+       again after storing: whoever stores last sees the latest count, so the
+       cached penalty always catches up.
+       Most events do not move the count across a penalty step: we only store,
+       and check again, when the penalty changes */
+    while (true)
+    {
+        const auto penalty {ComputeCrowdingPenalty(count)};
+        if (counter.penalty.load(std::memory_order_relaxed) == penalty)
+            break;
+
+        counter.penalty.store(penalty, std::memory_order_relaxed);
+        const auto latest {counter.count.load(std::memory_order_relaxed)};
+        if (latest == count)
+            break;
+        count = latest;
+    }
+}
+
+unsigned int TransportNetwork::ComputeCrowdingPenalty (
+    long long int count
+) const
+{
+    const auto& model {crowdingModel_};
+    if (model.passengersPerUnit <= 0 || count <= model.threshold)
+        return 0;
+
+    const auto units {(count - model.threshold) / model.passengersPerUnit};
+    return static_cast<unsigned int>(
+        std::min<long long int>(units, model.maxPenalty)
+    );
+}
+
+NetworkGraphView<TransportNetwork::Index, TransportNetwork::GraphEdge,
+                 TransportNetwork::StationStop, unsigned int,
+                 TransportNetwork::RouteStopSlot>
+TransportNetwork::GetGraphView() const
+{
+    return NetworkGraphView<Index, GraphEdge, StationStop, unsigned int, RouteStopSlot> {
+        stations_.size(),
+        routes_.size(),
+        edgeOffsets_.data(),
+        edges_.data(),
+        stationStopOffsets_.data(),
+        stationStops_.data(),
+        routeTravelTimes_.data(),
+        routeStopSlotOffsets_.data(),
+        routeStopSlots_.data()
+    };
+}
+
+bool TransportNetwork::AddRouteToLine (
+    const Route& route,
+    Index line
+)
+{
+    /* Cannot add a line route that is already in the network */
+    if (routeIds_.Find(route.id) != kInvalidHandle)
+        return false;
+
+    /* Resolve the stops first. All of them must already be in the network */
+    const auto firstStop {static_cast<Index>(routeStops_.size())};
+    for (const auto& stopId: route.stops)
+    {
+        const auto station {GetStationHandle(stopId)};
+        if (station == kInvalidHandle)
+        {
+            routeStops_.resize(firstStop);
+            return false;
+        }
+        routeStops_.push_back(station);
+    }
+
+    const auto index {routeIds_.Intern(route.id)};
+    routes_.push_back(RouteInternal {
+        line,
+        firstStop,
+        static_cast<Index>(route.stops.size())
+    });
+    lines_[line].routes.push_back(index);
 
     return true;
 }
+
+void TransportNetwork::IndexNewRoutes (
+    Index firstRoute
+)
+{
+    /* Count the outgoing edges of each station: the existing ones plus one
+       for each stop of the new routes (except the last one) */
+    const auto nStations {stations_.size()};
+    std::vector<Index> offsets(nStations + 1, 0);
+    for (size_t station {0}; station < nStations; ++station)
+    {
+        offsets[station + 1] = edgeOffsets_[station + 1] - edgeOffsets_[station];
+    }
+    for (auto route {firstRoute}; route < routes_.size(); ++route)
+    {
+        const auto& routeInternal {routes_[route]};
+        for (Index stop {0}; stop + 1 < routeInternal.nStops; ++stop)
+        {
+            ++offsets[routeStops_[routeInternal.firstStop + stop] + 1];
+        }
+    }
+    for (size_t station {0}; station < nStations; ++station)
+    {
+        offsets[station + 1] += offsets[station];
+    }
+
+    /* Place the existing edges first, so that their travel times are kept,
+       then the new ones */
+    std::vector<GraphEdge> edges(offsets.back());
+    std::vector<Index> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t station {0}; station < nStations; ++station)
+    {
+        cursor[station] = std::copy(
+            edges_.begin() + edgeOffsets_[station],
+            edges_.begin() + edgeOffsets_[station + 1],
+            edges.begin() + offsets[station]
+        ) - edges.begin();
+    }
+    for (auto route {firstRoute}; route < routes_.size(); ++route)
+    {
+        const auto& routeInternal {routes_[route]};
+        for (Index stop {0}; stop + 1 < routeInternal.nStops; ++stop)
+        {
+            const auto from {routeStops_[routeInternal.firstStop + stop]};
+            const auto to {routeStops_[routeInternal.firstStop + stop + 1]};
+            edges[cursor[from]++] = GraphEdge {to, route, routeInternal.firstStop + stop, 0};
+        }
+    }
+
+    edgeOffsets_ = std::move(offsets);
+    edges_ = std::move(edges);
+
+    /* Merge the new routes into the routes serving each station the same
+       way. New routes have larger handles than the existing ones, so
+       appending them keeps each station's routes sorted. A route that stops
+       twice at a station is listed once */
+    std::vector<Index> routeOffsets(nStations + 1, 0);
+    for (size_t station {0}; station < nStations; ++station)
+    {
+        routeOffsets[station + 1] = stationRouteOffsets_[station + 1] - stationRouteOffsets_[station];
+    }
+    std::vector<Index> lastRoute(nStations, kInvalidHandle);
+    for (auto route {firstRoute}; route < routes_.size(); ++route)
+    {
+        const auto& routeInternal {routes_[route]};
+        for (auto stop {routeInternal.firstStop}; stop < routeInternal.firstStop + routeInternal.nStops; ++stop)
+        {
+            const auto station {routeStops_[stop]};
+            if (lastRoute[station] != route)
+            {
+                lastRoute[station] = route;
+                ++routeOffsets[station + 1];
+            }
+        }
+    }
+    for (size_t station {0}; station < nStations; ++station)
+    {
+        routeOffsets[station + 1] += routeOffsets[station];
+    }
+    std::vector<Index> stationRoutes(routeOffsets.back());
+    for (size_t station {0}; station < nStations; ++station)
+    {
+        cursor[station] = std::copy(
+            stationRoutes_.begin() + stationRouteOffsets_[station],
+            stationRoutes_.begin() + stationRouteOffsets_[station + 1],
+            stationRoutes.begin() + routeOffsets[station]
+        ) - stationRoutes.begin();
+    }
+    for (auto route {firstRoute}; route < routes_.size(); ++route)
+    {
+        const auto& routeInternal {routes_[route]};
+        for (auto stop {routeInternal.firstStop}; stop < routeInternal.firstStop + routeInternal.nStops; ++stop)
+        {
+            const auto station {routeStops_[stop]};
+            if (cursor[station] == routeOffsets[station] || stationRoutes[cursor[station] - 1] != route)
+            {
+                stationRoutes[cursor[station]++] = route;
+            }
+        }
+    }
+    stationRouteOffsets_ = std::move(routeOffsets);
+    stationRoutes_ = std::move(stationRoutes);
+
+    /* The new route stops start with no travel time */
+    routeTravelTimes_.resize(routeStops_.size(), 0);
+    stopRoutes_.resize(routeStops_.size());
+    for (auto route {firstRoute}; route < routes_.size(); ++route)
+    {
+        const auto& routeInternal {routes_[route]};
+        std::fill_n(stopRoutes_.begin() + routeInternal.firstStop, routeInternal.nStops, route);
+    }
+
+    /* Stop position tables of the new routes. A station the route stops at
+       more than once gets kRepeatedStop: the queries then search its stops */
+    for (auto route {firstRoute}; route < routes_.size(); ++route)
+    {
+        const auto& routeInternal {routes_[route]};
+        const auto nSlots {GetRouteStopSlotCount(routeInternal.nStops)};
+        const auto firstSlot {routeStopSlots_.size()};
+        routeStopSlots_.resize(firstSlot + nSlots);
+        for (auto stop {routeInternal.firstStop}; stop < routeInternal.firstStop + routeInternal.nStops; ++stop)
+        {
+            const auto station {routeStops_[stop]};
+            auto slot {GetRouteStopSlot(station, nSlots)};
+            while (routeStopSlots_[firstSlot + slot].station != kInvalidHandle
+                   && routeStopSlots_[firstSlot + slot].station != station)
+            {
+                slot = (slot + 1) & (nSlots - 1);
+            }
+            auto& routeStopSlot {routeStopSlots_[firstSlot + slot]};
+            routeStopSlot.stop = routeStopSlot.station == station ? kRepeatedStop : stop;
+            routeStopSlot.station = station;
+        }
+        routeStopSlotOffsets_.push_back(static_cast<Index>(routeStopSlots_.size()));
+    }
+
+    /* Rebuild the route stops served at each station */
+    stationStopOffsets_.assign(nStations + 1, 0);
+    for (const auto station: routeStops_)
+    {
+        ++stationStopOffsets_[station + 1];
+    }
+    for (size_t station {0}; station < nStations; ++station)
+    {
+        stationStopOffsets_[station + 1] += stationStopOffsets_[station];
+    }
+    stationStops_.resize(routeStops_.size());
+    cursor.assign(stationStopOffsets_.begin(), stationStopOffsets_.end() - 1);
+    for (Index route {0}; route < routes_.size(); ++route)
+    {
+        const auto& routeInternal {routes_[route]};
+        for (auto stop {routeInternal.firstStop}; stop < routeInternal.firstStop + routeInternal.nStops; ++stop)
+        {
+            stationStops_[cursor[routeStops_[stop]]++] = StationStop {route, stop};
+        }
+    }
+}
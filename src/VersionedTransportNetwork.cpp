@@ -0,0 +1,337 @@
+#include "VersionedTransportNetwork.h"
+#include "TransportNetwork.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+using NetworkMonitor::NetworkVersion;
+using NetworkMonitor::PassengerDelta;
+using NetworkMonitor::PassengerEvent;
+using NetworkMonitor::StationHandle;
+using NetworkMonitor::TransportNetwork;
+using NetworkMonitor::VersionedTransportNetwork;
+
+/* A weak reference to a version only keeps the control block allocated, not
+   the version, as long as they are allocated separately */
+static std::shared_ptr<const NetworkVersion> MakeVersion (
+    TransportNetwork network,
+    std::uint64_t version
+)
+{
+    return std::shared_ptr<const NetworkVersion> {new NetworkVersion {std::move(network), version}};
+}
+
+/* Publication state, shared with the versions so that their late events
+   reach the version that is current when they are released.
+   Readers find the current version through a slot: they pin the slot, check
+   that it is still the current one and copy its reference. Publishers only
+   clear or reuse a slot that is neither current nor pinned. Pinning then
+   checking, and swapping then checking the pins, are sequentially
+   consistent, so either the reader sees the swap or the publisher sees the
+   pin. Slots live as long as the state, so a stale slot pointer is never
+   dangling.
+   Reloads also hold the state, so that they can finish after the holder is
+   gone */
+class VersionedTransportNetwork::State:
+    public std::enable_shared_from_this<VersionedTransportNetwork::State>
+{
+public:
+    explicit State (
+        std::shared_ptr<const NetworkVersion> first
+    )
+    {
+        auto* slot {AllocateSlot()};
+        slot->version = std::move(first);
+        currentVersion_.store(slot->version->GetVersion());
+        current_.store(slot);
+    }
+
+    /* Lock-free. Only retries if a publish swapped the slot in between */
+    std::shared_ptr<const NetworkVersion> LoadCurrent() const
+    {
+        while (true)
+        {
+            auto* slot {current_.load()};
+            slot->pins.fetch_add(1);
+            if (current_.load() == slot)
+            {
+                auto version {slot->version};
+                slot->pins.fetch_sub(1);
+                return version;
+            }
+            slot->pins.fetch_sub(1);
+        }
+    }
+
+    std::uint64_t GetCurrentVersion() const
+    {
+        return currentVersion_.load(std::memory_order_acquire);
+    }
+
+    /* See VersionedTransportNetwork::Publish */
+    std::uint64_t Publish (
+        TransportNetwork network
+    );
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> pins {0};
+        std::shared_ptr<const NetworkVersion> version {};
+    };
+
+    /* Make a version current. Only call it with publishMutex_ held
+       Return the replaced versions no reader can reach anymore, to release
+       after unlocking: their destructors forward their late events */
+    std::vector<std::shared_ptr<const NetworkVersion>> Swap (
+        std::shared_ptr<const NetworkVersion> next
+    )
+    {
+        auto* slot {AllocateSlot()};
+        slot->version = std::move(next);
+        retired_.push_back(current_.exchange(slot));
+        currentVersion_.store(slot->version->GetVersion(), std::memory_order_release);
+
+        std::vector<std::shared_ptr<const NetworkVersion>> released {};
+        auto pinned {retired_.begin()};
+        for (auto* retired: retired_)
+        {
+            if (retired->pins.load() == 0)
+            {
+                released.push_back(std::move(retired->version));
+                free_.push_back(retired);
+            }
+            else
+            {
+                *pinned++ = retired;
+            }
+        }
+        retired_.erase(pinned, retired_.end());
+        return released;
+    }
+
+    Slot* AllocateSlot()
+    {
+        if (!free_.empty())
+        {
+            auto* slot {free_.back()};
+            free_.pop_back();
+            return slot;
+        }
+        slots_.push_back(std::make_unique<Slot>());
+        return slots_.back().get();
+    }
+
+    std::atomic<Slot*> current_ {nullptr};
+    std::atomic<std::uint64_t> currentVersion_ {0};
+
+    /* Serializes publishers. Readers never take it */
+    std::mutex publishMutex_ {};
+
+    /* Only touched by publishers. A slot is retired until no reader pins it,
+       which is almost always by the next publish */
+    std::vector<std::unique_ptr<Slot>> slots_ {};
+    std::vector<Slot*> retired_ {};
+    std::vector<Slot*> free_ {};
+};
+
+/* Carries the passenger counts of an old version over to newer ones
+   The old counters are only read, never reset, so readers still on the old
+   version keep seeing consistent counts. Each sync forwards what was recorded
+   on the old version since the previous sync, mapped by station ID */
+class NetworkVersion::PassengerCountSync
+{
+public:
+    PassengerCountSync (
+        const TransportNetwork& from,
+        std::weak_ptr<const VersionedTransportNetwork::State> holder
+    ) : from_ {from},
+        holder_ {std::move(holder)},
+        synced_(from.GetStationCount(), 0)
+    {
+    }
+
+    void Sync (
+        const NetworkVersion& to
+    )
+    {
+        deltas_.clear();
+        const auto& network {to.GetNetwork()};
+        for (StationHandle station {0}; station < synced_.size(); ++station)
+        {
+            const auto count {from_.GetPassengerCount(station)};
+            const auto delta {count - synced_[station]};
+            synced_[station] = count;
+            if (delta == 0)
+                continue;
+
+            const auto handle {network.GetStationHandle(from_.GetStationId(station))};
+            if (handle != NetworkMonitor::kInvalidHandle)
+            {
+                deltas_.push_back({handle, delta});
+            }
+        }
+        to.RecordPassengerEvents(deltas_.data(), deltas_.size());
+    }
+
+    /* Nothing to forward to once the holder is gone */
+    void SyncToCurrent()
+    {
+        if (auto holder {holder_.lock()})
+        {
+            Sync(*holder->LoadCurrent());
+        }
+    }
+
+private:
+    const TransportNetwork& from_;
+    std::weak_ptr<const VersionedTransportNetwork::State> holder_ {};
+    std::vector<long long int> synced_ {};
+    std::vector<PassengerDelta> deltas_ {};
+};
+
+/* VersionedTransportNetwork::State */
+std::uint64_t VersionedTransportNetwork::State::Publish (
+    TransportNetwork network
+)
+{
+    /* Released after unlocking */
+    std::vector<std::shared_ptr<const NetworkVersion>> released {};
+
+    std::lock_guard<std::mutex> lock {publishMutex_};
+    auto old {LoadCurrent()};
+    auto next {MakeVersion(std::move(network), old->GetVersion() + 1)};
+    const auto version {next->GetVersion()};
+
+    /* Bring the new version up to date before readers can see it, so that
+       the counts do not drop when we swap. Readers that acquired the old
+       version before the swap may still record events on it: the old version
+       forwards them from its destructor, once its last reader is gone */
+    auto counts {std::make_unique<NetworkVersion::PassengerCountSync>(old->GetNetwork(), weak_from_this())};
+    counts->Sync(*next);
+    old->sync_ = std::move(counts);
+    released = Swap(std::move(next));
+
+    return version;
+}
+
+/* NetworkVersion */
+NetworkVersion::NetworkVersion (
+    TransportNetwork network,
+    std::uint64_t version
+) : network_ {std::move(network)},
+    version_ {version}
+{}
+
+NetworkVersion::~NetworkVersion()
+{
+    /* We hold the last reference: no reader can record events anymore.
+       Forward what they recorded since the version was replaced */
+    if (sync_ != nullptr)
+    {
+        sync_->SyncToCurrent();
+    }
+}
+
+std::uint64_t NetworkVersion::GetVersion() const
+{
+    return version_;
+}
+
+const TransportNetwork& NetworkVersion::GetNetwork() const
+{
+    return network_;
+}
+
+bool NetworkVersion::RecordPassengerEvent (
+    const PassengerEvent& event
+) const
+{
+    return network_.RecordPassengerEvent(event);
+}
+
+bool NetworkVersion::RecordPassengerEvent (
+    StationHandle station,
+    PassengerEvent::Type type
+) const
+{
+    return network_.RecordPassengerEvent(station, type);
+}
+
+size_t NetworkVersion::RecordPassengerEvents (
+    const PassengerEvent* events,
+    size_t nEvents
+) const
+{
+    return network_.RecordPassengerEvents(events, nEvents);
+}
+
+size_t NetworkVersion::RecordPassengerEvents (
+    const PassengerDelta* deltas,
+    size_t nDeltas
+) const
+{
+    return network_.RecordPassengerEvents(deltas, nDeltas);
+}
+
+/* VersionedTransportNetwork */
+static std::atomic<std::uint64_t> nextHolderId {1};
+
+VersionedTransportNetwork::VersionedTransportNetwork (
+    TransportNetwork network
+) : id_ {nextHolderId.fetch_add(1, std::memory_order_relaxed)},
+    state_ {std::make_shared<State>(MakeVersion(std::move(network), 1))}
+{}
+
+std::shared_ptr<const NetworkVersion> VersionedTransportNetwork::Acquire() const
+{
+    /* One cache entry per thread. A thread that alternates between holders
+       refreshes it each time, which is correct, only slower */
+    struct ReaderCache
+    {
+        std::uint64_t holder {0};
+        std::uint64_t version {0};
+        std::weak_ptr<const NetworkVersion> current {};
+    };
+    thread_local ReaderCache cache {};
+
+    if (cache.holder == id_ && cache.version == state_->GetCurrentVersion())
+    {
+        auto current {cache.current.lock()};
+        if (current != nullptr)
+            return current;
+    }
+    auto current {state_->LoadCurrent()};
+    cache.holder = id_;
+    cache.version = current->GetVersion();
+    cache.current = current;
+    return current;
+}
+
+std::uint64_t VersionedTransportNetwork::Publish (
+    TransportNetwork network
+)
+{
+    return state_->Publish(std::move(network));
+}
+
+std::future<bool> VersionedTransportNetwork::ReloadAsync (
+    const std::filesystem::path& layout
+)
+{
+    /* The task holds the state, not the holder, which may be gone first */
+    return std::async(std::launch::async, [state = state_, layout]() {
+        TransportNetwork network {};
+        if (!network.FromJson(layout))
+            return false;
+        network.SetCrowdingModel(state->LoadCurrent()->GetNetwork().GetCrowdingModel());
+        state->Publish(std::move(network));
+        return true;
+    });
+}
@@ -6,13 +6,24 @@
 #include <boost/system/error_code.hpp>
 #include <openssl/ssl.h>
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <string_view>
 #include <chrono>
+#include <cmath>
 #include <functional>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+using NetworkMonitor::CompressionOptions;
+using NetworkMonitor::ReconnectOptions;
+using NetworkMonitor::StreamOptions;
 using NetworkMonitor::WebSocketClient;
+using NetworkMonitor::WebSocketClientMetrics;
 
 static void Log (const std::string& where, boost::system::error_code ec)
 {
@@ -22,19 +33,68 @@ static void Log (const std::string& where, boost::system::error_code ec)
               << std::endl;   
 }
 
+/* Only some Beast releases have permessage_deflate::msg_size_threshold, and
+   BOOST_BEAST_VERSION does not tell which, so we look for the member */
+template <typename Options, typename = void>
+struct HasMessageSizeThreshold : std::false_type {};
+
+template <typename Options>
+struct HasMessageSizeThreshold<
+    Options,
+    std::void_t<decltype(std::declval<Options&>().msg_size_threshold)>
+> : std::true_type {};
+
+template <typename Options>
+static void SetMessageSizeThreshold (
+    Options& pmd,
+    size_t threshold
+)
+{
+    if constexpr (HasMessageSizeThreshold<Options>::value)
+    {
+        pmd.msg_size_threshold = threshold;
+    }
+}
+
+boost::beast::websocket::permessage_deflate NetworkMonitor::MakeClientDeflateOptions (
+    const CompressionOptions& options
+)
+{
+    /* The window bits bound both our compressor and the server one */
+    boost::beast::websocket::permessage_deflate pmd {};
+    pmd.client_enable = options.enabled;
+    pmd.client_max_window_bits = std::clamp(options.windowBits, 9, 15);
+    pmd.server_max_window_bits = pmd.client_max_window_bits;
+    pmd.client_no_context_takeover = options.noContextTakeover;
+    pmd.server_no_context_takeover = options.noContextTakeover;
+    pmd.memLevel = std::clamp(options.memLevel, 1, 9);
+    pmd.compLevel = std::clamp(options.level, 0, 9);
+    SetMessageSizeThreshold(pmd, options.threshold);
+    return pmd;
+}
+
 /* Public methods */
 WebSocketClient::WebSocketClient (
     const std::string& url,
     const std::string& endpoint,
     const std::string& port,
     boost::asio::io_context& ioc,
-    boost::asio::ssl::context& ctx
+    boost::asio::ssl::context& ctx,
+    const SendQueueOptions& sendOptions,
+    const StreamOptions& streamOptions
 ) : url_ {url},
     endpoint_ {endpoint},
     port_ {port},
-    resolver_ {boost::asio::make_strand(ioc)},
-    ws_ {boost::asio::make_strand(ioc), ctx}
-{}
+    ctx_ {ctx},
+    strand_ {boost::asio::make_strand(ioc)},
+    ws_ {std::in_place, strand_, ctx},
+    resolver_ {strand_},
+    reconnectTimer_ {strand_},
+    streamOptions_ {streamOptions},
+    sendOptions_ {sendOptions}
+{
+    ApplyStreamOptions();
+}
 
 WebSocketClient::~WebSocketClient() = default;
 
@@ -47,27 +107,76 @@ void WebSocketClient::Connect (
     /* Save the user callbacks for late use */
     onConnect_ = onConnect;
     onMessage_ = onMessage;
+    onMessageView_ = nullptr;
     onDisconnect_ = onDisconnect;
 
     /* Start the chain of asynchronous callbacks */
-    resolver_.async_resolve(url_, port_,
-        [this](auto ec, auto endpoint) {
-            OnResolve(ec, endpoint);
-        }
-    );
+    boost::asio::post(strand_, [this]() {
+        closing_ = false;
+        attempt_ = 0;
+        StartConnect();
+    });
+}
+
+void WebSocketClient::ConnectWithMessageView (
+    std::function<void (boost::system::error_code)> onConnect,
+    std::function<void (boost::system::error_code, std::string_view)> onMessage,
+    std::function<void (boost::system::error_code)> onDisconnect
+)
+{
+    /* Save the user callbacks for late use */
+    onConnect_ = onConnect;
+    onMessage_ = nullptr;
+    onMessageView_ = onMessage;
+    onDisconnect_ = onDisconnect;
+
+    /* Start the chain of asynchronous callbacks */
+    boost::asio::post(strand_, [this]() {
+        closing_ = false;
+        attempt_ = 0;
+        StartConnect();
+    });
+}
+
+void WebSocketClient::ReserveReadBuffer (
+    size_t nBytes
+)
+{
+    rBuffer_.reserve(nBytes);
+}
+
+void WebSocketClient::SetReconnectOptions (
+    const ReconnectOptions& options
+)
+{
+    reconnectOptions_ = options;
 }
 
 void WebSocketClient::Send (
-    const std::string& message,
+    std::string message,
     std::function<void (boost::system::error_code)> onSend
 )
 {
-    ws_.async_write(boost::asio::buffer(message),
-        [this, onSend](auto ec, auto) {
+    /* Reserve room in the queue before handing the message to the strand, so
+       that concurrent senders all see the same byte count */
+    const auto size {message.size()};
+    const auto queued {queuedBytes_.fetch_add(size, std::memory_order_relaxed) + size};
+    if (sendOptions_.highWaterMark != 0 && queued > sendOptions_.highWaterMark)
+    {
+        queuedBytes_.fetch_sub(size, std::memory_order_relaxed);
+        boost::asio::post(strand_, [onSend]() {
             if (onSend)
             {
-                onSend(ec);
+                onSend(boost::asio::error::no_buffer_space);
             }
+        });
+        return;
+    }
+
+    boost::asio::post(strand_,
+        [this, message = std::move(message), onSend = std::move(onSend)]() mutable {
+            sendQueue_.push_back({std::move(message), std::move(onSend)});
+            WriteNext();
         }
     );
 }
@@ -76,43 +185,112 @@ void WebSocketClient::Close (
     std::function<void (boost::system::error_code)> onClose
 )
 {
-    ws_.async_close(boost::beast::websocket::close_code::none,
-        [this, onClose](auto ec) {
-            if (onClose)
-            {
-                onClose(ec);
-            }
+    boost::asio::post(strand_, [this, onClose]() {
+        /* No more reconnections */
+        closing_ = true;
+        reconnectTimer_.cancel();
+
+        /* Beast does not allow a close frame while a write is in progress:
+           OnWrite closes the stream once the write is done */
+        if (writing_)
+        {
+            closePending_ = true;
+            onClose_ = onClose;
+            return;
         }
-    );
+        StartClose(onClose);
+    });
+}
+
+size_t WebSocketClient::GetQueuedBytes() const
+{
+    return queuedBytes_.load(std::memory_order_relaxed);
+}
+
+WebSocketClientMetrics WebSocketClient::GetMetrics() const
+{
+    WebSocketClientMetrics metrics {};
+    metrics.connects = connects_.load(std::memory_order_relaxed);
+    metrics.reconnects = reconnects_.load(std::memory_order_relaxed);
+    metrics.failedAttempts = failedAttempts_.load(std::memory_order_relaxed);
+    metrics.resumedTlsSessions = resumedTlsSessions_.load(std::memory_order_relaxed);
+    metrics.lastHandshakeTime = std::chrono::microseconds {
+        lastHandshakeUs_.load(std::memory_order_relaxed)
+    };
+    metrics.totalHandshakeTime = std::chrono::microseconds {
+        totalHandshakeUs_.load(std::memory_order_relaxed)
+    };
+    metrics.bytesSent = bytesSent_.load(std::memory_order_relaxed);
+    metrics.bytesReceived = bytesReceived_.load(std::memory_order_relaxed);
+    return metrics;
 }
 
 /* Private methods */
+void WebSocketClient::SslSessionDeleter::operator() (
+    SSL_SESSION* session
+) const
+{
+    SSL_SESSION_free(session);
+}
+
+void WebSocketClient::ApplyStreamOptions()
+{
+    ws_->set_option(NetworkMonitor::MakeClientDeflateOptions(streamOptions_.compression));
+
+    ws_->auto_fragment(streamOptions_.autoFragment);
+    ws_->read_message_max(streamOptions_.readMessageMax);
+}
+
+void WebSocketClient::UpdateWireBytes()
+{
+    /* The TLS engine reads and writes its records through this BIO */
+    auto* bio {SSL_get_rbio(ws_->next_layer().native_handle())};
+    if (bio == nullptr)
+    {
+        return;
+    }
+    bytesSent_.store(previousBytesSent_ + BIO_number_written(bio), std::memory_order_relaxed);
+    bytesReceived_.store(previousBytesReceived_ + BIO_number_read(bio), std::memory_order_relaxed);
+}
+
+void WebSocketClient::StartConnect()
+{
+    /* Skip the DNS lookup when reconnecting */
+    if (!endpoints_.empty())
+    {
+        OnResolve({}, endpoints_);
+        return;
+    }
+    resolver_.async_resolve(url_, port_,
+        [this](auto ec, auto endpoints) {
+            OnResolve(ec, endpoints);
+        }
+    );
+}
+
 void WebSocketClient::OnResolve (
     const boost::system::error_code& ec,
-    boost::asio::ip::tcp::resolver::iterator endpoint
+    boost::asio::ip::tcp::resolver::results_type endpoints
 )
 {
     if (ec)
     {
-        Log("OnResolve", ec);
-        if (onConnect_)
-        {
-            onConnect_(ec);
-        }
+        OnConnectFailed("OnResolve", ec);
         return;
     }
+    endpoints_ = endpoints;
 
     /* The following timeout only matters for the purpose of connecting to the
        TCP socket. We will reset the timeout to a sensible default after we are
        connected 
        Note: The TCP layer is the lowest layer (WebSocket -> TLS -> TCP) */
-    boost::beast::get_lowest_layer(ws_).expires_after(std::chrono::seconds(5));
-    // ws_.next_layer().expires_after(std::chrono::seconds(5));
+    boost::beast::get_lowest_layer(*ws_).expires_after(std::chrono::seconds(5));
+    // ws_->next_layer().expires_after(std::chrono::seconds(5));
 
-    /* Connect to the TCP socket.
+    /* Connect to the TCP socket, trying each endpoint in turn.
        Note: The TCP layer is the lowest layer (WebSocket -> TLS -> TCP) */
-    boost::beast::get_lowest_layer(ws_).async_connect(*endpoint,
-        [this](auto ec) {
+    boost::beast::get_lowest_layer(*ws_).async_connect(endpoints_,
+        [this](auto ec, auto) {
             OnConnect(ec);
         }
     );
@@ -124,27 +302,33 @@ void WebSocketClient::OnConnect (
 {
     if (ec)
     {
-        Log("OnConnect", ec);
-        if (onConnect_)
-        {
-            onConnect_(ec);
-        }
+        /* The cached endpoints may be stale: resolve them again next time */
+        endpoints_ = {};
+        OnConnectFailed("OnConnect", ec);
         return;
     }
 
     /* Now that the TCP socket is connected, we can reset the timeout to
        whatever Boost.Beast recommends
        Note: The TCP layer is the lowest layer (WebSocket -> TLS -> TCP) */
-    boost::beast::get_lowest_layer(ws_).expires_never();
-    ws_.set_option(
+    boost::beast::get_lowest_layer(*ws_).expires_never();
+    ws_->set_option(
         boost::beast::websocket::stream_base::timeout::suggested(
             boost::beast::role_type::client
         )
     );
 
+    /* Offer the session of the previous connection, if any. The server
+       decides whether to resume it */
+    handshakeStart_ = std::chrono::steady_clock::now();
+    if (reconnectOptions_.resumeTlsSession && tlsSession_)
+    {
+        SSL_set_session(ws_->next_layer().native_handle(), tlsSession_.get());
+    }
+
     /* Attempt a TLS handshake
        Note: The TCP layer is the lowest layer (WebSocket -> TLS -> TCP) */
-    ws_.next_layer().async_handshake(boost::asio::ssl::stream_base::client,
+    ws_->next_layer().async_handshake(boost::asio::ssl::stream_base::client,
         [this](auto ec) {
             OnTlsHandshake(ec);
         }
@@ -157,16 +341,17 @@ void WebSocketClient::OnTlsHandshake (
 {
     if (ec)
     {
-        Log("OnTlsHandshake", ec);
-        if (onConnect_)
-        {
-            onConnect_(ec);
-        }
+        OnConnectFailed("OnTlsHandshake", ec);
         return;
     }
+    if (SSL_session_reused(ws_->next_layer().native_handle()))
+    {
+        resumedTlsSessions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    tlsSessionSaved_ = SaveTlsSession();
 
     /* Attempt a WebSocket handshake */
-    ws_.async_handshake(url_, endpoint_,
+    ws_->async_handshake(url_, endpoint_,
         [this](auto ec) {
             OnHandshake(ec);
         }
@@ -179,16 +364,27 @@ void WebSocketClient::OnHandshake (
 {
     if (ec)
     {
-        Log("OnConnect", ec);
-        if (onConnect_)
-        {
-            onConnect_(ec);
-        }
+        OnConnectFailed("OnHandshake", ec);
         return;
     }
 
+    const auto handshakeUs {std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - handshakeStart_
+    ).count()};
+    lastHandshakeUs_.store(handshakeUs, std::memory_order_relaxed);
+    totalHandshakeUs_.fetch_add(handshakeUs, std::memory_order_relaxed);
+    connects_.fetch_add(1, std::memory_order_relaxed);
+    if (hasConnected_)
+    {
+        reconnects_.fetch_add(1, std::memory_order_relaxed);
+    }
+    hasConnected_ = true;
+    reconnecting_ = false;
+    attempt_ = 0;
+    UpdateWireBytes();
+
     /* Set the text message write option. */
-    ws_.text(true);
+    ws_->text(true);
 
     /* Set up a recursive asynchronous listener to receive messages */
     ListenToIncomingMessage(ec);
@@ -201,10 +397,106 @@ void WebSocketClient::OnHandshake (
     }
 }
 
+void WebSocketClient::OnConnectFailed (
+    const std::string& where,
+    const boost::system::error_code& ec
+)
+{
+    Log(where, ec);
+    failedAttempts_.fetch_add(1, std::memory_order_relaxed);
+
+    const auto& options {reconnectOptions_};
+    if (options.enabled && !closing_
+        && (options.maxAttempts == 0 || attempt_ < options.maxAttempts))
+    {
+        reconnecting_ = true;
+        ScheduleReconnect();
+        return;
+    }
+
+    reconnecting_ = false;
+    if (onConnect_)
+    {
+        onConnect_(ec);
+    }
+}
+
+void WebSocketClient::ScheduleReconnect()
+{
+    /* Exponential backoff, shortened by a random jitter */
+    const auto& options {reconnectOptions_};
+    auto delayMs {std::min(
+        options.initialDelay.count() * std::pow(options.multiplier, attempt_),
+        static_cast<double>(options.maxDelay.count())
+    )};
+    std::uniform_real_distribution<double> jitter {0.0, std::clamp(options.jitter, 0.0, 1.0)};
+    delayMs *= 1.0 - jitter(rng_);
+    ++attempt_;
+
+    reconnectTimer_.expires_after(std::chrono::microseconds {
+        static_cast<std::int64_t>(delayMs * 1000)
+    });
+    reconnectTimer_.async_wait([this](auto ec) {
+        if (ec || closing_)
+        {
+            return;
+        }
+
+        /* The write in progress still uses the old stream: OnWrite
+           reconnects once it is done */
+        if (writing_)
+        {
+            reconnectPending_ = true;
+            return;
+        }
+        Reconnect();
+    });
+}
+
+void WebSocketClient::Reconnect()
+{
+    /* Start over on a new stream */
+    UpdateWireBytes();
+    previousBytesSent_ = bytesSent_.load(std::memory_order_relaxed);
+    previousBytesReceived_ = bytesReceived_.load(std::memory_order_relaxed);
+    ws_.emplace(strand_, ctx_);
+    ApplyStreamOptions();
+    rBuffer_.consume(rBuffer_.size());
+    StartConnect();
+}
+
+bool WebSocketClient::SaveTlsSession()
+{
+    if (!reconnectOptions_.enabled || !reconnectOptions_.resumeTlsSession)
+        return true;
+
+    /* Keep a copy: when the connection fails, OpenSSL marks its session as
+       not resumable */
+    const auto* session {SSL_get0_session(ws_->next_layer().native_handle())};
+    if (session == nullptr || !SSL_SESSION_is_resumable(session))
+        return false;
+
+    tlsSession_.reset(SSL_SESSION_dup(session));
+    return true;
+}
+
 void WebSocketClient::ListenToIncomingMessage (
     const boost::system::error_code& ec
 )
 {
+    /* The connection dropped: reconnect, unless the user closed it */
+    if (ec && reconnectOptions_.enabled && !closing_)
+    {
+        Log("ListenToIncomingMessage", ec);
+        if (onDisconnect_)
+        {
+            onDisconnect_(ec);
+        }
+        reconnecting_ = true;
+        ScheduleReconnect();
+        return;
+    }
+
     /* Stop processing messages if the connection has been aborted */
     if (ec == boost::asio::error::operation_aborted)
     {
@@ -217,7 +509,7 @@ void WebSocketClient::ListenToIncomingMessage (
 
     /* Read a message asynchronously. On a successful read, process the message
        and recursively call this function again to process the next message */
-    ws_.async_read(rBuffer_,
+    ws_->async_read(rBuffer_,
         [this](auto ec, auto nBytes) {
            OnRead(ec, nBytes);
            ListenToIncomingMessage(ec); 
@@ -230,13 +522,31 @@ void WebSocketClient::OnRead (
     size_t nBytes
 )
 {
+    UpdateWireBytes();
+
     /* We just ignore messages that failed to read */
     if (ec)
     {
         return;
     }
-    /* Parse the message and forward it to the user callback
+    /* TLS 1.3 session tickets arrive after the handshake */
+    if (!tlsSessionSaved_)
+    {
+        tlsSessionSaved_ = SaveTlsSession();
+    }
+
+    /* Forward the message to the user callback
        Note: This call is synchronous and will block the WebSocket strand */
+    if (onMessageView_)
+    {
+        /* A flat_buffer is contiguous: hand out a view over it, then consume
+           it. Consuming everything keeps the capacity for the next read */
+        const auto data {rBuffer_.data()};
+        onMessageView_(ec, std::string_view {static_cast<const char*>(data.data()), nBytes});
+        rBuffer_.consume(nBytes);
+        return;
+    }
+
     std::string message {boost::beast::buffers_to_string(rBuffer_.data())};
     rBuffer_.consume(nBytes);
 
@@ -244,4 +554,139 @@ void WebSocketClient::OnRead (
     {
         onMessage_(ec, std::move(message));
     }
-}
\ No newline at end of file
+}
+
+void WebSocketClient::WriteNext()
+{
+    /* Beast allows a single outstanding write per stream */
+    if (writing_ || sendQueue_.empty())
+    {
+        return;
+    }
+
+    /* Nothing goes out after a close */
+    if (closing_)
+    {
+        FailQueue(boost::asio::error::operation_aborted);
+        return;
+    }
+
+    /* Do not hold messages while reconnecting: they were meant for the
+       previous connection */
+    if (reconnecting_)
+    {
+        FailQueue(boost::asio::error::not_connected);
+        return;
+    }
+    writing_ = true;
+
+    /* Take the first message, then append the following ones while they fit
+       in a coalesced write */
+    writeBuffer_ = std::move(sendQueue_.front().data);
+    inFlight_.push_back(std::move(sendQueue_.front().onSend));
+    sendQueue_.pop_front();
+    if (sendOptions_.coalesce)
+    {
+        while (!sendQueue_.empty()
+               && writeBuffer_.size() + sendQueue_.front().data.size()
+                  <= sendOptions_.maxCoalescedSize)
+        {
+            writeBuffer_ += sendQueue_.front().data;
+            inFlight_.push_back(std::move(sendQueue_.front().onSend));
+            sendQueue_.pop_front();
+        }
+    }
+
+    ws_->async_write(boost::asio::buffer(writeBuffer_),
+        [this](auto ec, auto) {
+            OnWrite(ec);
+        }
+    );
+}
+
+void WebSocketClient::OnWrite (
+    const boost::system::error_code& ec
+)
+{
+    queuedBytes_.fetch_sub(writeBuffer_.size(), std::memory_order_relaxed);
+    writing_ = false;
+    UpdateWireBytes();
+
+    /* A failed write leaves the stream unusable: fail the whole queue */
+    auto callbacks {std::move(inFlight_)};
+    inFlight_.clear();
+    if (ec)
+    {
+        Log("OnWrite", ec);
+        for (auto& message: sendQueue_)
+        {
+            queuedBytes_.fetch_sub(message.data.size(), std::memory_order_relaxed);
+            callbacks.push_back(std::move(message.onSend));
+        }
+        sendQueue_.clear();
+    }
+
+    /* Callbacks may queue more messages. Those are posted, so they land after
+       the messages already in the queue */
+    for (auto& onSend: callbacks)
+    {
+        if (onSend)
+        {
+            onSend(ec);
+        }
+    }
+    if (closePending_)
+    {
+        closePending_ = false;
+        reconnectPending_ = false;
+        StartClose(std::move(onClose_));
+        onClose_ = nullptr;
+        return;
+    }
+    if (reconnectPending_)
+    {
+        reconnectPending_ = false;
+        if (!closing_)
+        {
+            Reconnect();
+        }
+        return;
+    }
+    WriteNext();
+}
+
+void WebSocketClient::StartClose (
+    std::function<void (boost::system::error_code)> onClose
+)
+{
+    /* The messages still queued will never be written */
+    FailQueue(boost::asio::error::operation_aborted);
+    ws_->async_close(boost::beast::websocket::close_code::none,
+        [onClose](auto ec) {
+            if (onClose)
+            {
+                onClose(ec);
+            }
+        }
+    );
+}
+
+void WebSocketClient::FailQueue (
+    const boost::system::error_code& ec
+)
+{
+    std::vector<std::function<void (boost::system::error_code)>> callbacks {};
+    for (auto& message: sendQueue_)
+    {
+        queuedBytes_.fetch_sub(message.data.size(), std::memory_order_relaxed);
+        callbacks.push_back(std::move(message.onSend));
+    }
+    sendQueue_.clear();
+    for (auto& onSend: callbacks)
+    {
+        if (onSend)
+        {
+            onSend(ec);
+        }
+    }
+}
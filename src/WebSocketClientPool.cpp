@@ -0,0 +1,376 @@
+#include "WebSocketClientPool.h"
+#include "WebSocketClient.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using NetworkMonitor::ConnectionStats;
+using NetworkMonitor::PoolStats;
+using NetworkMonitor::WebSocketClient;
+using NetworkMonitor::WebSocketClientPool;
+using NetworkMonitor::WebSocketPoolOptions;
+
+/* Public methods */
+WebSocketClientPool::WebSocketClientPool (
+    const std::string& url,
+    const std::string& endpoint,
+    const std::string& port,
+    boost::asio::ssl::context& ctx,
+    const WebSocketPoolOptions& options
+) : options_ {options}
+{
+    /* Each client creates its own strand on the shared io_context */
+    const auto nConnections {std::max<size_t>(options_.nConnections, 1)};
+    connections_.reserve(nConnections);
+    for (size_t idx {0}; idx < nConnections; ++idx)
+    {
+        auto connection {std::make_unique<Connection>()};
+        connection->client = std::make_unique<WebSocketClient>(
+            url, endpoint, port, ioc_, ctx, options_.sendOptions, options_.streamOptions
+        );
+        connection->client->SetReconnectOptions(options_.reconnectOptions);
+        connections_.push_back(std::move(connection));
+    }
+}
+
+WebSocketClientPool::~WebSocketClientPool()
+{
+    Stop();
+}
+
+void WebSocketClientPool::Start (
+    OnConnect onConnect,
+    OnMessage onMessage,
+    OnDisconnect onDisconnect
+)
+{
+    /* A closed WebSocketClient cannot reconnect, so neither can the pool */
+    if (stopping_ || running_.exchange(true))
+        return;
+
+    startTime_ = std::chrono::steady_clock::now();
+    work_.emplace(boost::asio::make_work_guard(ioc_));
+
+    for (size_t idx {0}; idx < connections_.size(); ++idx)
+    {
+        auto& connection {*connections_[idx]};
+
+        /* All wrappers run on the connection strand */
+        auto onClientConnect {[this, idx, &connection, onConnect](auto ec) {
+            std::vector<PendingMessage> failed {};
+            if (ec)
+            {
+                /* The client gave up */
+                failed = DropSubscriptions(connection);
+            }
+            else
+            {
+                /* Flush under the lock: a concurrent Subscribe either queued
+                   its message before us or sees the connection up and posts
+                   it after the pending ones */
+                std::lock_guard<std::mutex> lock {connection.mutex};
+                connection.connected = true;
+
+                /* A new session does not know the subscriptions of the
+                   previous one: renew them first */
+                for (const auto& message: connection.subscriptions)
+                {
+                    SendOn(connection, message, nullptr);
+                }
+                for (auto& message: connection.pending)
+                {
+                    connection.subscriptions.push_back(message.data);
+                    SendOn(connection, std::move(message.data), std::move(message.onSend));
+                }
+                connection.pending.clear();
+            }
+            for (auto& message: failed)
+            {
+                connection.sendErrors.fetch_add(1, std::memory_order_relaxed);
+                if (message.onSend)
+                {
+                    message.onSend(ec);
+                }
+            }
+            if (onConnect)
+            {
+                onConnect(idx, ec);
+            }
+        }};
+        auto onClientMessage {[idx, &connection, onMessage](auto ec, std::string_view message) {
+            if (!ec)
+            {
+                connection.messagesReceived.fetch_add(1, std::memory_order_relaxed);
+                connection.bytesReceived.fetch_add(message.size(), std::memory_order_relaxed);
+            }
+            if (onMessage)
+            {
+                onMessage(idx, ec, message);
+            }
+        }};
+        auto onClientDisconnect {[this, idx, &connection, onDisconnect](auto ec) {
+            if (options_.reconnectOptions.enabled || stopping_)
+            {
+                std::lock_guard<std::mutex> lock {connection.mutex};
+                connection.connected = false;
+            }
+            else
+            {
+                /* Without reconnections the connection is gone for good.
+                   Nothing can be pending while it was up */
+                DropSubscriptions(connection);
+            }
+            if (onDisconnect)
+            {
+                onDisconnect(idx, ec);
+            }
+        }};
+        connection.client->ConnectWithMessageView(
+            onClientConnect, onClientMessage, onClientDisconnect
+        );
+    }
+
+    const auto nThreads {std::max(options_.nThreads, 1u)};
+    threads_.reserve(nThreads);
+    for (unsigned int idx {0}; idx < nThreads; ++idx)
+    {
+        threads_.emplace_back([this]() {
+            ioc_.run();
+        });
+    }
+}
+
+void WebSocketClientPool::Stop()
+{
+    if (!running_)
+        return;
+
+    stopping_ = true;
+    const auto deadline {std::chrono::steady_clock::now() + options_.drainTimeout};
+
+    /* Drain: Send and Subscribe are refused from now on, wait for what is
+       already queued to be written */
+    auto drained {[this]() {
+        return std::all_of(connections_.begin(), connections_.end(), [](const auto& connection) {
+            return connection->client->GetQueuedBytes() == 0;
+        });
+    }};
+    while (!drained() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    /* Close all connections. Close runs on each connection strand, after the
+       callbacks already in flight */
+    {
+        std::lock_guard<std::mutex> lock {closeMutex_};
+        nClosed_ = 0;
+    }
+    for (auto& connection: connections_)
+    {
+        connection->client->Close([this](auto) {
+            std::lock_guard<std::mutex> lock {closeMutex_};
+            ++nClosed_;
+            closeCv_.notify_all();
+        });
+    }
+    bool closed {false};
+    {
+        std::unique_lock<std::mutex> lock {closeMutex_};
+        closed = closeCv_.wait_until(lock, deadline, [this]() {
+            return nClosed_ == connections_.size();
+        });
+    }
+
+    /* Let the threads leave once the connections have wound down. If some
+       did not close in time, abort them */
+    work_.reset();
+    if (!closed)
+    {
+        ioc_.stop();
+    }
+    for (auto& thread: threads_)
+    {
+        thread.join();
+    }
+    threads_.clear();
+
+    /* Subscriptions of connections that never came up are not sent */
+    for (auto& connection: connections_)
+    {
+        std::vector<PendingMessage> pending {};
+        {
+            std::lock_guard<std::mutex> lock {connection->mutex};
+            connection->connected = false;
+            pending = std::move(connection->pending);
+            connection->pending.clear();
+        }
+        for (auto& message: pending)
+        {
+            connection->sendErrors.fetch_add(1, std::memory_order_relaxed);
+            if (message.onSend)
+            {
+                message.onSend(boost::asio::error::operation_aborted);
+            }
+        }
+    }
+    running_ = false;
+}
+
+std::optional<size_t> WebSocketClientPool::Subscribe (
+    std::string message,
+    std::function<void (boost::system::error_code)> onSend
+)
+{
+    if (stopping_)
+        return std::nullopt;
+
+    /* Pick the least loaded connection that did not give up. Ties go to the
+       lowest index. Queue the message before letting go of the subscribe
+       mutex, so that the connection cannot drop its subscriptions in
+       between */
+    std::lock_guard<std::mutex> subscribeLock {subscribeMutex_};
+    std::optional<size_t> idx {};
+    for (size_t candidate {0}; candidate < connections_.size(); ++candidate)
+    {
+        if (connections_[candidate]->failed)
+            continue;
+
+        if (!idx.has_value()
+            || connections_[candidate]->nSubscriptions.load(std::memory_order_relaxed)
+                < connections_[*idx]->nSubscriptions.load(std::memory_order_relaxed))
+        {
+            idx = candidate;
+        }
+    }
+    if (!idx.has_value())
+        return std::nullopt;
+
+    auto& connection {*connections_[*idx]};
+    connection.nSubscriptions.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock {connection.mutex};
+    if (connection.connected)
+    {
+        connection.subscriptions.push_back(message);
+        SendOn(connection, std::move(message), std::move(onSend));
+    }
+    else
+    {
+        connection.pending.push_back({std::move(message), std::move(onSend)});
+    }
+    return idx;
+}
+
+bool WebSocketClientPool::Send (
+    size_t connection,
+    std::string message,
+    std::function<void (boost::system::error_code)> onSend
+)
+{
+    if (stopping_ || connection >= connections_.size())
+        return false;
+
+    SendOn(*connections_[connection], std::move(message), std::move(onSend));
+    return true;
+}
+
+size_t WebSocketClientPool::GetConnectionCount() const
+{
+    return connections_.size();
+}
+
+PoolStats WebSocketClientPool::GetStats() const
+{
+    PoolStats stats {};
+    stats.connections.reserve(connections_.size());
+    for (const auto& connection: connections_)
+    {
+        ConnectionStats connectionStats {};
+        {
+            std::lock_guard<std::mutex> lock {connection->mutex};
+            connectionStats.connected = connection->connected;
+        }
+        connectionStats.nSubscriptions = connection->nSubscriptions.load(std::memory_order_relaxed);
+        connectionStats.messagesReceived = connection->messagesReceived.load(std::memory_order_relaxed);
+        connectionStats.bytesReceived = connection->bytesReceived.load(std::memory_order_relaxed);
+        connectionStats.messagesSent = connection->messagesSent.load(std::memory_order_relaxed);
+        connectionStats.bytesSent = connection->bytesSent.load(std::memory_order_relaxed);
+        connectionStats.sendErrors = connection->sendErrors.load(std::memory_order_relaxed);
+        connectionStats.reconnects = connection->client->GetMetrics().reconnects;
+
+        stats.nConnected += connectionStats.connected;
+        stats.messagesReceived += connectionStats.messagesReceived;
+        stats.bytesReceived += connectionStats.bytesReceived;
+        stats.messagesSent += connectionStats.messagesSent;
+        stats.bytesSent += connectionStats.bytesSent;
+        stats.sendErrors += connectionStats.sendErrors;
+        stats.reconnects += connectionStats.reconnects;
+        stats.connections.push_back(connectionStats);
+    }
+
+    if (startTime_ != std::chrono::steady_clock::time_point {})
+    {
+        stats.elapsed = std::chrono::steady_clock::now() - startTime_;
+    }
+    if (stats.elapsed.count() > 0)
+    {
+        stats.messagesPerSecond = stats.messagesReceived / stats.elapsed.count();
+        stats.bytesPerSecond = stats.bytesReceived / stats.elapsed.count();
+    }
+    return stats;
+}
+
+/* Private methods */
+std::vector<WebSocketClientPool::PendingMessage> WebSocketClientPool::DropSubscriptions (
+    Connection& connection
+)
+{
+    std::lock_guard<std::mutex> subscribeLock {subscribeMutex_};
+    std::lock_guard<std::mutex> lock {connection.mutex};
+    connection.failed = true;
+    connection.connected = false;
+    connection.nSubscriptions.store(0, std::memory_order_relaxed);
+    connection.subscriptions.clear();
+    auto pending {std::move(connection.pending)};
+    connection.pending.clear();
+    return pending;
+}
+
+void WebSocketClientPool::SendOn (
+    Connection& connection,
+    std::string message,
+    std::function<void (boost::system::error_code)> onSend
+)
+{
+    const auto size {message.size()};
+    connection.client->Send(std::move(message),
+        [&connection, size, onSend = std::move(onSend)](auto ec) {
+            if (ec)
+            {
+                connection.sendErrors.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                connection.messagesSent.fetch_add(1, std::memory_order_relaxed);
+                connection.bytesSent.fetch_add(size, std::memory_order_relaxed);
+            }
+            if (onSend)
+            {
+                onSend(ec);
+            }
+        }
+    );
+}
@@ -0,0 +1,153 @@
+#include "AwaitableWebSocketClient.h"
+#include "TestServer.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <string_view>
+
+using NetworkMonitor::AwaitableWebSocketClient;
+using NetworkMonitor::StreamOptions;
+using NetworkMonitor::TestServer;
+using NetworkMonitor::TestServerOptions;
+
+using boost::asio::awaitable;
+
+static TestServerOptions GetServerOptions()
+{
+    TestServerOptions options {};
+    options.certFile = TESTS_SERVER_CERT_PEM;
+    options.keyFile = TESTS_SERVER_KEY_PEM;
+    return options;
+}
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+BOOST_AUTO_TEST_SUITE(class_AwaitableWebSocketClient);
+
+BOOST_AUTO_TEST_CASE(echo)
+{
+    TestServer server {GetServerOptions()};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+    AwaitableWebSocketClient client {"localhost", "/echo", std::to_string(port), ioc, ctx};
+
+    const int nMessages {100};
+    boost::system::error_code connectError {};
+    boost::system::error_code sendError {};
+    boost::system::error_code readError {};
+    boost::system::error_code closeError {};
+    std::string expected {};
+    std::string echo {};
+    int nReceived {0};
+
+    /* One coroutine writes while another reads, both on the client strand */
+    auto reader {[&]() -> awaitable<void> {
+        while (nReceived < nMessages)
+        {
+            auto [ec, message] {co_await client.Read()};
+            if (ec)
+            {
+                readError = ec;
+                break;
+            }
+            echo += message;
+            ++nReceived;
+        }
+        closeError = co_await client.Close();
+    }};
+    auto writer {[&]() -> awaitable<void> {
+        connectError = co_await client.Connect();
+        if (connectError)
+        {
+            co_return;
+        }
+        boost::asio::co_spawn(client.GetExecutor(), reader, boost::asio::detached);
+        for (int idx {0}; idx < nMessages; ++idx)
+        {
+            const auto message {"message " + std::to_string(idx) + ";"};
+            expected += message;
+            sendError = co_await client.Send(message);
+            if (sendError)
+            {
+                break;
+            }
+        }
+    }};
+    boost::asio::co_spawn(client.GetExecutor(), writer, boost::asio::detached);
+    ioc.run();
+
+    BOOST_CHECK(!connectError);
+    BOOST_CHECK(!sendError);
+    BOOST_CHECK(!readError);
+    BOOST_CHECK(!closeError);
+    BOOST_CHECK_EQUAL(nReceived, nMessages);
+    BOOST_CHECK_EQUAL(echo, expected);
+}
+
+BOOST_AUTO_TEST_CASE(read_message_max)
+{
+    TestServer server {GetServerOptions()};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+    StreamOptions streamOptions {};
+    streamOptions.readMessageMax = 1024;
+    AwaitableWebSocketClient client {"localhost", "/echo", std::to_string(port), ioc, ctx,
+                                     streamOptions};
+
+    /* The echo of a message above the limit fails the read */
+    boost::system::error_code connectError {};
+    boost::system::error_code readError {};
+    boost::asio::co_spawn(client.GetExecutor(), [&]() -> awaitable<void> {
+        connectError = co_await client.Connect();
+        if (connectError)
+        {
+            co_return;
+        }
+        const std::string message(2048, 'x');
+        co_await client.Send(message);
+        auto [ec, received] {co_await client.Read()};
+        readError = ec;
+    }, boost::asio::detached);
+    ioc.run();
+
+    BOOST_CHECK(!connectError);
+    BOOST_CHECK(readError);
+}
+
+BOOST_AUTO_TEST_CASE(connect_failure)
+{
+    /* Grab a free port, then close it so that nobody listens on it */
+    std::string port {};
+    {
+        boost::asio::io_context ioc {};
+        boost::asio::ip::tcp::acceptor acceptor {
+            ioc, {boost::asio::ip::make_address("127.0.0.1"), 0}
+        };
+        port = std::to_string(acceptor.local_endpoint().port());
+    }
+
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    AwaitableWebSocketClient client {"127.0.0.1", "/echo", port, ioc, ctx};
+
+    boost::system::error_code connectError {};
+    boost::asio::co_spawn(client.GetExecutor(), [&]() -> awaitable<void> {
+        connectError = co_await client.Connect();
+    }, boost::asio::detached);
+    ioc.run();
+
+    BOOST_CHECK(connectError == boost::asio::error::connection_refused);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* class_AwaitableWebSocketClient */
+BOOST_AUTO_TEST_SUITE_END();    /* network_monitor */
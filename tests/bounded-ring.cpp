@@ -0,0 +1,97 @@
+#include "BoundedRing.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using NetworkMonitor::BoundedRing;
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+BOOST_AUTO_TEST_SUITE(class_BoundedRing);
+
+BOOST_AUTO_TEST_CASE(push_pop)
+{
+    /* The capacity is rounded up to a power of 2 */
+    BoundedRing<std::string> ring {3};
+    BOOST_CHECK_EQUAL(ring.Capacity(), 4);
+
+    for (auto value: {"a", "b", "c", "d"})
+    {
+        std::string pushed {value};
+        BOOST_CHECK(ring.TryPush(pushed));
+    }
+    std::string extra {"e"};
+    BOOST_CHECK(!ring.TryPush(extra));
+    BOOST_CHECK_EQUAL(extra, "e");
+    BOOST_CHECK_EQUAL(ring.Size(), 4);
+
+    /* First in, first out, also across laps */
+    std::string value {};
+    BOOST_REQUIRE(ring.TryPop(value));
+    BOOST_CHECK_EQUAL(value, "a");
+    BOOST_CHECK(ring.TryPush(extra));
+    for (auto expected: {"b", "c", "d", "e"})
+    {
+        BOOST_REQUIRE(ring.TryPop(value));
+        BOOST_CHECK_EQUAL(value, expected);
+    }
+    BOOST_CHECK(!ring.TryPop(value));
+    BOOST_CHECK_EQUAL(ring.Size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent)
+{
+    BoundedRing<long long int> ring {64};
+    constexpr int nProducers {3};
+    constexpr int nConsumers {3};
+    constexpr long long int nValues {100000};
+
+    /* Every value pushed is popped exactly once */
+    std::atomic<long long int> sum {0};
+    std::atomic<long long int> nPopped {0};
+    std::vector<std::thread> threads {};
+    for (int producer {0}; producer < nProducers; ++producer)
+    {
+        threads.emplace_back([&ring]() {
+            for (long long int idx {1}; idx <= nValues; ++idx)
+            {
+                auto value {idx};
+                while (!ring.TryPush(value))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int consumer {0}; consumer < nConsumers; ++consumer)
+    {
+        threads.emplace_back([&ring, &sum, &nPopped]() {
+            long long int value {0};
+            while (nPopped.load() < nProducers * nValues)
+            {
+                if (ring.TryPop(value))
+                {
+                    sum += value;
+                    ++nPopped;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+
+    BOOST_CHECK_EQUAL(nPopped.load(), nProducers * nValues);
+    BOOST_CHECK_EQUAL(sum.load(), nProducers * nValues * (nValues + 1) / 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* class_BoundedRing */
+BOOST_AUTO_TEST_SUITE_END();    /* network_monitor */
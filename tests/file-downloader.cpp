@@ -1,14 +1,47 @@
 #include <FileDownloader.h>
+#include <TestServer.h>
+#include <TransportNetwork.h>
 
 #include <boost/asio.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
 #include <filesystem>
+#include <iterator>
 #include <string>
 #include <fstream>
+#include <istream>
+#include <vector>
 
 using NetworkMonitor::DownloadFile;
+using NetworkMonitor::DownloadOptions;
+using NetworkMonitor::DownloadResult;
+using NetworkMonitor::FileDownloader;
+using NetworkMonitor::LoadJsonFile;
+using NetworkMonitor::MultiFileDownloader;
+using NetworkMonitor::ParseJson;
 using NetworkMonitor::ParseJsonFile;
+using NetworkMonitor::TestServer;
+using NetworkMonitor::TestServerOptions;
+using NetworkMonitor::TransportNetwork;
+
+static TestServerOptions GetLayoutServerOptions()
+{
+    TestServerOptions options {};
+    options.certFile = TESTS_SERVER_CERT_PEM;
+    options.keyFile = TESTS_SERVER_KEY_PEM;
+    options.layoutFile = TESTS_NETWORK_LAYOUT_JSON;
+    options.nThreads = 2;
+    return options;
+}
+
+static std::string ReadFile (
+    const std::filesystem::path& src
+)
+{
+    std::ifstream file {src, std::ios::binary};
+    return {std::istreambuf_iterator<char> {file}, std::istreambuf_iterator<char> {}};
+}
 
 BOOST_AUTO_TEST_SUITE(network_monitor);
 
@@ -50,6 +83,339 @@ BOOST_AUTO_TEST_CASE(test_file_download)
 
 }
 
+BOOST_AUTO_TEST_CASE(test_file_download_local)
+{
+    /* Serve the test layout from the local HTTPS server */
+    TestServerOptions options {};
+    options.certFile = TESTS_SERVER_CERT_PEM;
+    options.keyFile = TESTS_SERVER_KEY_PEM;
+    options.layoutFile = TESTS_NETWORK_LAYOUT_JSON;
+    TestServer server {options};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+
+    const std::string fileURL {
+        "https://localhost:" + std::to_string(port) + options.layoutEndpoint
+    };
+    const auto destination {
+        std::filesystem::temp_directory_path() / "network-layout-local.json"
+    };
+
+    bool downloaded {DownloadFile(fileURL, destination, TESTS_SERVER_CERT_PEM)};
+    BOOST_CHECK(downloaded);
+    BOOST_CHECK(ParseJsonFile(destination) == ParseJsonFile(options.layoutFile));
+
+    /* Clean up */
+    std::filesystem::remove(destination);
+}
+
+BOOST_AUTO_TEST_CASE(test_downloader_conditional)
+{
+    TestServer server {GetLayoutServerOptions()};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+    const std::string baseURL {"https://localhost:" + std::to_string(port)};
+    const std::string fileURL {baseURL + "/network-layout.json"};
+    const auto destination {
+        std::filesystem::temp_directory_path() / "network-layout-conditional.json"
+    };
+    const auto expected {ReadFile(TESTS_NETWORK_LAYOUT_JSON)};
+
+    FileDownloader downloader {TESTS_SERVER_CERT_PEM};
+    const auto full {downloader.Download(fileURL, destination)};
+    BOOST_CHECK(full.ok);
+    BOOST_CHECK_EQUAL(full.httpStatus, 200);
+    BOOST_CHECK_EQUAL(full.bytesReceived, expected.size());
+    BOOST_CHECK_EQUAL(full.newConnections, 1);
+    BOOST_CHECK(!full.etag.empty());
+    BOOST_CHECK(!full.lastModified.empty());
+    BOOST_CHECK(ReadFile(destination) == expected);
+
+    /* Unchanged file: one 304 on the same connection, without a body */
+    DownloadOptions byETag {};
+    byETag.etag = full.etag;
+    const auto notModified {downloader.Download(fileURL, destination, byETag)};
+    BOOST_CHECK(notModified.ok);
+    BOOST_CHECK(notModified.notModified);
+    BOOST_CHECK_EQUAL(notModified.bytesReceived, 0);
+    BOOST_CHECK_EQUAL(notModified.newConnections, 0);
+
+    DownloadOptions byDate {};
+    byDate.lastModified = full.lastModified;
+    const auto notModifiedSince {downloader.Download(fileURL, destination, byDate)};
+    BOOST_CHECK(notModifiedSince.notModified);
+    BOOST_CHECK(ReadFile(destination) == expected);
+
+    /* A stale validator gets the whole file */
+    byETag.etag = "\"stale\"";
+    const auto modified {downloader.Download(fileURL, destination, byETag)};
+    BOOST_CHECK(modified.ok);
+    BOOST_CHECK_EQUAL(modified.httpStatus, 200);
+    BOOST_CHECK_EQUAL(modified.bytesReceived, expected.size());
+
+    /* HTTP errors fail, and leave the destination alone */
+    const auto missing {downloader.Download(baseURL + "/missing.json", destination)};
+    BOOST_CHECK(!missing.ok);
+    BOOST_CHECK_EQUAL(missing.httpStatus, 404);
+    BOOST_CHECK(ReadFile(destination) == expected);
+
+    const auto stats {server.GetStats()};
+    BOOST_CHECK_EQUAL(stats.connections, 1);
+    BOOST_CHECK_EQUAL(stats.httpRequests, 5);
+    BOOST_CHECK_EQUAL(stats.layoutBytesSent, 2 * expected.size());
+    BOOST_TEST_MESSAGE("Full download: " << full.elapsed.count() << " us, 304: "
+                       << notModified.elapsed.count() << " us");
+
+    std::filesystem::remove(destination);
+}
+
+BOOST_AUTO_TEST_CASE(test_downloader_resume)
+{
+    TestServer server {GetLayoutServerOptions()};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+    const std::string fileURL {
+        "https://localhost:" + std::to_string(port) + "/network-layout.json"
+    };
+    const auto destination {
+        std::filesystem::temp_directory_path() / "network-layout-resume.json"
+    };
+    const auto expected {ReadFile(TESTS_NETWORK_LAYOUT_JSON)};
+
+    /* Leave a partial download behind, with its validator */
+    FileDownloader downloader {TESTS_SERVER_CERT_PEM};
+    const auto full {downloader.Download(fileURL, destination)};
+    BOOST_REQUIRE(full.ok);
+    const size_t partial {expected.size() / 3};
+    std::filesystem::resize_file(destination, partial);
+
+    DownloadOptions options {};
+    options.resume = true;
+    options.partialValidator = full.etag;
+    const auto resumed {downloader.Download(fileURL, destination, options)};
+    BOOST_CHECK(resumed.ok);
+    BOOST_CHECK(resumed.resumed);
+    BOOST_CHECK_EQUAL(resumed.httpStatus, 206);
+    BOOST_CHECK_EQUAL(resumed.bytesReceived, expected.size() - partial);
+    BOOST_CHECK(ReadFile(destination) == expected);
+
+    /* Nothing left to fetch */
+    const auto complete {downloader.Download(fileURL, destination, options)};
+    BOOST_CHECK(complete.ok);
+    BOOST_CHECK_EQUAL(complete.httpStatus, 416);
+    BOOST_CHECK(ReadFile(destination) == expected);
+
+    BOOST_CHECK_EQUAL(server.GetStats().layoutBytesSent, 2 * expected.size() - partial);
+
+    /* Without a validator we cannot tell the partial file is current */
+    std::filesystem::resize_file(destination, partial);
+    options.partialValidator.clear();
+    const auto unvalidated {downloader.Download(fileURL, destination, options)};
+    BOOST_CHECK(unvalidated.ok);
+    BOOST_CHECK(!unvalidated.resumed);
+    BOOST_CHECK_EQUAL(unvalidated.httpStatus, 200);
+    BOOST_CHECK(ReadFile(destination) == expected);
+
+    std::filesystem::remove(destination);
+}
+
+BOOST_AUTO_TEST_CASE(test_downloader_resume_changed)
+{
+    /* Serve a copy of the layout that we can change */
+    const auto served {
+        std::filesystem::temp_directory_path() / "network-layout-served.json"
+    };
+    std::filesystem::copy_file(
+        TESTS_NETWORK_LAYOUT_JSON,
+        served,
+        std::filesystem::copy_options::overwrite_existing
+    );
+    auto serverOptions {GetLayoutServerOptions()};
+    serverOptions.layoutFile = served;
+    TestServer server {serverOptions};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+    const std::string fileURL {
+        "https://localhost:" + std::to_string(port) + "/network-layout.json"
+    };
+    const auto destination {
+        std::filesystem::temp_directory_path() / "network-layout-resume-changed.json"
+    };
+
+    FileDownloader downloader {TESTS_SERVER_CERT_PEM};
+    const auto full {downloader.Download(fileURL, destination)};
+    BOOST_REQUIRE(full.ok);
+    const auto partial {std::filesystem::file_size(destination) / 2};
+
+    /* The file changes between the partial download and its resumption:
+       the server must send the new file whole, for either validator */
+    auto changeFile {[&served](const std::string& prefix) {
+        const auto content {prefix + ReadFile(served)};
+        const auto modified {std::filesystem::last_write_time(served)};
+        std::ofstream {served, std::ios::binary | std::ios::trunc} << content;
+        std::filesystem::last_write_time(served, modified + std::chrono::hours {1});
+        return content;
+    }};
+    for (const auto& validator: {full.etag, full.lastModified})
+    {
+        std::filesystem::resize_file(destination, partial);
+        const auto expected {changeFile(" ")};
+
+        DownloadOptions options {};
+        options.resume = true;
+        options.partialValidator = validator;
+        const auto result {downloader.Download(fileURL, destination, options)};
+        BOOST_CHECK(result.ok);
+        BOOST_CHECK(!result.resumed);
+        BOOST_CHECK_EQUAL(result.httpStatus, 200);
+        BOOST_CHECK_EQUAL(result.bytesReceived, expected.size());
+        BOOST_CHECK(ReadFile(destination) == expected);
+    }
+
+    std::filesystem::remove(destination);
+    std::filesystem::remove(served);
+}
+
+BOOST_AUTO_TEST_CASE(test_downloader_stream)
+{
+    TestServer server {GetLayoutServerOptions()};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+    const std::string baseURL {"https://localhost:" + std::to_string(port)};
+    const std::string fileURL {baseURL + "/network-layout.json"};
+    const auto cacheFile {
+        std::filesystem::temp_directory_path() / "network-layout-stream.json"
+    };
+    std::filesystem::remove(cacheFile);
+    const auto expected {ReadFile(TESTS_NETWORK_LAYOUT_JSON)};
+
+    TransportNetwork fromFile {};
+    BOOST_REQUIRE(fromFile.FromJson(std::filesystem::path {TESTS_NETWORK_LAYOUT_JSON}));
+
+    /* Parse the layout while it downloads, and keep a copy */
+    FileDownloader downloader {TESTS_SERVER_CERT_PEM};
+    TransportNetwork nw {};
+    size_t nCalls {0};
+    auto load {[&nw, &nCalls](std::istream& body) {
+        ++nCalls;
+        return nw.FromJson(body);
+    }};
+    const auto full {downloader.Stream(fileURL, load, {}, cacheFile)};
+    BOOST_CHECK(full.ok);
+    BOOST_CHECK_EQUAL(full.httpStatus, 200);
+    BOOST_CHECK_EQUAL(full.bytesReceived, expected.size());
+    BOOST_CHECK_EQUAL(nCalls, 1);
+    BOOST_CHECK_EQUAL(nw.GetStationCount(), fromFile.GetStationCount());
+    BOOST_CHECK(nw.GetRoutesServingStation("station_012")
+                == fromFile.GetRoutesServingStation("station_012"));
+    BOOST_CHECK(ReadFile(cacheFile) == expected);
+
+    /* Unchanged file: the consumer is not called and the cache stays */
+    DownloadOptions options {};
+    options.etag = full.etag;
+    const auto notModified {downloader.Stream(fileURL, load, options, cacheFile)};
+    BOOST_CHECK(notModified.ok);
+    BOOST_CHECK(notModified.notModified);
+    BOOST_CHECK_EQUAL(notModified.newConnections, 0);
+    BOOST_CHECK_EQUAL(nCalls, 1);
+    BOOST_CHECK(ReadFile(cacheFile) == expected);
+
+    /* A rejected body does not replace the cache */
+    const auto rejected {downloader.Stream(fileURL, [](std::istream& body) {
+        return body.get() == '#';
+    }, {}, cacheFile)};
+    BOOST_CHECK(!rejected.ok);
+    BOOST_CHECK(!rejected.error.empty());
+    BOOST_CHECK(ReadFile(cacheFile) == expected);
+
+    /* Error pages are not passed to the consumer */
+    const auto missing {downloader.Stream(baseURL + "/missing.json", load)};
+    BOOST_CHECK(!missing.ok);
+    BOOST_CHECK_EQUAL(missing.httpStatus, 404);
+    BOOST_CHECK_EQUAL(nCalls, 1);
+
+    /* Plain downloads still reuse the connection */
+    const auto destination {
+        std::filesystem::temp_directory_path() / "network-layout-stream-download.json"
+    };
+    const auto download {downloader.Download(fileURL, destination)};
+    BOOST_CHECK(download.ok);
+    BOOST_CHECK_EQUAL(download.newConnections, 0);
+    BOOST_CHECK(ReadFile(destination) == expected);
+    BOOST_TEST_MESSAGE("Streamed download and parse: " << full.elapsed.count()
+                       << " us, plain download: " << download.elapsed.count() << " us");
+
+    std::filesystem::remove(cacheFile);
+    std::filesystem::remove(destination);
+}
+
+BOOST_AUTO_TEST_CASE(test_multi_downloader)
+{
+    TestServer server {GetLayoutServerOptions()};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+    const std::string fileURL {
+        "https://localhost:" + std::to_string(port) + "/network-layout.json"
+    };
+    const auto expected {ReadFile(TESTS_NETWORK_LAYOUT_JSON)};
+
+    const size_t nDownloads {8};
+    std::vector<std::filesystem::path> destinations {};
+    for (size_t idx {0}; idx < nDownloads; ++idx)
+    {
+        destinations.push_back(std::filesystem::temp_directory_path()
+            / ("network-layout-multi-" + std::to_string(idx) + ".json"));
+    }
+
+    boost::asio::io_context ioc {};
+    MultiFileDownloader downloader {ioc, TESTS_SERVER_CERT_PEM};
+
+    /* All downloads run at once on this thread */
+    std::vector<DownloadResult> results(nDownloads);
+    for (size_t idx {0}; idx < nDownloads; ++idx)
+    {
+        downloader.Download(fileURL, destinations[idx], {}, [&results, idx](const auto& result) {
+            results[idx] = result;
+        });
+    }
+    ioc.run();
+
+    long nConnections {0};
+    for (size_t idx {0}; idx < nDownloads; ++idx)
+    {
+        BOOST_CHECK(results[idx].ok);
+        BOOST_CHECK_EQUAL(results[idx].bytesReceived, expected.size());
+        BOOST_CHECK(ReadFile(destinations[idx]) == expected);
+        nConnections += results[idx].newConnections;
+    }
+    const auto firstBatch {server.GetStats()};
+    BOOST_CHECK_EQUAL(firstBatch.connections, nConnections);
+    BOOST_CHECK_EQUAL(firstBatch.layoutBytesSent, nDownloads * expected.size());
+
+    /* Revalidate everything: 304s on the connections of the first batch */
+    for (size_t idx {0}; idx < nDownloads; ++idx)
+    {
+        DownloadOptions options {};
+        options.etag = results[idx].etag;
+        downloader.Download(fileURL, destinations[idx], options, [&results, idx](const auto& result) {
+            results[idx] = result;
+        });
+    }
+    ioc.restart();
+    ioc.run();
+
+    for (size_t idx {0}; idx < nDownloads; ++idx)
+    {
+        BOOST_CHECK(results[idx].notModified);
+        BOOST_CHECK_EQUAL(results[idx].newConnections, 0);
+        std::filesystem::remove(destinations[idx]);
+    }
+    const auto secondBatch {server.GetStats()};
+    BOOST_CHECK_EQUAL(secondBatch.connections, firstBatch.connections);
+    BOOST_CHECK_EQUAL(secondBatch.layoutBytesSent, firstBatch.layoutBytesSent);
+    BOOST_CHECK_EQUAL(secondBatch.httpRequests, 2 * nDownloads);
+}
+
 BOOST_AUTO_TEST_CASE(test_json_parse)
 {
     /* Parse the file */
@@ -64,4 +430,51 @@ BOOST_AUTO_TEST_CASE(test_json_parse)
     BOOST_CHECK(parsed.at("travel_times").size() > 0);
 }
 
+BOOST_AUTO_TEST_CASE(test_load_json_file)
+{
+    /* Same document as through an iostream */
+    nlohmann::json expected {};
+    {
+        std::ifstream file {TESTS_NETWORK_LAYOUT_JSON};
+        file >> expected;
+    }
+    const auto result {LoadJsonFile(TESTS_NETWORK_LAYOUT_JSON)};
+    BOOST_CHECK(result.ok);
+    BOOST_CHECK(result.error.empty());
+    BOOST_CHECK(result.json == expected);
+    BOOST_CHECK(ParseJsonFile(TESTS_NETWORK_LAYOUT_JSON) == expected);
+
+    /* Errors point at the offending byte */
+    const std::string badJson {R"({"stations": [1, 2,, 3]})"};
+    const auto bad {ParseJson(badJson)};
+    BOOST_CHECK(!bad.ok);
+    BOOST_CHECK(!bad.error.empty());
+    BOOST_CHECK_EQUAL(bad.errorOffset, badJson.find(",,") + 1);
+
+    const std::string truncated {R"({"stations": [1, 2)"};
+    BOOST_CHECK_EQUAL(ParseJson(truncated).errorOffset, truncated.size());
+
+    /* Also from a file */
+    const auto badFile {
+        std::filesystem::temp_directory_path() / "network-monitor-bad.json"
+    };
+    std::ofstream {badFile, std::ios::binary | std::ios::trunc} << badJson;
+    const auto badFromFile {LoadJsonFile(badFile)};
+    BOOST_CHECK(!badFromFile.ok);
+    BOOST_CHECK_EQUAL(badFromFile.errorOffset, bad.errorOffset);
+    BOOST_CHECK(ParseJsonFile(badFile).is_null());
+
+    /* An empty file is not a JSON document */
+    std::ofstream {badFile, std::ios::binary | std::ios::trunc};
+    const auto empty {LoadJsonFile(badFile)};
+    BOOST_CHECK(!empty.ok);
+    BOOST_CHECK_EQUAL(empty.errorOffset, 0);
+    std::filesystem::remove(badFile);
+
+    const auto missing {LoadJsonFile("does-not-exist.json")};
+    BOOST_CHECK(!missing.ok);
+    BOOST_CHECK(!missing.error.empty());
+    BOOST_CHECK(ParseJsonFile("does-not-exist.json").is_null());
+}
+
 BOOST_AUTO_TEST_SUITE_END();
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include "IdTable.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+using NetworkMonitor::Handle;
+using NetworkMonitor::IdTable;
+using NetworkMonitor::kInvalidHandle;
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+BOOST_AUTO_TEST_SUITE(class_IdTable);
+
+BOOST_AUTO_TEST_CASE(intern)
+{
+    IdTable table {};
+
+    /* Handles are dense and stable */
+    Handle handle0 {table.Intern("station_000")};
+    Handle handle1 {table.Intern("station_001")};
+    BOOST_CHECK_EQUAL(handle0, 0);
+    BOOST_CHECK_EQUAL(handle1, 1);
+    BOOST_CHECK_EQUAL(table.Intern("station_000"), handle0);
+    BOOST_CHECK_EQUAL(table.Size(), 2);
+
+    BOOST_CHECK_EQUAL(table.Find("station_001"), handle1);
+    BOOST_CHECK_EQUAL(table.Find("station_002"), kInvalidHandle);
+    BOOST_CHECK_EQUAL(table.GetId(handle1), "station_001");
+}
+
+BOOST_AUTO_TEST_CASE(truncate)
+{
+    IdTable table {};
+    table.Intern("station_000");
+    table.Intern("station_001");
+    table.Intern("station_002");
+
+    table.Truncate(1);
+    BOOST_CHECK_EQUAL(table.Size(), 1);
+    BOOST_CHECK_EQUAL(table.Find("station_001"), kInvalidHandle);
+    BOOST_CHECK_EQUAL(table.Intern("station_002"), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* class_IdTable */
+BOOST_AUTO_TEST_SUITE_END();    /* network_monitor */
@@ -0,0 +1,82 @@
+#include "NetworkGenerator.h"
+#include "TransportNetwork.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using NetworkMonitor::GenerateNetworkLayout;
+using NetworkMonitor::NetworkGeneratorOptions;
+using NetworkMonitor::TransportNetwork;
+using NetworkMonitor::WriteNetworkLayout;
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+BOOST_AUTO_TEST_SUITE(NetworkGenerator);
+
+BOOST_AUTO_TEST_CASE(load)
+{
+    NetworkGeneratorOptions options {};
+    options.nStations = 5000;
+    const auto layout {GenerateNetworkLayout(options)};
+    BOOST_CHECK_EQUAL(layout.stations.size(), options.nStations);
+    BOOST_CHECK_EQUAL(layout.stations.front().id, "station_0000");
+
+    std::stringstream json {};
+    BOOST_REQUIRE(WriteNetworkLayout(layout, json));
+    TransportNetwork nw {};
+    BOOST_REQUIRE(nw.FromJson(json));
+    BOOST_CHECK_EQUAL(nw.GetStationCount(), options.nStations);
+
+    /* Every station is served, and about a quarter of the stops are
+       interchanges */
+    size_t nStops {0};
+    for (const auto& line: layout.lines)
+    {
+        BOOST_REQUIRE_EQUAL(line.routes.size(), 2);
+        nStops += line.routes.front().stops.size();
+    }
+    size_t nServing {0};
+    for (const auto& station: layout.stations)
+    {
+        const auto nRoutes {nw.GetRoutesServingStation(station.id).size()};
+        BOOST_CHECK(nRoutes >= 2);
+        nServing += nRoutes;
+    }
+    BOOST_CHECK_EQUAL(nServing, 2 * nStops);
+    const auto interchangeRatio {1.0 - static_cast<double>(options.nStations) / nStops};
+    BOOST_CHECK(interchangeRatio > 0.2 && interchangeRatio < 0.3);
+
+    /* Travel times add up along the routes */
+    const auto& line {layout.lines.front()};
+    const auto& route {line.routes.front()};
+    unsigned int travelTime {0};
+    for (size_t stop {0}; stop + 1 < route.stops.size(); ++stop)
+    {
+        travelTime += nw.GetTravelTime(route.stops[stop], route.stops[stop + 1]);
+    }
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime(line.id, route.id, route.stops.front(), route.stops.back()),
+        travelTime
+    );
+}
+
+BOOST_AUTO_TEST_CASE(deterministic)
+{
+    NetworkGeneratorOptions options {};
+    options.nStations = 1000;
+    std::stringstream first {};
+    std::stringstream second {};
+    BOOST_REQUIRE(WriteNetworkLayout(GenerateNetworkLayout(options), first));
+    BOOST_REQUIRE(WriteNetworkLayout(GenerateNetworkLayout(options), second));
+    BOOST_CHECK(first.str() == second.str());
+
+    options.seed += 1;
+    std::stringstream reseeded {};
+    BOOST_REQUIRE(WriteNetworkLayout(GenerateNetworkLayout(options), reseeded));
+    BOOST_CHECK(first.str() != reseeded.str());
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* NetworkGenerator */
+BOOST_AUTO_TEST_SUITE_END();    /* network_monitor */
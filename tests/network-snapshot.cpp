@@ -0,0 +1,261 @@
+#include "FileDownloader.h"
+#include "NetworkSnapshot.h"
+#include "TransportNetwork.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using NetworkMonitor::kInvalidHandle;
+using NetworkMonitor::NetworkSnapshot;
+using NetworkMonitor::ParseJsonFile;
+using NetworkMonitor::StationHandle;
+using NetworkMonitor::TransportNetwork;
+
+/* Write/patch the snapshot used by the tests in the temporary directory */
+static std::filesystem::path GetSnapshotPath()
+{
+    return std::filesystem::temp_directory_path() / "network-monitor-tests.snapshot";
+}
+
+static void PatchFile (
+    const std::filesystem::path& file,
+    std::streamoff offset,
+    const std::string& bytes
+)
+{
+    std::fstream stream {file, std::ios::binary | std::ios::in | std::ios::out};
+    stream.seekp(offset);
+    stream.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+BOOST_AUTO_TEST_SUITE(class_NetworkSnapshot);
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    const std::filesystem::path layout {TESTS_NETWORK_LAYOUT_JSON};
+    const auto snapshotPath {GetSnapshotPath()};
+
+    TransportNetwork nw {};
+    BOOST_REQUIRE(nw.FromJson(layout));
+    BOOST_REQUIRE(NetworkSnapshot::ConvertLayout(layout, snapshotPath));
+
+    NetworkSnapshot snapshot {};
+    BOOST_REQUIRE(snapshot.Open(snapshotPath));
+    BOOST_REQUIRE_EQUAL(snapshot.GetStationCount(), nw.GetStationCount());
+
+    const auto src = ParseJsonFile(layout);
+
+    /* Stations */
+    for (const auto& stationJson: src.at("stations"))
+    {
+        const auto id {stationJson.at("station_id").get<std::string>()};
+        const auto station {snapshot.GetStationHandle(id)};
+        BOOST_REQUIRE_EQUAL(station, nw.GetStationHandle(id));
+        BOOST_CHECK_EQUAL(snapshot.GetStationId(station), id);
+        BOOST_CHECK_EQUAL(
+            snapshot.GetStationName(station),
+            stationJson.at("name").get<std::string>()
+        );
+
+        auto routes {snapshot.GetRoutesServingStation(station)};
+        auto expected {nw.GetRoutesServingStation(station)};
+        std::sort(routes.begin(), routes.end());
+        std::sort(expected.begin(), expected.end());
+        BOOST_CHECK(routes == expected);
+    }
+
+    /* Routes and travel times */
+    for (const auto& lineJson: src.at("lines"))
+    {
+        const auto lineId {lineJson.at("line_id").get<std::string>()};
+        BOOST_CHECK_EQUAL(snapshot.GetLineHandle(lineId), nw.GetLineHandle(lineId));
+        for (const auto& routeJson: lineJson.at("routes"))
+        {
+            const auto routeId {routeJson.at("route_id").get<std::string>()};
+            const auto route {snapshot.GetRouteHandle(lineId, routeId)};
+            BOOST_REQUIRE_EQUAL(route, nw.GetRouteHandle(lineId, routeId));
+            BOOST_CHECK_EQUAL(snapshot.GetRouteId(route), routeId);
+
+            const auto& stops {routeJson.at("route_stops")};
+            const auto first {snapshot.GetStationHandle(stops.front().get<std::string>())};
+            for (size_t idx {1}; idx < stops.size(); ++idx)
+            {
+                const auto previous {
+                    snapshot.GetStationHandle(stops[idx - 1].get<std::string>())
+                };
+                const auto current {snapshot.GetStationHandle(stops[idx].get<std::string>())};
+                BOOST_CHECK_EQUAL(
+                    snapshot.GetTravelTime(previous, current),
+                    nw.GetTravelTime(previous, current)
+                );
+                BOOST_CHECK_EQUAL(
+                    snapshot.GetTravelTime(route, first, current),
+                    nw.GetTravelTime(route, first, current)
+                );
+                BOOST_CHECK_EQUAL(
+                    snapshot.GetTravelTime(route, current, first),
+                    nw.GetTravelTime(route, current, first)
+                );
+            }
+        }
+    }
+
+    /* Unknown IDs */
+    BOOST_CHECK_EQUAL(snapshot.GetStationHandle("station_999"), kInvalidHandle);
+    BOOST_CHECK_EQUAL(snapshot.GetLineHandle("line_999"), kInvalidHandle);
+    BOOST_CHECK_EQUAL(snapshot.GetRouteHandle("line_000", "route_999"), kInvalidHandle);
+    BOOST_CHECK_EQUAL(snapshot.GetRouteHandle("line_999", "route_000"), kInvalidHandle);
+
+    /* Move the mapping */
+    NetworkSnapshot moved {std::move(snapshot)};
+    BOOST_CHECK_EQUAL(moved.GetStationCount(), nw.GetStationCount());
+    BOOST_CHECK_EQUAL(snapshot.GetStationCount(), 0);
+
+    std::filesystem::remove(snapshotPath);
+}
+
+BOOST_AUTO_TEST_CASE(loop_route)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+    for (const auto& id: {"station_000", "station_001", "station_002", "station_003"})
+    {
+        ok &= nw.AddStation({id, "Station Name"});
+    }
+    BOOST_REQUIRE(ok);
+
+    /* line0 route0: 0 ---> 1 ---> 2 ---> 0
+       line1 route1: 3 ---> 0 ---> 1 */
+    ok &= nw.AddLine({"line_000", "Line Name 0", {{
+        "route_000",
+        "inbound",
+        "line_000",
+        "station_000",
+        "station_000",
+        {"station_000", "station_001", "station_002", "station_000"}
+    }}});
+    ok &= nw.AddLine({"line_001", "Line Name 1", {{
+        "route_001",
+        "inbound",
+        "line_001",
+        "station_003",
+        "station_001",
+        {"station_003", "station_000", "station_001"}
+    }}});
+    ok &= nw.SetTravelTime("station_000", "station_001", 1);
+    ok &= nw.SetTravelTime("station_001", "station_002", 2);
+    ok &= nw.SetTravelTime("station_002", "station_000", 3);
+    ok &= nw.SetTravelTime("station_003", "station_000", 4);
+    BOOST_REQUIRE(ok);
+
+    const auto snapshotPath {GetSnapshotPath()};
+    BOOST_REQUIRE(NetworkSnapshot::Write(nw, snapshotPath));
+    NetworkSnapshot snapshot {};
+    BOOST_REQUIRE(snapshot.Open(snapshotPath));
+
+    /* Same answers as the network, with each route listed once */
+    const auto nStations {static_cast<StationHandle>(nw.GetStationCount())};
+    const auto route0 {nw.GetRouteHandle("line_000", "route_000")};
+    const auto station0 {nw.GetStationHandle("station_000")};
+    BOOST_CHECK_EQUAL(snapshot.GetRoutesServingStation(station0).size(), 2);
+    for (StationHandle stationA {0}; stationA < nStations; ++stationA)
+    {
+        const auto routes {snapshot.GetRoutesServingStation(stationA)};
+        const auto expected {nw.GetRoutesServingStation(stationA)};
+        BOOST_CHECK(routes == expected);
+        for (StationHandle stationB {0}; stationB < nStations; ++stationB)
+        {
+            BOOST_CHECK_EQUAL(
+                snapshot.GetTravelTime(route0, stationA, stationB),
+                nw.GetTravelTime(route0, stationA, stationB)
+            );
+        }
+    }
+
+    std::filesystem::remove(snapshotPath);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_snapshot)
+{
+    const std::filesystem::path layout {TESTS_NETWORK_LAYOUT_JSON};
+    const auto snapshotPath {GetSnapshotPath()};
+    NetworkSnapshot snapshot {};
+
+    BOOST_CHECK(!snapshot.Open("does-not-exist.snapshot"));
+
+    /* Not a regular file */
+    BOOST_CHECK(!snapshot.Open(std::filesystem::temp_directory_path()));
+
+    /* Not a snapshot */
+    BOOST_CHECK(!snapshot.Open(layout));
+
+    /* Corrupted string: only detected by the checksum */
+    BOOST_REQUIRE(NetworkSnapshot::ConvertLayout(layout, snapshotPath));
+    const auto size {static_cast<std::streamoff>(std::filesystem::file_size(snapshotPath))};
+    std::string contents(static_cast<size_t>(size), '\0');
+    std::ifstream {snapshotPath, std::ios::binary}.read(contents.data(), size);
+    const auto stationId {contents.find("station_")};
+    BOOST_REQUIRE(stationId != std::string::npos);
+    PatchFile(snapshotPath, static_cast<std::streamoff>(stationId), "x");
+    BOOST_CHECK(!snapshot.Open(snapshotPath));
+    BOOST_CHECK(snapshot.Open(snapshotPath, false));
+
+    /* Handle out of bounds: rejected even without the checksum */
+    BOOST_REQUIRE(NetworkSnapshot::ConvertLayout(layout, snapshotPath));
+    PatchFile(snapshotPath, size - 1, "\x7f");
+    BOOST_CHECK(!snapshot.Open(snapshotPath, false));
+
+    /* Corrupted header: the station count no longer matches the offsets */
+    BOOST_REQUIRE(NetworkSnapshot::ConvertLayout(layout, snapshotPath));
+    const std::uint32_t nStations {425};
+    PatchFile(snapshotPath, 36, std::string(reinterpret_cast<const char*>(&nStations), 4));
+    BOOST_CHECK(!snapshot.Open(snapshotPath));
+    BOOST_CHECK(!snapshot.Open(snapshotPath, false));
+
+    /* Different version */
+    BOOST_REQUIRE(NetworkSnapshot::ConvertLayout(layout, snapshotPath));
+    const std::uint32_t version {NetworkSnapshot::kVersion + 1};
+    PatchFile(snapshotPath, 8, std::string(reinterpret_cast<const char*>(&version), 4));
+    BOOST_CHECK(!snapshot.Open(snapshotPath, false));
+
+    /* Truncated */
+    BOOST_REQUIRE(NetworkSnapshot::ConvertLayout(layout, snapshotPath));
+    std::filesystem::resize_file(snapshotPath, size / 2);
+    BOOST_CHECK(!snapshot.Open(snapshotPath, false));
+
+    /* A failed open leaves the snapshot untouched */
+    BOOST_CHECK_EQUAL(snapshot.GetStationCount(), 426);
+
+    std::filesystem::remove(snapshotPath);
+}
+
+BOOST_AUTO_TEST_CASE(replace_open_snapshot)
+{
+    const auto snapshotPath {GetSnapshotPath()};
+    BOOST_REQUIRE(NetworkSnapshot::ConvertLayout(TESTS_NETWORK_LAYOUT_JSON, snapshotPath));
+    NetworkSnapshot snapshot {};
+    BOOST_REQUIRE(snapshot.Open(snapshotPath));
+    const auto stationId {std::string {snapshot.GetStationId(425)}};
+
+    /* Replacing the file does not touch the mapping of the open snapshot */
+    BOOST_REQUIRE(NetworkSnapshot::Write(TransportNetwork {}, snapshotPath));
+    BOOST_CHECK_EQUAL(snapshot.GetStationCount(), 426);
+    BOOST_CHECK_EQUAL(snapshot.GetStationId(425), stationId);
+    BOOST_CHECK(!std::filesystem::exists(snapshotPath.string() + ".tmp"));
+
+    NetworkSnapshot replaced {};
+    BOOST_REQUIRE(replaced.Open(snapshotPath));
+    BOOST_CHECK_EQUAL(replaced.GetStationCount(), 0);
+
+    std::filesystem::remove(snapshotPath);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* class_NetworkSnapshot */
+BOOST_AUTO_TEST_SUITE_END();    /* network_monitor */
@@ -0,0 +1,131 @@
+#include "PassengerEventFeed.h"
+#include "PassengerEventPipeline.h"
+#include "StompClient.h"
+#include "StompFrame.h"
+#include "TestServer.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+
+using NetworkMonitor::MakePassengerEventHandler;
+using NetworkMonitor::PassengerEvent;
+using NetworkMonitor::PassengerEventPipeline;
+using NetworkMonitor::StompClient;
+using NetworkMonitor::StompClientError;
+using NetworkMonitor::StompError;
+using NetworkMonitor::StompFrame;
+using NetworkMonitor::SubscribePassengerEvents;
+using NetworkMonitor::TestServer;
+using NetworkMonitor::TestServerOptions;
+
+using namespace std::string_literals;
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+BOOST_AUTO_TEST_SUITE(PassengerEventFeed);
+
+BOOST_AUTO_TEST_CASE(handler)
+{
+    std::atomic<size_t> nRecorded {0};
+    PassengerEventPipeline pipeline {[&nRecorded](const PassengerEvent*, size_t nEvents) -> size_t {
+        nRecorded += nEvents;
+        return 0;
+    }};
+    auto onMessage {MakePassengerEventHandler(pipeline)};
+
+    const std::string message {
+        "MESSAGE\n"
+        "subscription:0\n"
+        "message-id:1\n"
+        "destination:/passengers\n"
+        "\n"
+        R"({"datetime":"2020-11-01T07:18:50.234000Z","passenger_event":"in","station_id":"station_000"})"
+        "\0"s
+    };
+    StompFrame frame {};
+    BOOST_REQUIRE_EQUAL(frame.Parse(message), StompError::Ok);
+
+    /* Bodies are queued, gaps are recorded and other errors are skipped */
+    onMessage({}, frame);
+    onMessage(StompClientError::MessageGap, StompFrame {});
+    onMessage(boost::asio::error::operation_aborted, StompFrame {});
+    pipeline.Start();
+    pipeline.Stop();
+
+    const auto stats {pipeline.GetStats()};
+    BOOST_CHECK_EQUAL(stats.received, 1);
+    BOOST_CHECK_EQUAL(stats.gaps, 1);
+    BOOST_CHECK_EQUAL(stats.applied, 1);
+    BOOST_CHECK_EQUAL(nRecorded, 1);
+}
+
+BOOST_AUTO_TEST_CASE(subscribe_local)
+{
+    TestServerOptions options {};
+    options.certFile = TESTS_SERVER_CERT_PEM;
+    options.keyFile = TESTS_SERVER_KEY_PEM;
+    options.events = TestServer::LoadEvents(TESTS_PASSENGER_EVENTS);
+    BOOST_REQUIRE(!options.events.empty());
+    TestServer server {options};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+    StompClient client {"localhost", "/network-events", std::to_string(port), ioc, ctx};
+    std::atomic<size_t> nRecorded {0};
+    PassengerEventPipeline pipeline {[&nRecorded](const PassengerEvent*, size_t nEvents) -> size_t {
+        nRecorded += nEvents;
+        return 0;
+    }};
+    pipeline.Start();
+
+    bool subscribed {false};
+    auto onConnect {[&](auto ec) {
+        if (ec)
+            return;
+
+        SubscribePassengerEvents(client, pipeline, "/passengers", [&subscribed](auto ec, auto&&) {
+            subscribed = !ec;
+        });
+    }};
+    client.Connect(options.username, options.password, onConnect);
+
+    /* The messages go straight to the pipeline: close the client once it
+       queued all of them */
+    boost::asio::steady_timer timer {ioc};
+    std::function<void (boost::system::error_code)> poll {};
+    poll = [&](auto ec) {
+        if (ec)
+            return;
+
+        if (pipeline.GetStats().received == options.events.size())
+        {
+            client.Close();
+            return;
+        }
+        timer.expires_after(std::chrono::milliseconds(5));
+        timer.async_wait(poll);
+    };
+    timer.expires_after(std::chrono::milliseconds(5));
+    timer.async_wait(poll);
+    ioc.run_for(std::chrono::seconds(10));
+    pipeline.Stop();
+
+    BOOST_CHECK(subscribed);
+    const auto stats {pipeline.GetStats()};
+    BOOST_CHECK_EQUAL(stats.received, options.events.size());
+    BOOST_CHECK_EQUAL(stats.applied, options.events.size());
+    BOOST_CHECK_EQUAL(stats.gaps, 0);
+    BOOST_CHECK_EQUAL(nRecorded, options.events.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* PassengerEventFeed */
+BOOST_AUTO_TEST_SUITE_END();    /* network_monitor */
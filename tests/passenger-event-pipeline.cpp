@@ -0,0 +1,229 @@
+#include "PassengerEventPipeline.h"
+#include "TransportNetwork.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using NetworkMonitor::FullRingPolicy;
+using NetworkMonitor::Id;
+using NetworkMonitor::IngestionOptions;
+using NetworkMonitor::ParsePassengerEvent;
+using NetworkMonitor::PassengerEvent;
+using NetworkMonitor::PassengerEventGenerator;
+using NetworkMonitor::PassengerEventPipeline;
+using NetworkMonitor::TransportNetwork;
+
+/* Network with stations only, which is all passenger counts need */
+static TransportNetwork MakeStationNetwork (
+    const std::vector<Id>& stations
+)
+{
+    TransportNetwork nw {};
+    for (const auto& id: stations)
+    {
+        nw.AddStation({id, "Station Name"});
+    }
+    return nw;
+}
+
+static std::string MakeEvent (
+    const std::string& station,
+    const std::string& type
+)
+{
+    return R"({"datetime":"2020-11-01T07:18:50.234000Z","passenger_event":")" + type
+        + R"(","station_id":")" + station + R"("})";
+}
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+BOOST_AUTO_TEST_SUITE(class_PassengerEventPipeline);
+
+BOOST_AUTO_TEST_CASE(parse_event)
+{
+    PassengerEvent event {};
+    BOOST_REQUIRE(ParsePassengerEvent(MakeEvent("station_000", "out"), event));
+    BOOST_CHECK_EQUAL(event.stationId, "station_000");
+    BOOST_CHECK(event.type == PassengerEvent::Type::Out);
+
+    BOOST_CHECK(!ParsePassengerEvent("{", event));
+    BOOST_CHECK(!ParsePassengerEvent("[]", event));
+    BOOST_CHECK(!ParsePassengerEvent(R"({"passenger_event":"in"})", event));
+    BOOST_CHECK(!ParsePassengerEvent(MakeEvent("station_000", "sideways"), event));
+}
+
+BOOST_AUTO_TEST_CASE(generated_events)
+{
+    const std::vector<Id> stations {
+        "station_000", "station_001", "station_002", "station_003", "station_004"
+    };
+    auto nw {MakeStationNetwork(stations)};
+
+    IngestionOptions options {};
+    options.ringCapacity = 256;
+    options.nWorkers = 3;
+    options.batchSize = 32;
+    PassengerEventPipeline pipeline {nw, options};
+    pipeline.Start();
+
+    /* Two producers, each with its own generator */
+    constexpr int nProducers {2};
+    constexpr int nEvents {20000};
+    std::vector<std::map<Id, long long int>> expected(nProducers);
+    std::vector<std::thread> producers {};
+    for (int producer {0}; producer < nProducers; ++producer)
+    {
+        producers.emplace_back([&pipeline, &stations, &expected, producer]() {
+            PassengerEventGenerator generator {stations, static_cast<unsigned int>(producer)};
+            PassengerEvent event {};
+            for (int idx {0}; idx < nEvents; ++idx)
+            {
+                pipeline.Push(generator.Next(event));
+                expected[producer][event.stationId] +=
+                    event.type == PassengerEvent::Type::In ? 1 : -1;
+            }
+        });
+    }
+    for (auto& producer: producers)
+    {
+        producer.join();
+    }
+    pipeline.Stop();
+
+    for (const auto& station: stations)
+    {
+        BOOST_CHECK_EQUAL(
+            nw.GetPassengerCount(station),
+            expected[0][station] + expected[1][station]
+        );
+    }
+
+    const auto stats {pipeline.GetStats()};
+    BOOST_CHECK_EQUAL(stats.received, nProducers * nEvents);
+    BOOST_CHECK_EQUAL(stats.applied, nProducers * nEvents);
+    BOOST_CHECK_EQUAL(stats.dropped, 0);
+    BOOST_CHECK_EQUAL(stats.parseErrors, 0);
+    BOOST_CHECK_EQUAL(stats.queueDepth, 0);
+    BOOST_CHECK(stats.maxQueueDepth > 0);
+    BOOST_CHECK(stats.maxQueueDepth <= 256);
+    BOOST_CHECK_EQUAL(stats.queueLatency.count, nProducers * nEvents);
+    BOOST_CHECK(stats.parseLatency.count > 0);
+    BOOST_CHECK_EQUAL(stats.applyLatency.count, stats.parseLatency.count);
+}
+
+BOOST_AUTO_TEST_CASE(count_and_drop)
+{
+    auto nw {MakeStationNetwork({"station_000"})};
+    IngestionOptions options {};
+    options.ringCapacity = 4;
+    options.fullRingPolicy = FullRingPolicy::CountAndDrop;
+    PassengerEventPipeline pipeline {nw, options};
+
+    /* Workers are not started: the ring fills up */
+    for (int idx {0}; idx < 4; ++idx)
+    {
+        BOOST_CHECK(pipeline.Push(MakeEvent("station_000", "in")));
+    }
+    BOOST_CHECK(!pipeline.Push(MakeEvent("station_000", "in")));
+    BOOST_CHECK(!pipeline.Push(MakeEvent("station_000", "in")));
+    BOOST_CHECK_EQUAL(pipeline.GetStats().queueDepth, 4);
+
+    pipeline.Stop();
+    const auto stats {pipeline.GetStats()};
+    BOOST_CHECK_EQUAL(stats.received, 6);
+    BOOST_CHECK_EQUAL(stats.dropped, 2);
+    BOOST_CHECK_EQUAL(stats.applied, 4);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_000"), 4);
+}
+
+BOOST_AUTO_TEST_CASE(drop_oldest)
+{
+    auto nw {MakeStationNetwork({"station_000", "station_001"})};
+    IngestionOptions options {};
+    options.ringCapacity = 4;
+    options.fullRingPolicy = FullRingPolicy::DropOldest;
+    PassengerEventPipeline pipeline {nw, options};
+
+    /* The two oldest events are dropped */
+    BOOST_CHECK(pipeline.Push(MakeEvent("station_000", "in")));
+    BOOST_CHECK(pipeline.Push(MakeEvent("station_000", "in")));
+    for (int idx {0}; idx < 4; ++idx)
+    {
+        BOOST_CHECK(pipeline.Push(MakeEvent("station_001", "in")));
+    }
+
+    pipeline.Stop();
+    const auto stats {pipeline.GetStats()};
+    BOOST_CHECK_EQUAL(stats.dropped, 2);
+    BOOST_CHECK_EQUAL(stats.applied, 4);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_000"), 0);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_001"), 4);
+}
+
+BOOST_AUTO_TEST_CASE(bad_events)
+{
+    auto nw {MakeStationNetwork({"station_000"})};
+    PassengerEventPipeline pipeline {nw};
+    pipeline.Start();
+    pipeline.Push(MakeEvent("station_000", "in"));
+    pipeline.Push("not json");
+    pipeline.Push(MakeEvent("station_999", "in"));
+    pipeline.Stop();
+
+    /* Events pushed after Stop are dropped */
+    BOOST_CHECK(!pipeline.Push(MakeEvent("station_000", "in")));
+
+    const auto stats {pipeline.GetStats()};
+    BOOST_CHECK_EQUAL(stats.received, 4);
+    BOOST_CHECK_EQUAL(stats.applied, 1);
+    BOOST_CHECK_EQUAL(stats.parseErrors, 1);
+    BOOST_CHECK_EQUAL(stats.rejected, 1);
+    BOOST_CHECK_EQUAL(stats.dropped, 1);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_000"), 1);
+}
+
+BOOST_AUTO_TEST_CASE(stop_while_pushing)
+{
+    auto nw {MakeStationNetwork({"station_000"})};
+    PassengerEventPipeline pipeline {nw};
+    pipeline.Start();
+
+    /* Every event is either recorded or counted as dropped, including the
+       ones pushed while Stop runs */
+    const unsigned int nProducers {4};
+    std::atomic<bool> stopped {false};
+    std::atomic<std::uint64_t> accepted {0};
+    std::vector<std::thread> producers {};
+    for (unsigned int producer {0}; producer < nProducers; ++producer)
+    {
+        producers.emplace_back([&pipeline, &stopped, &accepted]() {
+            const auto event {MakeEvent("station_000", "in")};
+            while (!stopped)
+            {
+                accepted += pipeline.Push(event);
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds {20});
+    pipeline.Stop();
+    stopped = true;
+    for (auto& producer: producers)
+    {
+        producer.join();
+    }
+
+    const auto stats {pipeline.GetStats()};
+    BOOST_CHECK(accepted > 0);
+    BOOST_CHECK_EQUAL(stats.applied, accepted);
+    BOOST_CHECK_EQUAL(stats.received, stats.applied + stats.dropped);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_000"), accepted);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* class_PassengerEventPipeline */
+BOOST_AUTO_TEST_SUITE_END();    /* network_monitor */
@@ -0,0 +1,250 @@
+#include "PassengerEventPipeline.h"
+#include "StompClient.h"
+#include "StompFrame.h"
+#include "TestServer.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using NetworkMonitor::PassengerEvent;
+using NetworkMonitor::PassengerEventPipeline;
+using NetworkMonitor::ReconnectOptions;
+using NetworkMonitor::StompAckMode;
+using NetworkMonitor::StompClient;
+using NetworkMonitor::StompClientError;
+using NetworkMonitor::StompFrame;
+using NetworkMonitor::TestServer;
+using NetworkMonitor::TestServerOptions;
+
+static TestServerOptions GetServerOptions()
+{
+    TestServerOptions options {};
+    options.certFile = TESTS_SERVER_CERT_PEM;
+    options.keyFile = TESTS_SERVER_KEY_PEM;
+    options.events = TestServer::LoadEvents(TESTS_PASSENGER_EVENTS);
+    return options;
+}
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+BOOST_AUTO_TEST_SUITE(class_StompClient);
+
+BOOST_AUTO_TEST_CASE(connect_invalid_auth_local)
+{
+    TestServer server {GetServerOptions()};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+    StompClient client {"localhost", "/network-events", std::to_string(port), ioc, ctx};
+
+    /* The server replies to bad credentials with an ERROR frame */
+    boost::system::error_code connectError {};
+    bool disconnected {false};
+    auto onConnect {[&client, &connectError, &disconnected](auto ec) {
+        connectError = ec;
+        client.Close([&disconnected](auto ec) {
+            disconnected = !ec;
+        });
+    }};
+
+    client.Connect("fake_username", "fake_password", onConnect);
+    ioc.run();
+
+    BOOST_CHECK(connectError == StompClientError::ConnectRejected);
+    BOOST_CHECK(disconnected);
+}
+
+BOOST_AUTO_TEST_CASE(subscribe_local)
+{
+    const auto options {GetServerOptions()};
+    BOOST_REQUIRE(!options.events.empty());
+    TestServer server {options};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+    StompClient client {"localhost", "/network-events", std::to_string(port), ioc, ctx};
+
+    /* The server replays the recorded events, in order, to the subscription */
+    bool connected {false};
+    bool subscribed {false};
+    bool disconnected {false};
+    std::string subscriptionId {};
+    std::vector<std::string> received {};
+    size_t nAcked {0};
+    auto onMessage {[&](auto ec, const StompFrame& frame) {
+        if (ec)
+            return;
+
+        BOOST_CHECK_EQUAL(frame.GetHeaderValue("subscription"), subscriptionId);
+        received.emplace_back(frame.GetBody());
+        client.Ack(frame.GetHeaderValue("ack"), [&nAcked](auto ec) {
+            nAcked += !ec;
+        });
+        if (received.size() == options.events.size())
+        {
+            client.Close([&disconnected](auto ec) {
+                disconnected = !ec;
+            });
+        }
+    }};
+    auto onConnect {[&](auto ec) {
+        connected = !ec;
+        if (ec)
+            return;
+
+        subscriptionId = client.Subscribe(
+            "/passengers", StompAckMode::ClientIndividual,
+            [&subscribed](auto ec, auto&&) {
+                subscribed = !ec;
+            },
+            onMessage
+        );
+    }};
+
+    client.Connect(options.username, options.password, onConnect);
+    ioc.run();
+
+    BOOST_CHECK(connected);
+    BOOST_CHECK(subscribed);
+    BOOST_CHECK(disconnected);
+    BOOST_CHECK_EQUAL(nAcked, options.events.size());
+    BOOST_CHECK(received == options.events);
+}
+
+BOOST_AUTO_TEST_CASE(reconnect_resubscribe)
+{
+    const auto options {GetServerOptions()};
+    BOOST_REQUIRE(!options.events.empty());
+    TestServer server {options};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+    StompClient client {"localhost", "/network-events", std::to_string(port), ioc, ctx};
+    ReconnectOptions reconnectOptions {};
+    reconnectOptions.enabled = true;
+    reconnectOptions.initialDelay = std::chrono::milliseconds(10);
+    client.SetReconnectOptions(reconnectOptions);
+
+    /* Feed the events to the ingestion pipeline, which counts the gap */
+    PassengerEventPipeline pipeline {[](const PassengerEvent*, size_t) -> size_t {
+        return 0;
+    }};
+    pipeline.Start();
+
+    /* The server drops the connection after a few events. The client logs in
+       again and renews the subscription, and the server replays the events
+       from the start */
+    const size_t dropAfter {10};
+    size_t nSubscribed {0};
+    size_t nGaps {0};
+    size_t nReceived {0};
+    size_t nReceivedAfterGap {0};
+    auto onMessage {[&](auto ec, const StompFrame& frame) {
+        if (ec == StompClientError::MessageGap)
+        {
+            pipeline.RecordGap();
+            ++nGaps;
+            return;
+        }
+        if (ec)
+            return;
+
+        pipeline.Push(frame.GetBody());
+        ++nReceived;
+        if (nGaps == 0 && nReceived == dropAfter)
+        {
+            server.DropConnections();
+        }
+        if (nGaps > 0 && ++nReceivedAfterGap == options.events.size())
+        {
+            client.Close();
+        }
+    }};
+    auto onConnect {[&](auto ec) {
+        if (ec)
+            return;
+
+        client.Subscribe(
+            "/passengers", StompAckMode::Auto,
+            [&nSubscribed](auto ec, auto&&) {
+                nSubscribed += !ec;
+            },
+            onMessage
+        );
+    }};
+
+    client.Connect(options.username, options.password, onConnect);
+    ioc.run();
+    pipeline.Stop();
+
+    BOOST_CHECK_EQUAL(nSubscribed, 1);
+    BOOST_CHECK_EQUAL(nGaps, 1);
+    BOOST_CHECK_EQUAL(nReceivedAfterGap, options.events.size());
+    BOOST_CHECK_EQUAL(client.GetMetrics().reconnects, 1);
+
+    const auto stats {pipeline.GetStats()};
+    BOOST_CHECK_EQUAL(stats.gaps, 1);
+    BOOST_CHECK_EQUAL(stats.received, nReceived);
+    BOOST_CHECK_EQUAL(stats.applied, nReceived);
+}
+
+BOOST_AUTO_TEST_CASE(reconnect_gives_up)
+{
+    const auto options {GetServerOptions()};
+    TestServer server {options};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+
+    boost::asio::io_context ioc {};
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+    StompClient client {"localhost", "/network-events", std::to_string(port), ioc, ctx};
+    ReconnectOptions reconnectOptions {};
+    reconnectOptions.enabled = true;
+    reconnectOptions.initialDelay = std::chrono::milliseconds(10);
+    reconnectOptions.maxAttempts = 3;
+    client.SetReconnectOptions(reconnectOptions);
+
+    /* The server goes away after the first session: every reconnection
+       fails, and the client reports giving up through onDisconnect */
+    size_t nConnected {0};
+    std::vector<boost::system::error_code> disconnects {};
+    auto onConnect {[&](auto ec) {
+        ++nConnected;
+        BOOST_CHECK(!ec);
+        server.Stop();
+    }};
+    auto onDisconnect {[&](auto ec) {
+        disconnects.push_back(ec);
+    }};
+
+    client.Connect(options.username, options.password, onConnect, onDisconnect);
+    ioc.run();
+
+    BOOST_CHECK_EQUAL(nConnected, 1);
+    BOOST_REQUIRE_EQUAL(disconnects.size(), 2);
+    BOOST_CHECK(disconnects[0]);
+    BOOST_CHECK(disconnects[1]);
+    BOOST_CHECK_EQUAL(client.GetMetrics().failedAttempts, reconnectOptions.maxAttempts);
+    BOOST_CHECK_EQUAL(client.GetMetrics().reconnects, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* class_StompClient */
+BOOST_AUTO_TEST_SUITE_END();    /* network_monitor */
@@ -0,0 +1,276 @@
+#include "StompFrame.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using NetworkMonitor::SerializeStompFrame;
+using NetworkMonitor::StompCommand;
+using NetworkMonitor::StompError;
+using NetworkMonitor::StompFrame;
+
+using namespace std::string_literals;
+
+/* Canned frames, as sent by the network events feed */
+static const std::string kConnectedFrame {
+    "CONNECTED\n"
+    "version:1.2\n"
+    "session:42\n"
+    "\n"
+    "\0"s
+};
+
+static const std::string kMessageFrame {
+    "MESSAGE\n"
+    "subscription:0\n"
+    "message-id:007\n"
+    "ack:ack-007\n"
+    "destination:/passengers\n"
+    "content-type:application/json\n"
+    "\n"
+    "{\"datetime\":\"2020-11-01T07:18:50.234000Z\","
+    "\"passenger_event\":\"in\",\"station_id\":\"station_000\"}"
+    "\0"s
+};
+
+static const std::string kErrorFrame {
+    "ERROR\n"
+    "message:ValidationInvalidAuth\n"
+    "content-length:13\n"
+    "\n"
+    "Invalid\0login"
+    "\0"s
+};
+
+/* Check that all the views of a parsed frame point into the input */
+static bool ViewsInInput (
+    const StompFrame& frame,
+    std::string_view input
+)
+{
+    auto inInput {[input](std::string_view view) {
+        return view.empty()
+            || (view.data() >= input.data()
+                && view.data() + view.size() <= input.data() + input.size());
+    }};
+    bool ok {inInput(frame.GetBody())};
+    for (size_t idx {0}; idx < frame.GetHeaderCount(); ++idx)
+    {
+        ok &= inInput(frame.GetHeader(idx).name);
+        ok &= inInput(frame.GetHeader(idx).value);
+    }
+    return ok && frame.GetSize() <= input.size();
+}
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+BOOST_AUTO_TEST_SUITE(class_StompFrame);
+
+BOOST_AUTO_TEST_SUITE(Parse);
+
+BOOST_AUTO_TEST_CASE(connected)
+{
+    StompFrame frame {};
+    BOOST_REQUIRE_EQUAL(frame.Parse(kConnectedFrame), StompError::Ok);
+    BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::Connected);
+    BOOST_CHECK_EQUAL(frame.GetHeaderCount(), 2);
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue("version"), "1.2");
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue("session"), "42");
+    BOOST_CHECK(!frame.HasHeader("heart-beat"));
+    BOOST_CHECK(frame.GetBody().empty());
+    BOOST_CHECK_EQUAL(frame.GetSize(), kConnectedFrame.size());
+}
+
+BOOST_AUTO_TEST_CASE(message)
+{
+    StompFrame frame {};
+    BOOST_REQUIRE_EQUAL(frame.Parse(kMessageFrame), StompError::Ok);
+    BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::Message);
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue("ack"), "ack-007");
+    BOOST_CHECK_EQUAL(frame.GetHeader(0).name, "subscription");
+    BOOST_CHECK_EQUAL(frame.GetBody().front(), '{');
+    BOOST_CHECK_EQUAL(frame.GetBody().back(), '}');
+    BOOST_CHECK(ViewsInInput(frame, kMessageFrame));
+}
+
+BOOST_AUTO_TEST_CASE(content_length)
+{
+    /* The body contains a NULL octet */
+    StompFrame frame {};
+    BOOST_REQUIRE_EQUAL(frame.Parse(kErrorFrame), StompError::Ok);
+    BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::Error);
+    BOOST_CHECK_EQUAL(frame.GetBody(), "Invalid\0login"s);
+}
+
+BOOST_AUTO_TEST_CASE(crlf_and_repeated_headers)
+{
+    const auto input {
+        "\r\n\nRECEIPT\r\n"
+        "receipt-id:0\r\n"
+        "receipt-id:1\r\n"
+        "url:wss://host:443\r\n"
+        "\r\n"
+        "\0\r\n\n"s
+    };
+    StompFrame frame {};
+    BOOST_REQUIRE_EQUAL(frame.Parse(input), StompError::Ok);
+    BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::Receipt);
+
+    /* First header wins, values may contain colons */
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue("receipt-id"), "0");
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue("url"), "wss://host:443");
+    BOOST_CHECK_EQUAL(frame.GetSize(), input.size());
+}
+
+BOOST_AUTO_TEST_CASE(several_frames)
+{
+    const auto input {kConnectedFrame + "\n" + kMessageFrame};
+    std::string_view data {input};
+    StompFrame frame {};
+    BOOST_REQUIRE_EQUAL(frame.Parse(data), StompError::Ok);
+    BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::Connected);
+    data.remove_prefix(frame.GetSize());
+    BOOST_REQUIRE_EQUAL(frame.Parse(data), StompError::Ok);
+    BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::Message);
+    data.remove_prefix(frame.GetSize());
+    BOOST_CHECK(data.empty());
+}
+
+BOOST_AUTO_TEST_CASE(invalid)
+{
+    StompFrame frame {};
+    BOOST_CHECK_EQUAL(frame.Parse(""), StompError::EmptyFrame);
+    BOOST_CHECK_EQUAL(frame.Parse("\n\r\n"), StompError::EmptyFrame);
+    BOOST_CHECK_EQUAL(frame.Parse("CONNECTED"), StompError::MissingCommandEol);
+    BOOST_CHECK_EQUAL(frame.Parse("CONNECT ED\n\n\0"s), StompError::UndefinedCommand);
+    BOOST_CHECK_EQUAL(frame.Parse("connected\n\n\0"s), StompError::UndefinedCommand);
+    BOOST_CHECK_EQUAL(frame.Parse("CONNECTED\nversion"), StompError::MissingBodyEol);
+    BOOST_CHECK_EQUAL(frame.Parse("CONNECTED\nversion\n\n\0"s),
+                      StompError::MissingHeaderSeparator);
+    BOOST_CHECK_EQUAL(frame.Parse("CONNECTED\n:1.2\n\n\0"s), StompError::EmptyHeaderName);
+    BOOST_CHECK_EQUAL(frame.Parse("CONNECTED\nversion:1.2\n\n"), StompError::MissingNullTerminator);
+    BOOST_CHECK_EQUAL(frame.Parse("SEND\ncontent-length:x\n\nbody\0"s),
+                      StompError::InvalidContentLength);
+    BOOST_CHECK_EQUAL(frame.Parse("SEND\ncontent-length:3\n\nbody\0"s),
+                      StompError::MissingNullTerminator);
+    BOOST_CHECK_EQUAL(frame.Parse("SEND\ncontent-length:9\n\nbody\0"s),
+                      StompError::MissingNullTerminator);
+
+    std::string tooManyHeaders {"SEND\n"};
+    for (size_t idx {0}; idx <= StompFrame::kMaxHeaders; ++idx)
+    {
+        tooManyHeaders += "header:" + std::to_string(idx) + "\n";
+    }
+    tooManyHeaders += "\n\0"s;
+    BOOST_CHECK_EQUAL(frame.Parse(tooManyHeaders), StompError::TooManyHeaders);
+    BOOST_CHECK_EQUAL(frame.GetHeaderCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(fuzz)
+{
+    /* Mutate and truncate the canned frames at random. The parser must never
+       read out of its input, and a frame it accepts must point into it */
+    std::mt19937 rng {42};
+    const std::vector<std::string> seeds {kConnectedFrame, kMessageFrame, kErrorFrame};
+    const std::string alphabet {"\n\r:\0ACEMNORSTU-0123456789 "s};
+    StompFrame frame {};
+    size_t nOk {0};
+    for (int iteration {0}; iteration < 20000; ++iteration)
+    {
+        auto input {seeds[rng() % seeds.size()]};
+        const auto nMutations {rng() % 4};
+        for (size_t mutation {0}; mutation < nMutations; ++mutation)
+        {
+            input[rng() % input.size()] = alphabet[rng() % alphabet.size()];
+        }
+        if (rng() % 2 == 0)
+        {
+            input.resize(rng() % (input.size() + 1));
+        }
+
+        /* Parse a heap copy of the exact size, so that an out-of-bounds read
+           shows up under sanitizers */
+        const std::vector<char> data(input.begin(), input.end());
+        const std::string_view view {data.data(), data.size()};
+        if (frame.Parse(view) == StompError::Ok)
+        {
+            ++nOk;
+            BOOST_REQUIRE(ViewsInInput(frame, view));
+        }
+    }
+    BOOST_CHECK(nOk > 0);
+}
+
+BOOST_AUTO_TEST_CASE(throughput)
+{
+    /* One message per WebSocket message: make sure we parse well above the
+       rate of the feed (10k msgs/s) */
+    constexpr size_t nFrames {200000};
+    StompFrame frame {};
+    size_t nBytes {0};
+    const auto start {std::chrono::steady_clock::now()};
+    for (size_t idx {0}; idx < nFrames; ++idx)
+    {
+        BOOST_REQUIRE(frame.Parse(kMessageFrame) == StompError::Ok);
+        nBytes += frame.GetBody().size();
+    }
+    const std::chrono::duration<double> elapsed {std::chrono::steady_clock::now() - start};
+    BOOST_CHECK_EQUAL(nBytes, nFrames * frame.GetBody().size());
+    BOOST_TEST_MESSAGE("STOMP frames parsed per second: " << nFrames / elapsed.count());
+    BOOST_CHECK(nFrames / elapsed.count() > 10000);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* Parse */
+
+BOOST_AUTO_TEST_SUITE(Serialize);
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    std::string buffer {};
+    SerializeStompFrame(buffer, StompCommand::Send, {
+        {"destination", "/passengers"},
+        {"content-type", "text/plain"},
+    }, "Hello\0STOMP"s);
+    BOOST_CHECK_EQUAL(
+        buffer,
+        "SEND\n"
+        "destination:/passengers\n"
+        "content-type:text/plain\n"
+        "content-length:11\n"
+        "\n"
+        "Hello\0STOMP\0"s
+    );
+
+    StompFrame frame {};
+    BOOST_REQUIRE_EQUAL(frame.Parse(buffer), StompError::Ok);
+    BOOST_CHECK_EQUAL(frame.GetCommand(), StompCommand::Send);
+    BOOST_CHECK_EQUAL(frame.GetHeaderValue("destination"), "/passengers");
+    BOOST_CHECK_EQUAL(frame.GetBody(), "Hello\0STOMP"s);
+}
+
+BOOST_AUTO_TEST_CASE(reuse_buffer)
+{
+    std::string buffer {};
+    SerializeStompFrame(buffer, StompCommand::Subscribe, {
+        {"id", "0"},
+        {"destination", "/passengers"},
+        {"ack", "client-individual"},
+    });
+    const auto* data {buffer.data()};
+    const auto capacity {buffer.capacity()};
+
+    /* A smaller frame fits in the same storage */
+    SerializeStompFrame(buffer, StompCommand::Ack, {{"id", "ack-007"}});
+    BOOST_CHECK_EQUAL(buffer, "ACK\nid:ack-007\n\n\0"s);
+    BOOST_CHECK(buffer.data() == data);
+    BOOST_CHECK_EQUAL(buffer.capacity(), capacity);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* Serialize */
+
+BOOST_AUTO_TEST_SUITE_END();    /* class_StompFrame */
+BOOST_AUTO_TEST_SUITE_END();    /* network_monitor */
@@ -0,0 +1,825 @@
+#include "TestServer.h"
+
+#include "StompFrame.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/ssl.hpp>
+#include <openssl/ssl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using NetworkMonitor::CompressionOptions;
+using NetworkMonitor::SerializeStompFrame;
+using NetworkMonitor::StompCommand;
+using NetworkMonitor::StompError;
+using NetworkMonitor::StompFrame;
+using NetworkMonitor::TestServer;
+using NetworkMonitor::TestServerOptions;
+using NetworkMonitor::TestServerStats;
+
+namespace asio = boost::asio;
+namespace beast = boost::beast;
+namespace http = boost::beast::http;
+namespace websocket = boost::beast::websocket;
+using tcp = boost::asio::ip::tcp;
+
+using TlsStream = beast::ssl_stream<beast::tcp_stream>;
+using PlainStream = beast::tcp_stream;
+
+namespace
+{
+    /* A session that DropConnections can cut */
+    class DroppableSession
+    {
+    public:
+        virtual ~DroppableSession() = default;
+
+        virtual void Drop() = 0;
+    };
+}   /* namespace */
+
+/* The members are destroyed in reverse order: the acceptor and the sessions
+   (pending handlers of the io_context) go before the TLS context */
+struct TestServer::State
+{
+    TestServerOptions options {};
+    asio::ssl::context ctx {asio::ssl::context::tlsv12_server};
+    asio::io_context ioc {};
+    tcp::acceptor acceptor {ioc};
+
+    /* Live WebSocket sessions */
+    std::mutex sessionsMutex {};
+    std::vector<std::weak_ptr<DroppableSession>> sessions {};
+
+    std::atomic<std::uint64_t> connections {0};
+    std::atomic<std::uint64_t> resumedTlsSessions {0};
+    std::atomic<std::uint64_t> httpRequests {0};
+    std::atomic<std::uint64_t> layoutBytesSent {0};
+};
+
+namespace
+{
+    /* WebSocket session: echo, or STOMP stand-in on the STOMP endpoint
+       All handlers run on the strand of the accepted socket */
+    template <typename Stream>
+    class WebSocketSession: public DroppableSession,
+                            public std::enable_shared_from_this<WebSocketSession<Stream>>
+    {
+    public:
+        WebSocketSession (
+            Stream&& stream,
+            TestServer::State& state
+        ) : ws_ {std::move(stream)},
+            state_ {state},
+            timer_ {ws_.get_executor()}
+        {}
+
+        void Run (
+            http::request<http::string_body>&& request
+        )
+        {
+            {
+                std::lock_guard<std::mutex> lock {state_.sessionsMutex};
+                auto& sessions {state_.sessions};
+                sessions.erase(std::remove_if(sessions.begin(), sessions.end(),
+                    [](const auto& session) {
+                        return session.expired();
+                    }
+                ), sessions.end());
+                sessions.push_back(this->shared_from_this());
+            }
+            request_ = std::move(request);
+            stomp_ = request_.target() == state_.options.stompEndpoint;
+            ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+
+            const auto& compression {state_.options.compression};
+            websocket::permessage_deflate pmd {};
+            pmd.server_enable = compression.enabled;
+            pmd.server_max_window_bits = std::clamp(compression.windowBits, 9, 15);
+            pmd.client_max_window_bits = pmd.server_max_window_bits;
+            pmd.server_no_context_takeover = compression.noContextTakeover;
+            pmd.client_no_context_takeover = compression.noContextTakeover;
+            pmd.memLevel = std::clamp(compression.memLevel, 1, 9);
+            pmd.compLevel = std::clamp(compression.level, 0, 9);
+            ws_.set_option(pmd);
+            ws_.async_accept(request_, [self = this->shared_from_this()](auto ec) {
+                if (!ec)
+                {
+                    self->Read();
+                }
+            });
+        }
+
+        void Drop() override
+        {
+            asio::post(ws_.get_executor(), [self = this->shared_from_this()]() {
+                beast::error_code ignored {};
+                beast::get_lowest_layer(self->ws_).socket().close(ignored);
+            });
+        }
+
+    private:
+        websocket::stream<Stream> ws_;
+        TestServer::State& state_;
+        http::request<http::string_body> request_ {};
+        beast::flat_buffer buffer_ {};
+        std::deque<std::string> writeQueue_ {};
+        bool closed_ {false};
+        bool closing_ {false};
+
+        /* STOMP session */
+        bool stomp_ {false};
+        bool authenticated_ {false};
+        StompFrame frame_ {};
+        std::string subscription_ {};
+        std::string destination_ {};
+        size_t nextEvent_ {0};
+        bool replaying_ {false};
+        std::chrono::steady_clock::time_point replayStart_ {};
+        asio::steady_timer timer_;
+
+        void Read()
+        {
+            ws_.async_read(buffer_, [self = this->shared_from_this()](auto ec, auto) {
+                self->OnRead(ec);
+            });
+        }
+
+        void OnRead (
+            const beast::error_code& ec
+        )
+        {
+            if (ec)
+            {
+                closed_ = true;
+                timer_.cancel();
+                return;
+            }
+
+            auto message {beast::buffers_to_string(buffer_.data())};
+            buffer_.consume(buffer_.size());
+            if (stomp_)
+            {
+                OnStompMessage(message);
+            }
+            else
+            {
+                Write(std::move(message));
+            }
+            if (!closing_)
+            {
+                Read();
+            }
+        }
+
+        void OnStompMessage (
+            std::string_view message
+        )
+        {
+            while (!message.empty())
+            {
+                const auto error {frame_.Parse(message)};
+                if (error == StompError::EmptyFrame)
+                    break;
+                if (error != StompError::Ok)
+                {
+                    SendError("MalformedFrame");
+                    break;
+                }
+                OnStompFrame(frame_);
+                message.remove_prefix(frame_.GetSize());
+            }
+        }
+
+        void OnStompFrame (
+            const StompFrame& frame
+        )
+        {
+            std::string response {};
+            switch (frame.GetCommand())
+            {
+            case StompCommand::Connect:
+            case StompCommand::Stomp:
+            {
+                const auto& options {state_.options};
+                if (frame.GetHeaderValue("login") != options.username
+                    || frame.GetHeaderValue("passcode") != options.password)
+                {
+                    SendError("ValidationInvalidAuth");
+                    return;
+                }
+                authenticated_ = true;
+                SerializeStompFrame(response, StompCommand::Connected, {
+                    {"version", "1.2"},
+                });
+                Write(std::move(response));
+                break;
+            }
+            case StompCommand::Subscribe:
+            {
+                if (!authenticated_)
+                {
+                    SendError("ValidationInvalidAuth");
+                    return;
+                }
+                subscription_ = frame.GetHeaderValue("id");
+                destination_ = frame.GetHeaderValue("destination");
+                SendReceipt(frame);
+                nextEvent_ = 0;
+                replaying_ = true;
+                replayStart_ = std::chrono::steady_clock::now();
+                Replay();
+                break;
+            }
+            case StompCommand::Ack:
+            case StompCommand::Nack:
+            {
+                break;
+            }
+            case StompCommand::Disconnect:
+            {
+                replaying_ = false;
+                timer_.cancel();
+                SendReceipt(frame);
+                break;
+            }
+            default:
+            {
+                SendError("UnexpectedFrame");
+                break;
+            }
+            }
+        }
+
+        void SendReceipt (
+            const StompFrame& frame
+        )
+        {
+            if (!frame.HasHeader("receipt"))
+                return;
+
+            std::string response {};
+            SerializeStompFrame(response, StompCommand::Receipt, {
+                {"receipt-id", frame.GetHeaderValue("receipt")},
+            });
+            Write(std::move(response));
+        }
+
+        /* Send an ERROR frame and close the connection, like the real
+           server */
+        void SendError (
+            std::string_view message
+        )
+        {
+            std::string response {};
+            SerializeStompFrame(response, StompCommand::Error, {
+                {"message", message},
+            });
+            replaying_ = false;
+            timer_.cancel();
+            closing_ = true;
+            Write(std::move(response));
+        }
+
+        /* Send the next recorded event, then schedule the following one */
+        void Replay()
+        {
+            const auto& options {state_.options};
+            if (closed_ || !replaying_ || nextEvent_ >= options.events.size())
+            {
+                replaying_ = false;
+                return;
+            }
+
+            const auto id {std::to_string(nextEvent_)};
+            std::string message {};
+            SerializeStompFrame(message, StompCommand::Message, {
+                {"subscription", subscription_},
+                {"message-id", id},
+                {"ack", id},
+                {"destination", destination_},
+                {"content-type", "application/json"},
+            }, options.events[nextEvent_]);
+            ++nextEvent_;
+            Write(std::move(message));
+
+            /* Back to back: the next event goes once this one is written */
+            if (options.eventsPerSecond <= 0)
+                return;
+
+            /* Paced: aim at the absolute schedule, so that slow writes do not
+               lower the rate */
+            const auto offset {std::chrono::duration<double> {
+                nextEvent_ / options.eventsPerSecond
+            }};
+            timer_.expires_at(replayStart_
+                + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+            timer_.async_wait([self = this->shared_from_this()](auto ec) {
+                if (!ec)
+                {
+                    self->Replay();
+                }
+            });
+        }
+
+        /* Beast allows a single outstanding write per stream */
+        void Write (
+            std::string message
+        )
+        {
+            writeQueue_.push_back(std::move(message));
+            if (writeQueue_.size() == 1)
+            {
+                DoWrite();
+            }
+        }
+
+        void DoWrite()
+        {
+            ws_.text(true);
+            ws_.async_write(asio::buffer(writeQueue_.front()),
+                [self = this->shared_from_this()](auto ec, auto) {
+                    self->OnWrite(ec);
+                }
+            );
+        }
+
+        void OnWrite (
+            const beast::error_code& ec
+        )
+        {
+            if (ec)
+            {
+                closed_ = true;
+                timer_.cancel();
+                return;
+            }
+
+            writeQueue_.pop_front();
+            if (!writeQueue_.empty())
+            {
+                DoWrite();
+            }
+            else if (closing_)
+            {
+                ws_.async_close(websocket::close_code::policy_error,
+                    [self = this->shared_from_this()](auto) {
+                        self->closed_ = true;
+                    }
+                );
+            }
+            else if (replaying_ && state_.options.eventsPerSecond <= 0)
+            {
+                Replay();
+            }
+        }
+    };
+
+    /* RFC 7231 date, e.g. "Sun, 14 Mar 2021 10:00:00 GMT" */
+    std::string FormatHttpDate (
+        std::time_t time
+    )
+    {
+        std::tm tm {};
+        gmtime_r(&time, &tm);
+        char buffer[64] {};
+        std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        return buffer;
+    }
+
+    /* Return -1 if the date cannot be parsed */
+    std::time_t ParseHttpDate (
+        const std::string& date
+    )
+    {
+        std::tm tm {};
+        if (strptime(date.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm) == nullptr)
+        {
+            return -1;
+        }
+        return timegm(&tm);
+    }
+
+    /* Parse a single "bytes=first-" or "bytes=first-last" range
+       Return false if the header has another form, which we then ignore */
+    bool ParseRange (
+        std::string_view value,
+        size_t& first,
+        size_t& last
+    )
+    {
+        const std::string_view unit {"bytes="};
+        if (value.substr(0, unit.size()) != unit)
+        {
+            return false;
+        }
+        value.remove_prefix(unit.size());
+        const auto dash {value.find('-')};
+        if (dash == 0 || dash == std::string_view::npos
+            || value.find(',') != std::string_view::npos)
+        {
+            return false;
+        }
+        try
+        {
+            first = std::stoull(std::string {value.substr(0, dash)});
+            const auto lastValue {value.substr(dash + 1)};
+            last = lastValue.empty() ? SIZE_MAX : std::stoull(std::string {lastValue});
+        }
+        catch (...)
+        {
+            return false;
+        }
+        return first <= last;
+    }
+
+    /* HTTP session: serve the layout file, or hand over to a WebSocket
+       session on an upgrade request */
+    template <typename Stream>
+    class HttpSession: public std::enable_shared_from_this<HttpSession<Stream>>
+    {
+    public:
+        HttpSession (
+            tcp::socket&& socket,
+            TestServer::State& state
+        ) : stream_ {MakeStream(std::move(socket), state)},
+            state_ {state}
+        {}
+
+        void Run()
+        {
+            if constexpr (std::is_same_v<Stream, TlsStream>)
+            {
+                beast::get_lowest_layer(stream_).expires_after(std::chrono::seconds(30));
+                stream_.async_handshake(asio::ssl::stream_base::server,
+                    [self = this->shared_from_this()](auto ec) {
+                        if (ec)
+                        {
+                            return;
+                        }
+                        if (SSL_session_reused(self->stream_.native_handle()))
+                        {
+                            self->state_.resumedTlsSessions.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        self->Read();
+                    }
+                );
+            }
+            else
+            {
+                Read();
+            }
+        }
+
+    private:
+        Stream stream_;
+        TestServer::State& state_;
+        beast::flat_buffer buffer_ {};
+        http::request<http::string_body> request_ {};
+        http::response<http::string_body> response_ {};
+
+        static Stream MakeStream (
+            tcp::socket&& socket,
+            TestServer::State& state
+        )
+        {
+            if constexpr (std::is_same_v<Stream, TlsStream>)
+            {
+                return Stream {std::move(socket), state.ctx};
+            }
+            else
+            {
+                return Stream {std::move(socket)};
+            }
+        }
+
+        void Read()
+        {
+            request_ = {};
+            beast::get_lowest_layer(stream_).expires_after(std::chrono::seconds(30));
+            http::async_read(stream_, buffer_, request_,
+                [self = this->shared_from_this()](auto ec, auto) {
+                    self->OnRead(ec);
+                }
+            );
+        }
+
+        void OnRead (
+            const beast::error_code& ec
+        )
+        {
+            if (ec)
+            {
+                Shutdown();
+                return;
+            }
+
+            if (websocket::is_upgrade(request_))
+            {
+                /* The WebSocket stream manages its own timeouts */
+                beast::get_lowest_layer(stream_).expires_never();
+                std::make_shared<WebSocketSession<Stream>>(std::move(stream_), state_)
+                    ->Run(std::move(request_));
+                return;
+            }
+
+            state_.httpRequests.fetch_add(1, std::memory_order_relaxed);
+            response_ = {};
+            response_.version(request_.version());
+            response_.keep_alive(request_.keep_alive());
+            if (request_.method() != http::verb::get
+                || request_.target() != state_.options.layoutEndpoint
+                || !ServeLayout())
+            {
+                response_.result(http::status::not_found);
+                response_.set(http::field::content_type, "text/plain");
+                response_.body() = "Not found";
+            }
+            response_.prepare_payload();
+            http::async_write(stream_, response_,
+                [self = this->shared_from_this()](auto ec, auto) {
+                    if (ec || self->response_.need_eof())
+                    {
+                        self->Shutdown();
+                        return;
+                    }
+                    self->Read();
+                }
+            );
+        }
+
+        /* Fill the response with the layout file, honouring the
+           conditional and range headers. Return false if the file cannot
+           be read */
+        bool ServeLayout()
+        {
+            const auto& path {state_.options.layoutFile};
+            struct stat info {};
+            std::ifstream file {path, std::ios::binary};
+            if (!file || ::stat(path.c_str(), &info) != 0)
+            {
+                return false;
+            }
+
+            /* Validators derived from the file size and modification time */
+            const auto etag {
+                "\"" + std::to_string(info.st_size) + "-" + std::to_string(info.st_mtime) + "\""
+            };
+            response_.set(http::field::etag, etag);
+            response_.set(http::field::last_modified, FormatHttpDate(info.st_mtime));
+            response_.set(http::field::accept_ranges, "bytes");
+
+            /* If-None-Match takes precedence over If-Modified-Since */
+            bool notModified {false};
+            if (const auto it {request_.find(http::field::if_none_match)}; it != request_.end())
+            {
+                notModified = it->value() == etag || it->value() == "*";
+            }
+            else if (const auto it {request_.find(http::field::if_modified_since)};
+                     it != request_.end())
+            {
+                const auto since {ParseHttpDate(std::string {it->value()})};
+                notModified = since != -1 && info.st_mtime <= since;
+            }
+            if (notModified)
+            {
+                response_.result(http::status::not_modified);
+                return true;
+            }
+
+            std::string content {
+                std::istreambuf_iterator<char> {file},
+                std::istreambuf_iterator<char> {}
+            };
+            response_.result(http::status::ok);
+            response_.set(http::field::content_type, "application/json");
+
+            /* If-Range: a stale validator gets the whole file instead */
+            bool rangeValid {true};
+            if (const auto it {request_.find(http::field::if_range)}; it != request_.end())
+            {
+                const std::string validator {it->value()};
+                rangeValid = !validator.empty() && validator.front() == '"'
+                    ? validator == etag
+                    : ParseHttpDate(validator) == info.st_mtime;
+            }
+            size_t first {0};
+            size_t last {0};
+            const auto range {request_.find(http::field::range)};
+            if (rangeValid
+                && range != request_.end()
+                && ParseRange({range->value().data(), range->value().size()}, first, last))
+            {
+                if (first >= content.size())
+                {
+                    response_.result(http::status::range_not_satisfiable);
+                    response_.set(http::field::content_range,
+                                  "bytes */" + std::to_string(content.size()));
+                    return true;
+                }
+                last = std::min(last, content.size() - 1);
+                response_.result(http::status::partial_content);
+                response_.set(http::field::content_range,
+                              "bytes " + std::to_string(first) + "-" + std::to_string(last)
+                              + "/" + std::to_string(content.size()));
+                content = content.substr(first, last - first + 1);
+            }
+            state_.layoutBytesSent.fetch_add(content.size(), std::memory_order_relaxed);
+            response_.body() = std::move(content);
+            return true;
+        }
+
+        void Shutdown()
+        {
+            if constexpr (std::is_same_v<Stream, TlsStream>)
+            {
+                stream_.async_shutdown([self = this->shared_from_this()](auto) {});
+            }
+            else
+            {
+                beast::error_code ignored {};
+                stream_.socket().shutdown(tcp::socket::shutdown_send, ignored);
+            }
+        }
+    };
+
+    void Accept (
+        TestServer::State& state
+    )
+    {
+        state.acceptor.async_accept(asio::make_strand(state.ioc),
+            [&state](auto ec, tcp::socket socket) {
+                if (ec)
+                {
+                    return;
+                }
+                state.connections.fetch_add(1, std::memory_order_relaxed);
+                if (state.options.tls)
+                {
+                    std::make_shared<HttpSession<TlsStream>>(std::move(socket), state)->Run();
+                }
+                else
+                {
+                    std::make_shared<HttpSession<PlainStream>>(std::move(socket), state)->Run();
+                }
+                Accept(state);
+            }
+        );
+    }
+}   /* namespace */
+
+/* Public methods */
+TestServer::TestServer (
+    const TestServerOptions& options
+) : options_ {options}
+{}
+
+TestServer::~TestServer()
+{
+    Stop();
+}
+
+std::uint16_t TestServer::Start()
+{
+    Stop();
+    state_ = std::make_unique<State>();
+    state_->options = options_;
+
+    boost::system::error_code ec {};
+    if (options_.tls)
+    {
+        state_->ctx.use_certificate_chain_file(options_.certFile.string(), ec);
+        if (!ec)
+        {
+            state_->ctx.use_private_key_file(
+                options_.keyFile.string(),
+                asio::ssl::context::pem,
+                ec
+            );
+        }
+        if (ec)
+        {
+            state_.reset();
+            return 0;
+        }
+    }
+
+    auto& acceptor {state_->acceptor};
+    const tcp::endpoint endpoint {asio::ip::make_address("127.0.0.1"), 0};
+    acceptor.open(endpoint.protocol(), ec);
+    if (!ec)
+    {
+        acceptor.set_option(asio::socket_base::reuse_address(true), ec);
+    }
+    if (!ec)
+    {
+        acceptor.bind(endpoint, ec);
+    }
+    if (!ec)
+    {
+        acceptor.listen(asio::socket_base::max_listen_connections, ec);
+    }
+    if (ec)
+    {
+        state_.reset();
+        return 0;
+    }
+    port_ = acceptor.local_endpoint().port();
+
+    Accept(*state_);
+    const auto nThreads {std::max(options_.nThreads, 1u)};
+    for (unsigned int thread {0}; thread < nThreads; ++thread)
+    {
+        threads_.emplace_back([this]() {
+            state_->ioc.run();
+        });
+    }
+
+    return port_;
+}
+
+void TestServer::Stop()
+{
+    if (state_ == nullptr)
+        return;
+
+    state_->ioc.stop();
+    for (auto& thread: threads_)
+    {
+        thread.join();
+    }
+    threads_.clear();
+    state_.reset();
+    port_ = 0;
+}
+
+std::uint16_t TestServer::GetPort() const
+{
+    return port_;
+}
+
+void TestServer::DropConnections()
+{
+    if (state_ == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock {state_->sessionsMutex};
+    for (const auto& session: state_->sessions)
+    {
+        if (auto live {session.lock()})
+        {
+            live->Drop();
+        }
+    }
+    state_->sessions.clear();
+}
+
+TestServerStats TestServer::GetStats() const
+{
+    TestServerStats stats {};
+    if (state_ == nullptr)
+        return stats;
+
+    stats.connections = state_->connections.load(std::memory_order_relaxed);
+    stats.resumedTlsSessions = state_->resumedTlsSessions.load(std::memory_order_relaxed);
+    stats.httpRequests = state_->httpRequests.load(std::memory_order_relaxed);
+    stats.layoutBytesSent = state_->layoutBytesSent.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::vector<std::string> TestServer::LoadEvents (
+    const std::filesystem::path& src
+)
+{
+    std::vector<std::string> events {};
+    std::ifstream file {src};
+    std::string line {};
+    while (std::getline(file, line))
+    {
+        if (!line.empty())
+        {
+            events.push_back(std::move(line));
+        }
+    }
+    return events;
+}
@@ -0,0 +1,128 @@
+/* @brief: Implement a local stand-in for the remote servers the client talks
+ *         to, for deterministic tests and load tests.
+ *         A single port serves, over TLS or plain TCP:
+ *         - WebSocket echo, on any endpoint other than the STOMP one
+ *         - A STOMP passenger event feed on the STOMP endpoint. After a
+ *           successful SUBSCRIBE, it replays a recorded stream of JSON events
+ *           as MESSAGE frames at a configurable rate
+ *         - The network layout JSON file over HTTP(S), with ETag and
+ *           Last-Modified validators, conditional requests and byte ranges,
+ *           including If-Range
+ */
+
+#ifndef TEST_SERVER_H
+#define TEST_SERVER_H
+
+#include "WebSocketClient.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace NetworkMonitor
+{
+    /* @brief: Test server settings
+     * @member:
+     *         - `tls` serve TLS with `certFile` and `keyFile` (PEM)
+     *         - `username`, `password` STOMP credentials. Other credentials
+     *           get an ERROR frame, like the real server
+     *         - `events` JSON passenger events replayed to each subscription
+     *         - `eventsPerSecond` replay rate. 0 sends them back to back
+     *         - `compression` accept permessage-deflate. The window bits are
+     *           the largest the server accepts. The threshold is not used
+     *         - `layoutFile` file served at `layoutEndpoint`
+     *         - `nThreads` number of server threads
+     */
+    struct TestServerOptions
+    {
+        bool tls {true};
+        std::filesystem::path certFile {};
+        std::filesystem::path keyFile {};
+
+        std::string stompEndpoint {"/network-events"};
+        std::string username {"username"};
+        std::string password {"password"};
+        std::vector<std::string> events {};
+        double eventsPerSecond {0};
+        CompressionOptions compression {};
+
+        std::string layoutEndpoint {"/network-layout.json"};
+        std::filesystem::path layoutFile {};
+
+        unsigned int nThreads {1};
+    };
+
+    /* @brief: Server counters
+     * @member:
+     *         - `connections` accepted TCP connections
+     *         - `resumedTlsSessions` TLS handshakes that resumed a session
+     *         - `httpRequests` HTTP requests, not counting WebSocket upgrades
+     *         - `layoutBytesSent` layout file bytes sent in response bodies
+     */
+    struct TestServerStats
+    {
+        std::uint64_t connections {0};
+        std::uint64_t resumedTlsSessions {0};
+        std::uint64_t httpRequests {0};
+        std::uint64_t layoutBytesSent {0};
+    };
+
+    class TestServer
+    {
+    public:
+        explicit TestServer (
+            const TestServerOptions& options
+        );
+
+        /* @brief: Stop the server, see Stop */
+        ~TestServer();
+
+        TestServer (
+            const TestServer& copied
+        ) = delete;
+
+        TestServer& operator= (
+            const TestServer& copied
+        ) = delete;
+
+        /* @brief: Listen on a free port of 127.0.0.1 and start the server
+         *         threads
+         * @return: The port, or 0 if the server could not start
+         */
+        std::uint16_t Start();
+
+        /* @brief: Stop the server threads and drop all connections */
+        void Stop();
+
+        std::uint16_t GetPort() const;
+
+        /* @brief: Abruptly close the TCP socket of every WebSocket session,
+         *         as if the network dropped. The server keeps listening
+         */
+        void DropConnections();
+
+        /* @brief: Get a snapshot of the counters since Start */
+        TestServerStats GetStats() const;
+
+        /* @brief: Load a recorded event stream, one JSON event per line */
+        static std::vector<std::string> LoadEvents (
+            const std::filesystem::path& src
+        );
+
+        /* I/O objects shared with the sessions, defined with them */
+        struct State;
+
+    private:
+        TestServerOptions options_ {};
+
+        /* Owns the io_context, so destroying it drops all sessions */
+        std::unique_ptr<State> state_ {};
+        std::vector<std::thread> threads_ {};
+        std::uint16_t port_ {0};
+    };
+}   /* namespace NetworkMonitor */
+
+#endif  /* TEST_SERVER_H */
@@ -2,12 +2,77 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
 using NetworkMonitor::Id;
 using NetworkMonitor::Station;
 using NetworkMonitor::Route;
 using NetworkMonitor::Line;
 using NetworkMonitor::PassengerEvent;
+using NetworkMonitor::PassengerDelta;
 using NetworkMonitor::TransportNetwork;
+using NetworkMonitor::StationHandle;
+using NetworkMonitor::RouteHandle;
+using NetworkMonitor::kInvalidHandle;
+using NetworkMonitor::Itinerary;
+using NetworkMonitor::ItineraryOptions;
+using NetworkMonitor::CrowdingModel;
+
+/* Network used by the itinerary and travel time matrix tests
+   line0 route0: 0 -1-> 1 -1-> 2
+   line1 route1: 2 -1-> 3
+   line2 route2: 0 -3-> 4 -2-> 3 */
+static TransportNetwork MakeItineraryNetwork()
+{
+    TransportNetwork nw {};
+    bool ok {true};
+    for (const auto& id: {"station_000", "station_001", "station_002",
+                          "station_003", "station_004"})
+    {
+        ok &= nw.AddStation({id, "Station Name"});
+    }
+    Route route0 {
+        "route_000",
+        "inbound",
+        "line_000",
+        "station_000",
+        "station_002",
+        {"station_000", "station_001", "station_002"}
+    };
+    Route route1 {
+        "route_001",
+        "inbound",
+        "line_001",
+        "station_002",
+        "station_003",
+        {"station_002", "station_003"}
+    };
+    Route route2 {
+        "route_002",
+        "inbound",
+        "line_002",
+        "station_000",
+        "station_003",
+        {"station_000", "station_004", "station_003"}
+    };
+    ok &= nw.AddLine({"line_000", "Line Name 0", {route0}});
+    ok &= nw.AddLine({"line_001", "Line Name 1", {route1}});
+    ok &= nw.AddLine({"line_002", "Line Name 2", {route2}});
+    ok &= nw.SetTravelTime("station_000", "station_001", 1);
+    ok &= nw.SetTravelTime("station_001", "station_002", 1);
+    ok &= nw.SetTravelTime("station_002", "station_003", 1);
+    ok &= nw.SetTravelTime("station_000", "station_004", 3);
+    ok &= nw.SetTravelTime("station_004", "station_003", 2);
+    BOOST_REQUIRE(ok);
+
+    return nw;
+}
 
 BOOST_AUTO_TEST_SUITE(network_monitor);
 BOOST_AUTO_TEST_SUITE(class_TransportNetwork);
@@ -261,5 +326,1109 @@ BOOST_AUTO_TEST_CASE(missing_station)
 
 BOOST_AUTO_TEST_SUITE_END();    /* AddLine */
 
+BOOST_AUTO_TEST_SUITE(PassengerEvents);
+
+BOOST_AUTO_TEST_CASE(basic)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+
+    /* Add stations */
+    Station station0 {
+        "station_000",
+        "Station Name 0"
+    };
+    Station station1 {
+        "station_001",
+        "Station Name 1"
+    };
+    ok &= nw.AddStation(station0);
+    ok &= nw.AddStation(station1);
+    BOOST_REQUIRE(ok);
+
+    /* Record events and check the count */
+    using EventType = PassengerEvent::Type;
+    ok = nw.RecordPassengerEvent({"station_000", EventType::In});
+    BOOST_REQUIRE(ok);
+    ok = nw.RecordPassengerEvent({"station_000", EventType::In});
+    BOOST_REQUIRE(ok);
+    ok = nw.RecordPassengerEvent({"station_001", EventType::Out});
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_000"), 2);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_001"), -1);
+
+    /* Unknown station */
+    ok = nw.RecordPassengerEvent({"station_002", EventType::In});
+    BOOST_CHECK(!ok);
+    BOOST_CHECK_THROW(nw.GetPassengerCount("station_002"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(batch)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+
+    /* Add stations */
+    Station station0 {
+        "station_000",
+        "Station Name 0"
+    };
+    Station station1 {
+        "station_001",
+        "Station Name 1"
+    };
+    ok &= nw.AddStation(station0);
+    ok &= nw.AddStation(station1);
+    BOOST_REQUIRE(ok);
+
+    /* A burst with interleaved stations and one unknown station */
+    using EventType = PassengerEvent::Type;
+    std::vector<PassengerEvent> events {
+        {"station_000", EventType::In},
+        {"station_001", EventType::Out},
+        {"station_000", EventType::In},
+        {"station_002", EventType::In},
+        {"station_000", EventType::Out},
+        {"station_001", EventType::Out},
+    };
+    auto rejected {nw.RecordPassengerEvents(events.data(), events.size())};
+    BOOST_CHECK_EQUAL(rejected, 1);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_000"), 1);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_001"), -2);
+
+    /* Pre-resolved deltas */
+    const auto handle0 {nw.GetStationHandle("station_000")};
+    const auto handle1 {nw.GetStationHandle("station_001")};
+    std::vector<PassengerDelta> deltas {
+        {handle1, 5},
+        {kInvalidHandle, 1},
+        {handle0, -3},
+        {handle1, 2},
+    };
+    rejected = nw.RecordPassengerEvents(deltas.data(), deltas.size());
+    BOOST_CHECK_EQUAL(rejected, 1);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount(handle0), -2);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount(handle1), 5);
+
+    /* Empty burst */
+    rejected = nw.RecordPassengerEvents(events.data(), 0);
+    BOOST_CHECK_EQUAL(rejected, 0);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+
+    /* Add stations */
+    const size_t nStations {16};
+    std::vector<StationHandle> stations {};
+    for (size_t idx {0}; idx < nStations; ++idx)
+    {
+        const Id id {"station_" + std::to_string(idx)};
+        ok &= nw.AddStation({id, "Station Name"});
+        stations.push_back(nw.GetStationHandle(id));
+    }
+    BOOST_REQUIRE(ok);
+
+    /* Each thread feeds its own synthetic stream of In/Out events.
+       Two out of three events are In, and the stream rotates across stations */
+    const size_t nThreads {8};
+    const size_t nEventsPerThread {500000};
+    auto eventType {[](size_t idx) {
+        return idx % 3 == 0 ? PassengerEvent::Type::Out : PassengerEvent::Type::In;
+    }};
+    std::vector<std::thread> threads {};
+    std::vector<size_t> failures(nThreads, 0);
+    for (size_t thread {0}; thread < nThreads; ++thread)
+    {
+        threads.emplace_back([&, thread]() {
+            for (size_t idx {0}; idx < nEventsPerThread; ++idx)
+            {
+                const auto station {stations[(idx + thread) % nStations]};
+                if (!nw.RecordPassengerEvent(station, eventType(idx)))
+                {
+                    ++failures[thread];
+                }
+            }
+        });
+    }
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+
+    /* Compute the expected totals serially */
+    std::vector<long long int> expected(nStations, 0);
+    for (size_t thread {0}; thread < nThreads; ++thread)
+    {
+        BOOST_CHECK_EQUAL(failures[thread], 0);
+        for (size_t idx {0}; idx < nEventsPerThread; ++idx)
+        {
+            expected[(idx + thread) % nStations] +=
+                eventType(idx) == PassengerEvent::Type::In ? 1 : -1;
+        }
+    }
+    for (size_t idx {0}; idx < nStations; ++idx)
+    {
+        BOOST_CHECK_EQUAL(nw.GetPassengerCount(stations[idx]), expected[idx]);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* PassengerEvents */
+
+BOOST_AUTO_TEST_SUITE(GetRoutesServingStation);
+
+BOOST_AUTO_TEST_CASE(basic)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+
+    /* Add stations */
+    Station station0 {
+        "station_000",
+        "Station Name 0"
+    };
+    Station station1 {
+        "station_001",
+        "Station Name 1"
+    };
+    Station station2 {
+        "station_002",
+        "Station Name 2"
+    };
+    Station station3 {
+        "station_003",
+        "Station Name 3"
+    };
+    ok &= nw.AddStation(station0);
+    ok &= nw.AddStation(station1);
+    ok &= nw.AddStation(station2);
+    ok &= nw.AddStation(station3);
+    BOOST_REQUIRE(ok);
+
+    /* Add line with the two routes
+       route0: 0 ---> 1 ---> 2
+       route1: 3 ---> 1 ---> 2 */
+    Route route0 {
+        "route_000",
+        "inbound",
+        "line_000",
+        "station_000",
+        "station_002",
+        {"station_000", "station_001", "station_002"}
+    };
+    Route route1 {
+        "route_001",
+        "inbound",
+        "line_000",
+        "station_003",
+        "station_002",
+        {"station_003", "station_001", "station_002"}
+    };
+    Line line {
+        "line_000",
+        "Line Name",
+        {route0, route1},
+    };
+    ok = nw.AddLine(line);
+    BOOST_REQUIRE(ok);
+
+    std::vector<Id> routes {};
+    routes = nw.GetRoutesServingStation("station_000");
+    BOOST_REQUIRE_EQUAL(routes.size(), 1);
+    BOOST_CHECK(routes[0] == "route_000");
+
+    routes = nw.GetRoutesServingStation("station_001");
+    BOOST_REQUIRE_EQUAL(routes.size(), 2);
+    BOOST_CHECK(
+        std::find(routes.begin(), routes.end(), "route_000") != routes.end() &&
+        std::find(routes.begin(), routes.end(), "route_001") != routes.end()
+    );
+
+    /* Station 2 is a terminal: no outgoing edges */
+    routes = nw.GetRoutesServingStation("station_002");
+    BOOST_CHECK_EQUAL(routes.size(), 2);
+
+    /* Unknown station */
+    routes = nw.GetRoutesServingStation("station_004");
+    BOOST_CHECK(routes.empty());
+}
+
+BOOST_AUTO_TEST_CASE(view)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+
+    /* Add stations */
+    for (const auto& id: {"station_000", "station_001", "station_002", "station_003"})
+    {
+        ok &= nw.AddStation({id, "Station Name"});
+    }
+    BOOST_REQUIRE(ok);
+
+    /* Route 0 goes through station 0 twice
+       line0 route0: 0 ---> 1 ---> 2 ---> 0 ---> 3 */
+    Route route0 {
+        "route_000",
+        "inbound",
+        "line_000",
+        "station_000",
+        "station_003",
+        {"station_000", "station_001", "station_002", "station_000", "station_003"}
+    };
+    ok &= nw.AddLine({"line_000", "Line Name 0", {route0}});
+    BOOST_REQUIRE(ok);
+
+    const auto station0 {nw.GetStationHandle("station_000")};
+    const auto handle0 {nw.GetRouteHandle("line_000", "route_000")};
+    auto routes {nw.GetRoutesServingStationView(station0)};
+    BOOST_REQUIRE_EQUAL(routes.size(), 1);
+    BOOST_CHECK_EQUAL(routes[0], handle0);
+    BOOST_CHECK_EQUAL(nw.GetRoutesServingStation("station_000").size(), 1);
+
+    /* Adding a line updates the index
+       line1 route1: 3 ---> 0 */
+    Route route1 {
+        "route_001",
+        "inbound",
+        "line_001",
+        "station_003",
+        "station_000",
+        {"station_003", "station_000"}
+    };
+    ok &= nw.AddLine({"line_001", "Line Name 1", {route1}});
+    BOOST_REQUIRE(ok);
+    const auto handle1 {nw.GetRouteHandle("line_001", "route_001")};
+    routes = nw.GetRoutesServingStationView(station0);
+    BOOST_REQUIRE_EQUAL(routes.size(), 2);
+    BOOST_CHECK(std::is_sorted(routes.begin(), routes.end()));
+    BOOST_CHECK(std::find(routes.begin(), routes.end(), handle1) != routes.end());
+    BOOST_CHECK_EQUAL(nw.GetRoutesServingStationView("station_003").size(), 2);
+    BOOST_CHECK_EQUAL(nw.GetRoutesServingStationView("station_001").size(), 1);
+
+    /* A new station starts with no routes */
+    ok = nw.AddStation({"station_004", "Station Name"});
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK(nw.GetRoutesServingStationView("station_004").empty());
+
+    /* Unknown station */
+    BOOST_CHECK(nw.GetRoutesServingStationView("station_005").empty());
+    BOOST_CHECK(nw.GetRoutesServingStationView(kInvalidHandle).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* GetRoutesServingStation */
+
+BOOST_AUTO_TEST_SUITE(TravelTime);
+
+BOOST_AUTO_TEST_CASE(basic)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+
+    /* Add stations */
+    Station station0 {
+        "station_000",
+        "Station Name 0"
+    };
+    Station station1 {
+        "station_001",
+        "Station Name 1"
+    };
+    Station station2 {
+        "station_002",
+        "Station Name 2"
+    };
+    ok &= nw.AddStation(station0);
+    ok &= nw.AddStation(station1);
+    ok &= nw.AddStation(station2);
+    BOOST_REQUIRE(ok);
+
+    /* Add lines
+       line0 route0: 0 ---> 1 ---> 2
+       line1 route1: 2 ---> 1 */
+    Route route0 {
+        "route_000",
+        "inbound",
+        "line_000",
+        "station_000",
+        "station_002",
+        {"station_000", "station_001", "station_002"}
+    };
+    Route route1 {
+        "route_001",
+        "inbound",
+        "line_001",
+        "station_002",
+        "station_001",
+        {"station_002", "station_001"}
+    };
+    Line line0 {
+        "line_000",
+        "Line Name 0",
+        {route0},
+    };
+    Line line1 {
+        "line_001",
+        "Line Name 1",
+        {route1},
+    };
+    ok &= nw.AddLine(line0);
+    ok &= nw.AddLine(line1);
+    BOOST_REQUIRE(ok);
+
+    /* Travel time is the same in both directions and for all routes */
+    ok = nw.SetTravelTime("station_000", "station_001", 1);
+    BOOST_REQUIRE(ok);
+    ok = nw.SetTravelTime("station_002", "station_001", 2);
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime("station_000", "station_001"), 1);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime("station_001", "station_000"), 1);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime("station_001", "station_002"), 2);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime("station_002", "station_001"), 2);
+
+    /* Non-adjacent stations */
+    ok = nw.SetTravelTime("station_000", "station_002", 3);
+    BOOST_CHECK(!ok);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime("station_000", "station_002"), 0);
+
+    /* Cumulative travel time along a route */
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_000", "station_002"), 3
+    );
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_001", "station_002"), 2
+    );
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_002", "station_000"), 0
+    );
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_001", "route_000", "station_000", "station_002"), 0
+    );
+}
+
+BOOST_AUTO_TEST_CASE(keep_travel_time_when_adding_lines)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+
+    /* Add stations */
+    Station station0 {
+        "station_000",
+        "Station Name 0"
+    };
+    Station station1 {
+        "station_001",
+        "Station Name 1"
+    };
+    Station station2 {
+        "station_002",
+        "Station Name 2"
+    };
+    ok &= nw.AddStation(station0);
+    ok &= nw.AddStation(station1);
+    BOOST_REQUIRE(ok);
+
+    Route route0 {
+        "route_000",
+        "inbound",
+        "line_000",
+        "station_000",
+        "station_001",
+        {"station_000", "station_001"}
+    };
+    Line line0 {
+        "line_000",
+        "Line Name 0",
+        {route0},
+    };
+    ok = nw.AddLine(line0);
+    BOOST_REQUIRE(ok);
+    ok = nw.SetTravelTime("station_000", "station_001", 5);
+    BOOST_REQUIRE(ok);
+
+    /* Adding a station and a line rebuilds the adjacency */
+    ok = nw.AddStation(station2);
+    BOOST_REQUIRE(ok);
+    Route route1 {
+        "route_001",
+        "inbound",
+        "line_001",
+        "station_001",
+        "station_002",
+        {"station_001", "station_002"}
+    };
+    Line line1 {
+        "line_001",
+        "Line Name 1",
+        {route1},
+    };
+    ok = nw.AddLine(line1);
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime("station_000", "station_001"), 5);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime("station_001", "station_002"), 0);
+}
+
+BOOST_AUTO_TEST_CASE(update_route_travel_time)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+
+    /* Add stations */
+    for (const auto& id: {"station_000", "station_001", "station_002", "station_003"})
+    {
+        ok &= nw.AddStation({id, "Station Name"});
+    }
+    BOOST_REQUIRE(ok);
+
+    /* Add lines sharing the 1 -> 2 hop
+       line0 route0: 0 ---> 1 ---> 2 ---> 3
+       line1 route1: 1 ---> 2 */
+    Route route0 {
+        "route_000",
+        "inbound",
+        "line_000",
+        "station_000",
+        "station_003",
+        {"station_000", "station_001", "station_002", "station_003"}
+    };
+    Route route1 {
+        "route_001",
+        "inbound",
+        "line_001",
+        "station_001",
+        "station_002",
+        {"station_001", "station_002"}
+    };
+    ok &= nw.AddLine({"line_000", "Line Name 0", {route0}});
+    ok &= nw.AddLine({"line_001", "Line Name 1", {route1}});
+    BOOST_REQUIRE(ok);
+
+    ok &= nw.SetTravelTime("station_000", "station_001", 1);
+    ok &= nw.SetTravelTime("station_001", "station_002", 2);
+    ok &= nw.SetTravelTime("station_002", "station_003", 3);
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_000", "station_003"), 6
+    );
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_001", "station_003"), 5
+    );
+
+    /* Lowering a shared hop updates every route going through it */
+    ok = nw.SetTravelTime("station_002", "station_001", 1);
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_000", "station_003"), 5
+    );
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_002", "station_003"), 3
+    );
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_001", "route_001", "station_001", "station_002"), 1
+    );
+}
+
+BOOST_AUTO_TEST_CASE(loop_route)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+
+    /* Add stations */
+    for (const auto& id: {"station_000", "station_001", "station_002", "station_003"})
+    {
+        ok &= nw.AddStation({id, "Station Name"});
+    }
+    BOOST_REQUIRE(ok);
+
+    /* The route goes through station 0 twice
+       line0 route0: 0 ---> 1 ---> 2 ---> 0 ---> 3 */
+    Route route0 {
+        "route_000",
+        "inbound",
+        "line_000",
+        "station_000",
+        "station_003",
+        {"station_000", "station_001", "station_002", "station_000", "station_003"}
+    };
+    ok &= nw.AddLine({"line_000", "Line Name 0", {route0}});
+    BOOST_REQUIRE(ok);
+
+    /* Setting the hop that leaves the second stop at station 0 only shifts
+       the stops after it */
+    ok &= nw.SetTravelTime("station_000", "station_001", 1);
+    ok &= nw.SetTravelTime("station_001", "station_002", 2);
+    ok &= nw.SetTravelTime("station_002", "station_000", 4);
+    ok &= nw.SetTravelTime("station_000", "station_003", 8);
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_000", "station_001"), 1
+    );
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_001", "station_002"), 2
+    );
+
+    /* Rides from or to station 0 take its closest stop */
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_000", "station_003"), 8
+    );
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_001", "station_000"), 6
+    );
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_000", "station_002"), 3
+    );
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_003", "station_000"), 0
+    );
+
+    /* Changing the first hop shifts both stops that follow it */
+    ok = nw.SetTravelTime("station_001", "station_000", 3);
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_001", "station_003"), 14
+    );
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_000", "station_003"), 8
+    );
+}
+
+BOOST_AUTO_TEST_CASE(long_route)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+
+    /* Enough stops for the stop position table of the route to have
+       collisions. The last station is not on the route */
+    const size_t nStops {300};
+    std::vector<Id> stops {};
+    for (size_t stop {0}; stop <= nStops; ++stop)
+    {
+        std::stringstream id {};
+        id << "station_" << stop;
+        stops.push_back(id.str());
+        ok &= nw.AddStation({stops.back(), "Station Name"});
+    }
+    BOOST_REQUIRE(ok);
+    Route route0 {
+        "route_000",
+        "inbound",
+        "line_000",
+        stops.front(),
+        stops[nStops - 1],
+        std::vector<Id>(stops.begin(), stops.begin() + nStops)
+    };
+    ok &= nw.AddLine({"line_000", "Line Name 0", {route0}});
+    for (size_t stop {0}; stop + 1 < nStops; ++stop)
+    {
+        ok &= nw.SetTravelTime(stops[stop], stops[stop + 1], static_cast<unsigned int>(stop + 1));
+    }
+    BOOST_REQUIRE(ok);
+
+    /* Hop i takes i + 1 minutes */
+    const auto route {nw.GetRouteHandle("line_000", "route_000")};
+    auto elapsed {[](size_t stop) {
+        return static_cast<unsigned int>(stop * (stop + 1) / 2);
+    }};
+    for (size_t stopA {0}; stopA < nStops; ++stopA)
+    {
+        const auto stationA {nw.GetStationHandle(stops[stopA])};
+        for (size_t stopB {0}; stopB < nStops; ++stopB)
+        {
+            const auto expected {stopA < stopB ? elapsed(stopB) - elapsed(stopA) : 0};
+            BOOST_REQUIRE_EQUAL(
+                nw.GetTravelTime(route, stationA, nw.GetStationHandle(stops[stopB])),
+                expected
+            );
+        }
+    }
+    const auto notServed {nw.GetStationHandle(stops[nStops])};
+    BOOST_CHECK_EQUAL(nw.GetTravelTime(route, nw.GetStationHandle(stops[0]), notServed), 0);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime(route, notServed, nw.GetStationHandle(stops[0])), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* TravelTime */
+
+BOOST_AUTO_TEST_SUITE(Handles);
+
+BOOST_AUTO_TEST_CASE(basic)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+
+    /* Add stations */
+    Station station0 {
+        "station_000",
+        "Station Name 0"
+    };
+    Station station1 {
+        "station_001",
+        "Station Name 1"
+    };
+    ok &= nw.AddStation(station0);
+    ok &= nw.AddStation(station1);
+    BOOST_REQUIRE(ok);
+
+    /* Add line with the one route
+       route: 0 ---> 1 */
+    Route route {
+        "route_000",
+        "inbound",
+        "line_000",
+        "station_000",
+        "station_001",
+        {"station_000", "station_001"}
+    };
+    Line line {
+        "line_000",
+        "Line Name",
+        {route},
+    };
+    ok = nw.AddLine(line);
+    BOOST_REQUIRE(ok);
+    ok = nw.SetTravelTime("station_000", "station_001", 4);
+    BOOST_REQUIRE(ok);
+
+    /* Resolve handles once */
+    StationHandle handle0 {nw.GetStationHandle("station_000")};
+    StationHandle handle1 {nw.GetStationHandle("station_001")};
+    RouteHandle routeHandle {nw.GetRouteHandle("line_000", "route_000")};
+    BOOST_REQUIRE(handle0 != kInvalidHandle);
+    BOOST_REQUIRE(handle1 != kInvalidHandle);
+    BOOST_REQUIRE(routeHandle != kInvalidHandle);
+    BOOST_CHECK_EQUAL(nw.GetStationId(handle1), "station_001");
+    BOOST_CHECK_EQUAL(nw.GetRouteId(routeHandle), "route_000");
+    BOOST_CHECK_EQUAL(nw.GetStationHandle("station_002"), kInvalidHandle);
+    BOOST_CHECK_EQUAL(nw.GetRouteHandle("line_001", "route_000"), kInvalidHandle);
+
+    /* Handle-based queries match the string-based ones */
+    ok = nw.RecordPassengerEvent(handle0, PassengerEvent::Type::In);
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount(handle0), 1);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_000"), 1);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime(handle1, handle0), 4);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime(routeHandle, handle0, handle1), 4);
+
+    auto routes {nw.GetRoutesServingStation(handle1)};
+    BOOST_REQUIRE_EQUAL(routes.size(), 1);
+    BOOST_CHECK_EQUAL(routes[0], routeHandle);
+
+    /* Invalid handles */
+    ok = nw.RecordPassengerEvent(kInvalidHandle, PassengerEvent::Type::In);
+    BOOST_CHECK(!ok);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime(kInvalidHandle, handle0), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* Handles */
+
+BOOST_AUTO_TEST_SUITE(GetFastestItinerary);
+
+BOOST_AUTO_TEST_CASE(fastest)
+{
+    auto nw {MakeItineraryNetwork()};
+
+    /* Without a penalty, changing line is faster */
+    auto itinerary {nw.GetFastestItinerary("station_000", "station_003")};
+    BOOST_REQUIRE_EQUAL(itinerary.legs.size(), 2);
+    BOOST_CHECK_EQUAL(itinerary.travelTime, 3);
+    BOOST_CHECK_EQUAL(itinerary.cost, 3);
+    BOOST_CHECK_EQUAL(nw.GetRouteId(itinerary.legs[0].route), "route_000");
+    BOOST_CHECK_EQUAL(nw.GetLineId(itinerary.legs[0].line), "line_000");
+    BOOST_CHECK_EQUAL(nw.GetStationId(itinerary.legs[0].boardStation), "station_000");
+    BOOST_CHECK_EQUAL(nw.GetStationId(itinerary.legs[0].alightStation), "station_002");
+    BOOST_CHECK_EQUAL(itinerary.legs[0].travelTime, 2);
+    BOOST_CHECK_EQUAL(nw.GetRouteId(itinerary.legs[1].route), "route_001");
+    BOOST_CHECK_EQUAL(nw.GetStationId(itinerary.legs[1].boardStation), "station_002");
+    BOOST_CHECK_EQUAL(nw.GetStationId(itinerary.legs[1].alightStation), "station_003");
+}
+
+BOOST_AUTO_TEST_CASE(line_change_penalty)
+{
+    auto nw {MakeItineraryNetwork()};
+
+    /* With a high penalty, staying on one line is better */
+    ItineraryOptions options {};
+    options.lineChangePenalty = 5;
+    auto itinerary {nw.GetFastestItinerary("station_000", "station_003", options)};
+    BOOST_REQUIRE_EQUAL(itinerary.legs.size(), 1);
+    BOOST_CHECK_EQUAL(nw.GetRouteId(itinerary.legs[0].route), "route_002");
+    BOOST_CHECK_EQUAL(itinerary.travelTime, 5);
+    BOOST_CHECK_EQUAL(itinerary.cost, 5);
+
+    /* A small penalty is paid but does not change the result */
+    options.lineChangePenalty = 1;
+    bool ok {nw.GetFastestItinerary(
+        nw.GetStationHandle("station_000"),
+        nw.GetStationHandle("station_003"),
+        itinerary,
+        options
+    )};
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(itinerary.legs.size(), 2);
+    BOOST_CHECK_EQUAL(itinerary.travelTime, 3);
+    BOOST_CHECK_EQUAL(itinerary.cost, 4);
+}
+
+BOOST_AUTO_TEST_CASE(loop_route)
+{
+    TransportNetwork nw {};
+    bool ok {true};
+    for (const auto& id: {"station_000", "station_001", "station_002"})
+    {
+        ok &= nw.AddStation({id, "Station Name"});
+    }
+    BOOST_REQUIRE(ok);
+
+    /* line0 route0: 0 ---> 1 ---> 2 ---> 0 */
+    Route route0 {
+        "route_000",
+        "inbound",
+        "line_000",
+        "station_000",
+        "station_000",
+        {"station_000", "station_001", "station_002", "station_000"}
+    };
+    ok &= nw.AddLine({"line_000", "Line Name 0", {route0}});
+    ok &= nw.SetTravelTime("station_000", "station_001", 1);
+    ok &= nw.SetTravelTime("station_001", "station_002", 2);
+    ok &= nw.SetTravelTime("station_002", "station_000", 3);
+    BOOST_REQUIRE(ok);
+
+    /* 2 -> 1 rides to the terminus, then starts the loop again */
+    auto itinerary {nw.GetFastestItinerary("station_002", "station_001")};
+    BOOST_REQUIRE_EQUAL(itinerary.legs.size(), 2);
+    BOOST_CHECK_EQUAL(nw.GetStationId(itinerary.legs[0].boardStation), "station_002");
+    BOOST_CHECK_EQUAL(nw.GetStationId(itinerary.legs[0].alightStation), "station_000");
+    BOOST_CHECK_EQUAL(itinerary.legs[0].travelTime, 3);
+    BOOST_CHECK_EQUAL(nw.GetStationId(itinerary.legs[1].boardStation), "station_000");
+    BOOST_CHECK_EQUAL(nw.GetStationId(itinerary.legs[1].alightStation), "station_001");
+    BOOST_CHECK_EQUAL(itinerary.legs[1].travelTime, 1);
+    BOOST_CHECK_EQUAL(itinerary.travelTime, 4);
+    BOOST_CHECK_EQUAL(itinerary.cost, itinerary.travelTime);
+}
+
+BOOST_AUTO_TEST_CASE(no_itinerary)
+{
+    auto nw {MakeItineraryNetwork()};
+    Itinerary itinerary {};
+
+    /* Routes only go one way */
+    bool ok {nw.GetFastestItinerary(
+        nw.GetStationHandle("station_003"),
+        nw.GetStationHandle("station_000"),
+        itinerary
+    )};
+    BOOST_CHECK(!ok);
+    BOOST_CHECK(itinerary.legs.empty());
+
+    /* Unknown station */
+    ok = nw.GetFastestItinerary(kInvalidHandle, nw.GetStationHandle("station_000"), itinerary);
+    BOOST_CHECK(!ok);
+
+    /* Same station */
+    const auto station {nw.GetStationHandle("station_001")};
+    ok = nw.GetFastestItinerary(station, station, itinerary);
+    BOOST_CHECK(ok);
+    BOOST_CHECK(itinerary.legs.empty());
+}
+
+BOOST_AUTO_TEST_CASE(avoid_crowding)
+{
+    auto nw {MakeItineraryNetwork()};
+    const auto station1 {nw.GetStationHandle("station_001")};
+
+    /* 10 passengers at station 1, one penalty unit every 2 passengers */
+    for (size_t idx {0}; idx < 10; ++idx)
+    {
+        nw.RecordPassengerEvent(station1, PassengerEvent::Type::In);
+    }
+    BOOST_CHECK_EQUAL(nw.GetCrowdingPenalty(station1), 0);
+    nw.SetCrowdingModel(CrowdingModel {0, 2, 100});
+    BOOST_CHECK_EQUAL(nw.GetCrowdingPenalty(station1), 5);
+
+    /* Crowding is only considered on request */
+    ItineraryOptions options {};
+    auto itinerary {nw.GetFastestItinerary("station_000", "station_003", options)};
+    BOOST_REQUIRE_EQUAL(itinerary.legs.size(), 2);
+
+    /* Going through station 1 now costs 3 + 5, the other line 5 */
+    options.avoidCrowding = true;
+    itinerary = nw.GetFastestItinerary("station_000", "station_003", options);
+    BOOST_REQUIRE_EQUAL(itinerary.legs.size(), 1);
+    BOOST_CHECK_EQUAL(nw.GetRouteId(itinerary.legs[0].route), "route_002");
+    BOOST_CHECK_EQUAL(itinerary.cost, 5);
+
+    /* The penalty follows the passenger count */
+    for (size_t idx {0}; idx < 8; ++idx)
+    {
+        nw.RecordPassengerEvent(station1, PassengerEvent::Type::Out);
+    }
+    BOOST_CHECK_EQUAL(nw.GetCrowdingPenalty(station1), 1);
+    itinerary = nw.GetFastestItinerary("station_000", "station_003", options);
+    BOOST_REQUIRE_EQUAL(itinerary.legs.size(), 2);
+    BOOST_CHECK_EQUAL(itinerary.travelTime, 3);
+    BOOST_CHECK_EQUAL(itinerary.cost, 4);
+
+    /* The penalty is capped */
+    nw.SetCrowdingModel(CrowdingModel {0, 1, 3});
+    for (size_t idx {0}; idx < 10; ++idx)
+    {
+        nw.RecordPassengerEvent(station1, PassengerEvent::Type::In);
+    }
+    BOOST_CHECK_EQUAL(nw.GetCrowdingPenalty(station1), 3);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_with_events)
+{
+    auto nw {MakeItineraryNetwork()};
+    nw.SetCrowdingModel(CrowdingModel {0, 10, 100000});
+    const auto station1 {nw.GetStationHandle("station_001")};
+    const auto station4 {nw.GetStationHandle("station_004")};
+
+    /* Queries run while events are being recorded */
+    const size_t nEvents {200000};
+    std::thread recorder {[&]() {
+        for (size_t idx {0}; idx < nEvents; ++idx)
+        {
+            nw.RecordPassengerEvent(idx % 2 ? station1 : station4, PassengerEvent::Type::In);
+        }
+    }};
+    ItineraryOptions options {};
+    options.avoidCrowding = true;
+    Itinerary itinerary {};
+    bool ok {true};
+    for (size_t idx {0}; idx < 1000; ++idx)
+    {
+        ok &= nw.GetFastestItinerary(
+            nw.GetStationHandle("station_000"),
+            nw.GetStationHandle("station_003"),
+            itinerary,
+            options
+        );
+    }
+    recorder.join();
+    BOOST_CHECK(ok);
+
+    /* The cached penalties caught up with the final counts */
+    BOOST_CHECK_EQUAL(nw.GetCrowdingPenalty(station1), nEvents / 2 / 10);
+    BOOST_CHECK_EQUAL(nw.GetCrowdingPenalty(station4), nEvents / 2 / 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* GetFastestItinerary */
+
+BOOST_AUTO_TEST_SUITE(PrecomputeTravelTimes);
+
+/* Compare the repaired matrix with one computed from scratch */
+static void CheckSameTravelTimes (
+    const TransportNetwork& nw
+)
+{
+    auto expected {nw};
+    expected.PrecomputeTravelTimes(1);
+    const auto nStations {static_cast<StationHandle>(nw.GetStationCount())};
+    for (StationHandle from {0}; from < nStations; ++from)
+    {
+        for (StationHandle to {0}; to < nStations; ++to)
+        {
+            BOOST_CHECK_EQUAL(
+                nw.GetShortestTravelTime(from, to),
+                expected.GetShortestTravelTime(from, to)
+            );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(basic)
+{
+    auto nw {MakeItineraryNetwork()};
+    const auto station0 {nw.GetStationHandle("station_000")};
+    const auto station2 {nw.GetStationHandle("station_002")};
+    const auto station3 {nw.GetStationHandle("station_003")};
+
+    /* Nothing before precomputing */
+    BOOST_CHECK_EQUAL(nw.GetShortestTravelTime(station0, station3), TransportNetwork::kUnreachable);
+
+    nw.PrecomputeTravelTimes(4);
+    BOOST_CHECK_EQUAL(nw.GetShortestTravelTime(station0, station0), 0);
+    BOOST_CHECK_EQUAL(nw.GetShortestTravelTime(station0, station2), 2);
+    BOOST_CHECK_EQUAL(nw.GetShortestTravelTime(station0, station3), 3);
+    BOOST_CHECK_EQUAL(nw.GetShortestTravelTime(station3, station0), TransportNetwork::kUnreachable);
+    BOOST_CHECK_EQUAL(nw.GetShortestTravelTime(kInvalidHandle, station0), TransportNetwork::kUnreachable);
+
+    /* Adding a station discards the matrix */
+    bool ok {nw.AddStation({"station_005", "Station Name"})};
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(nw.GetShortestTravelTime(station0, station3), TransportNetwork::kUnreachable);
+}
+
+BOOST_AUTO_TEST_CASE(repair)
+{
+    auto nw {MakeItineraryNetwork()};
+    nw.PrecomputeTravelTimes();
+    const auto station0 {nw.GetStationHandle("station_000")};
+    const auto station3 {nw.GetStationHandle("station_003")};
+
+    /* Longer edge on the shortest path: 0 -> 4 -> 3 becomes faster */
+    bool ok {nw.SetTravelTime("station_001", "station_002", 10)};
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(nw.GetShortestTravelTime(station0, station3), 5);
+    CheckSameTravelTimes(nw);
+
+    /* Shorter edge off the shortest path */
+    ok = nw.SetTravelTime("station_000", "station_004", 1);
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(nw.GetShortestTravelTime(station0, station3), 3);
+    CheckSameTravelTimes(nw);
+
+    /* Back to the original travel time */
+    ok = nw.SetTravelTime("station_001", "station_002", 1);
+    BOOST_REQUIRE(ok);
+    ok = nw.SetTravelTime("station_000", "station_004", 3);
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(nw.GetShortestTravelTime(station0, station3), 3);
+    CheckSameTravelTimes(nw);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* PrecomputeTravelTimes */
+
+BOOST_AUTO_TEST_SUITE(FromJson);
+
+BOOST_AUTO_TEST_CASE(network_layout)
+{
+    TransportNetwork nw {};
+    bool ok {nw.FromJson(std::filesystem::path {TESTS_NETWORK_LAYOUT_JSON})};
+    BOOST_REQUIRE(ok);
+
+    BOOST_CHECK_EQUAL(nw.GetStationCount(), 426);
+    BOOST_CHECK(nw.GetLineHandle("line_012") != kInvalidHandle);
+    BOOST_CHECK(nw.GetRouteHandle("line_012", "route_095") != kInvalidHandle);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime("station_000", "station_001"), 2);
+    BOOST_CHECK_EQUAL(nw.GetTravelTime("station_425", "station_392"), 6);
+
+    auto routes {nw.GetRoutesServingStation("station_012")};
+    std::sort(routes.begin(), routes.end());
+    BOOST_REQUIRE_EQUAL(routes.size(), 2);
+    BOOST_CHECK_EQUAL(routes[0], "route_000");
+    BOOST_CHECK_EQUAL(routes[1], "route_001");
+}
+
+BOOST_AUTO_TEST_CASE(small_layout)
+{
+    std::stringstream layout {R"({
+        "lines": [{
+            "line_id": "line_000",
+            "name": "Line Name",
+            "routes": [{
+                "line_id": "line_000",
+                "route_id": "route_000",
+                "direction": "inbound",
+                "start_station_id": "station_000",
+                "end_station_id": "station_002",
+                "route_stops": ["station_000", "station_001", "station_002"]
+            }],
+            "stations": ["station_000", "station_001", "station_002"]
+        }],
+        "stations": [
+            {"station_id": "station_000", "name": "Station Name 0"},
+            {"station_id": "station_001", "name": "Station Name 1"},
+            {"station_id": "station_002", "name": "Station Name 2"}
+        ],
+        "travel_times": [
+            {"start_station_id": "station_000", "end_station_id": "station_001",
+             "line_id": "line_000", "route_id": "route_000", "travel_time": 1},
+            {"start_station_id": "station_001", "end_station_id": "station_002",
+             "line_id": "line_000", "route_id": "route_000", "travel_time": 2}
+        ]
+    })"};
+    TransportNetwork nw {};
+    bool ok {nw.FromJson(layout)};
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(nw.GetStationCount(), 3);
+    BOOST_CHECK_EQUAL(
+        nw.GetTravelTime("line_000", "route_000", "station_000", "station_002"), 3
+    );
+}
+
+BOOST_AUTO_TEST_CASE(invalid_layout)
+{
+    TransportNetwork nw {};
+    bool ok {nw.AddStation({"station_000", "Station Name"})};
+    BOOST_REQUIRE(ok);
+
+    /* Invalid JSON */
+    std::stringstream badJson {R"({"stations": [{"station_id": "station_001")"};
+    ok = nw.FromJson(badJson);
+    BOOST_CHECK(!ok);
+
+    /* Valid JSON, but the route serves an unknown station */
+    std::stringstream badNetwork {R"({
+        "lines": [{
+            "line_id": "line_000",
+            "name": "Line Name",
+            "routes": [{
+                "line_id": "line_000",
+                "route_id": "route_000",
+                "direction": "inbound",
+                "start_station_id": "station_000",
+                "end_station_id": "station_001",
+                "route_stops": ["station_000", "station_001"]
+            }]
+        }],
+        "stations": [
+            {"station_id": "station_000", "name": "Station Name 0"}
+        ],
+        "travel_times": []
+    })"};
+    ok = nw.FromJson(badNetwork);
+    BOOST_CHECK(!ok);
+
+    /* Travel times that do not fit an unsigned int, or are not integers */
+    auto makeLayout {[](const std::string& travelTime) {
+        return std::stringstream {R"({
+            "lines": [{
+                "line_id": "line_001",
+                "name": "Line Name",
+                "routes": [{
+                    "line_id": "line_001",
+                    "route_id": "route_001",
+                    "direction": "inbound",
+                    "start_station_id": "station_001",
+                    "end_station_id": "station_002",
+                    "route_stops": ["station_001", "station_002"]
+                }]
+            }],
+            "stations": [
+                {"station_id": "station_001", "name": "Station Name 1"},
+                {"station_id": "station_002", "name": "Station Name 2"}
+            ],
+            "travel_times": [
+                {"start_station_id": "station_001", "end_station_id": "station_002",
+                 "travel_time": )" + travelTime + "}]}"};
+    }};
+    for (const std::string travelTime: {"4294967296", "9223372036854775808", "-1", "1.5", "\"1\""})
+    {
+        auto badTravelTime {makeLayout(travelTime)};
+        ok = nw.FromJson(badTravelTime);
+        BOOST_CHECK_MESSAGE(!ok, "travel_time: " << travelTime);
+    }
+    {
+        TransportNetwork maxNw {};
+        auto maxTravelTime {makeLayout("4294967295")};
+        ok = maxNw.FromJson(maxTravelTime);
+        BOOST_REQUIRE(ok);
+        BOOST_CHECK_EQUAL(maxNw.GetTravelTime("station_001", "station_002"), 4294967295u);
+    }
+
+    /* Missing file */
+    ok = nw.FromJson(std::filesystem::path {"does-not-exist.json"});
+    BOOST_CHECK(!ok);
+
+    /* The network was left untouched */
+    BOOST_CHECK_EQUAL(nw.GetStationCount(), 1);
+    BOOST_CHECK(nw.GetStationHandle("station_000") != kInvalidHandle);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* FromJson */
+
 BOOST_AUTO_TEST_SUITE_END();    /* class_TransportNetwork */
 BOOST_AUTO_TEST_SUITE_END();    /* network_monitor */
@@ -0,0 +1,237 @@
+#include "TransportNetwork.h"
+#include "VersionedTransportNetwork.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using NetworkMonitor::NetworkVersion;
+using NetworkMonitor::PassengerEvent;
+using NetworkMonitor::Station;
+using NetworkMonitor::TransportNetwork;
+using NetworkMonitor::VersionedTransportNetwork;
+
+/* Network with stations only, which is all passenger counts need */
+static TransportNetwork MakeStationNetwork (
+    const std::vector<std::string>& stations
+)
+{
+    TransportNetwork nw {};
+    for (const auto& id: stations)
+    {
+        nw.AddStation({id, "Station Name"});
+    }
+    return nw;
+}
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+BOOST_AUTO_TEST_SUITE(class_VersionedTransportNetwork);
+
+BOOST_AUTO_TEST_CASE(copy_is_independent)
+{
+    auto nw {MakeStationNetwork({"station_000"})};
+    auto copied {nw};
+    copied.RecordPassengerEvent({"station_000", PassengerEvent::Type::In});
+    copied.AddStation({"station_001", "Station Name"});
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_000"), 0);
+    BOOST_CHECK_EQUAL(nw.GetStationCount(), 1);
+    BOOST_CHECK_EQUAL(copied.GetPassengerCount("station_000"), 1);
+}
+
+BOOST_AUTO_TEST_CASE(publish)
+{
+    VersionedTransportNetwork versions {
+        MakeStationNetwork({"station_000", "station_001", "station_002"})
+    };
+    auto v1 {versions.Acquire()};
+    BOOST_CHECK_EQUAL(v1->GetVersion(), 1);
+    v1->RecordPassengerEvent({"station_000", PassengerEvent::Type::In});
+    v1->RecordPassengerEvent({"station_000", PassengerEvent::Type::In});
+    v1->RecordPassengerEvent({"station_001", PassengerEvent::Type::Out});
+    v1->RecordPassengerEvent({"station_002", PassengerEvent::Type::In});
+
+    /* The events recorded so far are carried over right away */
+    v1.reset();
+
+    /* The new layout drops station_002, adds station_003 and changes the
+       handles of the stations it keeps */
+    auto version {versions.Publish(
+        MakeStationNetwork({"station_003", "station_001", "station_000"})
+    )};
+    BOOST_CHECK_EQUAL(version, 2);
+
+    auto v2 {versions.Acquire()};
+    BOOST_CHECK_EQUAL(v2->GetVersion(), 2);
+    const auto& nw {v2->GetNetwork()};
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_000"), 2);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_001"), -1);
+    BOOST_CHECK_EQUAL(nw.GetPassengerCount("station_003"), 0);
+    BOOST_CHECK_EQUAL(nw.GetStationHandle("station_002"), NetworkMonitor::kInvalidHandle);
+}
+
+BOOST_AUTO_TEST_CASE(old_version_stays_valid)
+{
+    VersionedTransportNetwork versions {MakeStationNetwork({"station_000"})};
+    auto v1 {versions.Acquire()};
+    v1->RecordPassengerEvent({"station_000", PassengerEvent::Type::In});
+
+    /* Publish does not wait for our reference */
+    BOOST_CHECK_EQUAL(versions.Publish(MakeStationNetwork({"station_000"})), 2);
+    auto v2 {versions.Acquire()};
+    BOOST_CHECK_EQUAL(v2->GetNetwork().GetPassengerCount("station_000"), 1);
+
+    /* Events recorded on the old version reach the new one once we let go of
+       the old version */
+    BOOST_CHECK_EQUAL(v1->GetNetwork().GetPassengerCount("station_000"), 1);
+    v1->RecordPassengerEvent({"station_000", PassengerEvent::Type::In});
+    v1.reset();
+    BOOST_CHECK_EQUAL(v2->GetNetwork().GetPassengerCount("station_000"), 2);
+}
+
+BOOST_AUTO_TEST_CASE(stale_reader_across_versions)
+{
+    VersionedTransportNetwork versions {MakeStationNetwork({"station_000"})};
+    auto v1 {versions.Acquire()};
+
+    /* A reader that caches an old version blocks neither publishes nor
+       reloads */
+    versions.Publish(MakeStationNetwork({"station_000"}));
+    auto reload {versions.ReloadAsync(std::filesystem::path {TESTS_NETWORK_LAYOUT_JSON})};
+    BOOST_REQUIRE(reload.get());
+    versions.Publish(MakeStationNetwork({"station_000"}));
+    BOOST_CHECK_EQUAL(versions.Acquire()->GetVersion(), 4);
+
+    /* Its late events go straight to the current version */
+    v1->RecordPassengerEvent({"station_000", PassengerEvent::Type::In});
+    v1.reset();
+    BOOST_CHECK_EQUAL(versions.Acquire()->GetNetwork().GetPassengerCount("station_000"), 1);
+}
+
+BOOST_AUTO_TEST_CASE(replaced_versions_are_released)
+{
+    VersionedTransportNetwork versions {MakeStationNetwork({"station_000"})};
+
+    /* The reader cache of this thread does not keep version 1 alive */
+    std::weak_ptr<const NetworkVersion> v1 {versions.Acquire()};
+    BOOST_CHECK(!v1.expired());
+    versions.Publish(MakeStationNetwork({"station_000"}));
+    BOOST_CHECK(v1.expired());
+
+    /* A reader still on version 2 does not keep version 3 alive */
+    auto v2 {versions.Acquire()};
+    std::weak_ptr<const NetworkVersion> v3 {};
+    versions.Publish(MakeStationNetwork({"station_000"}));
+    v3 = versions.Acquire();
+    versions.Publish(MakeStationNetwork({"station_000"}));
+    BOOST_CHECK(v3.expired());
+    BOOST_CHECK_EQUAL(versions.Acquire()->GetVersion(), 4);
+
+    /* Its late events reach version 4 */
+    v2->RecordPassengerEvent({"station_000", PassengerEvent::Type::In});
+    v2.reset();
+    BOOST_CHECK_EQUAL(versions.Acquire()->GetNetwork().GetPassengerCount("station_000"), 1);
+}
+
+BOOST_AUTO_TEST_CASE(acquire_per_holder)
+{
+    /* Each thread caches one version, it must never hand it out for
+       another holder */
+    VersionedTransportNetwork first {MakeStationNetwork({"station_000"})};
+    VersionedTransportNetwork second {MakeStationNetwork({"station_001"})};
+    second.Publish(MakeStationNetwork({"station_001"}));
+    for (int idx {0}; idx < 2; ++idx)
+    {
+        BOOST_CHECK_EQUAL(first.Acquire()->GetVersion(), 1);
+        BOOST_CHECK_EQUAL(second.Acquire()->GetVersion(), 2);
+    }
+
+    /* Repeated calls return the cached version until the next publish */
+    auto v1 {first.Acquire()};
+    BOOST_CHECK_EQUAL(first.Acquire(), v1);
+    first.Publish(MakeStationNetwork({"station_000"}));
+    BOOST_CHECK_EQUAL(first.Acquire()->GetVersion(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_publish)
+{
+    const std::vector<std::string> stations {"station_000", "station_001"};
+    VersionedTransportNetwork versions {MakeStationNetwork(stations)};
+
+    constexpr int nThreads {4};
+    constexpr int nEvents {20000};
+    std::atomic<bool> start {false};
+    std::vector<std::thread> readers {};
+    for (int thread {0}; thread < nThreads; ++thread)
+    {
+        readers.emplace_back([&versions, &start, &stations, thread]() {
+            while (!start)
+            {
+                std::this_thread::yield();
+            }
+            const PassengerEvent event {stations[thread % 2], PassengerEvent::Type::In};
+            for (int idx {0}; idx < nEvents; ++idx)
+            {
+                versions.Acquire()->RecordPassengerEvent(event);
+            }
+        });
+    }
+    start = true;
+    for (int reload {0}; reload < 10; ++reload)
+    {
+        versions.Publish(MakeStationNetwork(stations));
+    }
+    for (auto& reader: readers)
+    {
+        reader.join();
+    }
+
+    /* No event was lost across the reloads */
+    auto current {versions.Acquire()};
+    BOOST_CHECK_EQUAL(current->GetVersion(), 11);
+    BOOST_CHECK_EQUAL(
+        current->GetNetwork().GetPassengerCount("station_000")
+        + current->GetNetwork().GetPassengerCount("station_001"),
+        nThreads * nEvents
+    );
+}
+
+BOOST_AUTO_TEST_CASE(reload_async)
+{
+    VersionedTransportNetwork versions {};
+
+    auto reload {versions.ReloadAsync(std::filesystem::path {TESTS_NETWORK_LAYOUT_JSON})};
+    BOOST_REQUIRE(reload.get());
+    BOOST_CHECK_EQUAL(versions.Acquire()->GetVersion(), 2);
+    BOOST_CHECK_EQUAL(versions.Acquire()->GetNetwork().GetStationCount(), 426);
+
+    /* A bad layout leaves the current version in place */
+    reload = versions.ReloadAsync("does-not-exist.json");
+    BOOST_CHECK(!reload.get());
+    BOOST_CHECK_EQUAL(versions.Acquire()->GetVersion(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(reload_outlives_holder)
+{
+    std::future<bool> reload {};
+    std::shared_ptr<const NetworkVersion> v1 {};
+    {
+        VersionedTransportNetwork versions {MakeStationNetwork({"station_000"})};
+        v1 = versions.Acquire();
+        reload = versions.ReloadAsync(std::filesystem::path {TESTS_NETWORK_LAYOUT_JSON});
+    }
+    BOOST_CHECK(reload.get());
+
+    /* The reload finished on the state of the destroyed holder. The version
+       it replaced still releases cleanly */
+    v1->RecordPassengerEvent({"station_000", PassengerEvent::Type::In});
+    v1.reset();
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* class_VersionedTransportNetwork */
+BOOST_AUTO_TEST_SUITE_END();    /* network_monitor */
@@ -0,0 +1,311 @@
+#include "TestServer.h"
+#include "WebSocketClientPool.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using NetworkMonitor::TestServer;
+using NetworkMonitor::TestServerOptions;
+using NetworkMonitor::WebSocketClientPool;
+using NetworkMonitor::WebSocketPoolOptions;
+
+static TestServerOptions GetServerOptions()
+{
+    TestServerOptions options {};
+    options.certFile = TESTS_SERVER_CERT_PEM;
+    options.keyFile = TESTS_SERVER_KEY_PEM;
+    options.nThreads = 2;
+    return options;
+}
+
+/* Wait until `count` reaches `expected`, or give up after a few seconds */
+static bool WaitFor (
+    std::mutex& mutex,
+    std::condition_variable& cv,
+    const size_t& count,
+    size_t expected
+)
+{
+    std::unique_lock<std::mutex> lock {mutex};
+    return cv.wait_for(lock, std::chrono::seconds(10), [&count, expected]() {
+        return count >= expected;
+    });
+}
+
+BOOST_AUTO_TEST_SUITE(network_monitor);
+BOOST_AUTO_TEST_SUITE(class_WebSocketClientPool);
+
+BOOST_AUTO_TEST_CASE(subscribe_spread)
+{
+    TestServer server {GetServerOptions()};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+    WebSocketPoolOptions options {};
+    options.nConnections = 4;
+    options.nThreads = 3;
+    WebSocketClientPool pool {"localhost", "/echo", std::to_string(port), ctx, options};
+
+    /* Subscribing before Start queues the messages until each connection is
+       up. The echo server sends each subscription back on its connection */
+    const size_t nSubscriptions {8};
+    std::vector<size_t> assigned {};
+    for (size_t idx {0}; idx < nSubscriptions; ++idx)
+    {
+        const auto connection {pool.Subscribe("subscription " + std::to_string(idx))};
+        BOOST_REQUIRE(connection.has_value());
+        assigned.push_back(*connection);
+    }
+    BOOST_CHECK((assigned == std::vector<size_t> {0, 1, 2, 3, 0, 1, 2, 3}));
+
+    std::mutex mutex {};
+    std::condition_variable cv {};
+    size_t nReceived {0};
+    size_t nConnected {0};
+    bool sameConnection {true};
+    pool.Start(
+        [&](size_t, auto ec) {
+            std::lock_guard<std::mutex> lock {mutex};
+            nConnected += !ec;
+        },
+        [&](size_t connection, auto, std::string_view message) {
+            const auto idx {std::stoul(std::string {message.substr(message.find(' ') + 1)})};
+            std::lock_guard<std::mutex> lock {mutex};
+            sameConnection &= assigned[idx] == connection;
+            ++nReceived;
+            cv.notify_all();
+        }
+    );
+    BOOST_CHECK(WaitFor(mutex, cv, nReceived, nSubscriptions));
+    pool.Stop();
+
+    BOOST_CHECK_EQUAL(nConnected, options.nConnections);
+    BOOST_CHECK(sameConnection);
+
+    const auto stats {pool.GetStats()};
+    BOOST_CHECK_EQUAL(stats.nConnected, 0);
+    BOOST_CHECK_EQUAL(stats.messagesSent, nSubscriptions);
+    BOOST_CHECK_EQUAL(stats.messagesReceived, nSubscriptions);
+    BOOST_CHECK_EQUAL(stats.sendErrors, 0);
+    BOOST_REQUIRE_EQUAL(stats.connections.size(), options.nConnections);
+    for (const auto& connection: stats.connections)
+    {
+        BOOST_CHECK_EQUAL(connection.nSubscriptions, 2);
+        BOOST_CHECK_EQUAL(connection.messagesReceived, 2);
+    }
+
+    /* A stopped pool refuses new messages */
+    BOOST_CHECK(!pool.Subscribe("late").has_value());
+    BOOST_CHECK(!pool.Send(0, "late"));
+}
+
+BOOST_AUTO_TEST_CASE(callbacks_serialized_per_connection)
+{
+    TestServer server {GetServerOptions()};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+    WebSocketPoolOptions options {};
+    options.nConnections = 2;
+    options.nThreads = 4;
+    WebSocketClientPool pool {"localhost", "/echo", std::to_string(port), ctx, options};
+
+    /* More threads than connections: only the strands keep the callbacks of a
+       connection from overlapping */
+    const size_t nMessages {50};
+    std::vector<std::atomic<bool>> inCallback(options.nConnections);
+    std::atomic<bool> overlap {false};
+    std::mutex mutex {};
+    std::condition_variable cv {};
+    size_t nReceived {0};
+    pool.Start(
+        [&pool, nMessages](size_t connection, auto ec) {
+            for (size_t idx {0}; !ec && idx < nMessages; ++idx)
+            {
+                pool.Send(connection, "message " + std::to_string(idx));
+            }
+        },
+        [&](size_t connection, auto, std::string_view) {
+            if (inCallback[connection].exchange(true))
+            {
+                overlap = true;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            inCallback[connection] = false;
+
+            std::lock_guard<std::mutex> lock {mutex};
+            ++nReceived;
+            cv.notify_all();
+        }
+    );
+    BOOST_CHECK(WaitFor(mutex, cv, nReceived, nMessages * options.nConnections));
+    pool.Stop();
+
+    BOOST_CHECK(!overlap);
+    const auto stats {pool.GetStats()};
+    BOOST_CHECK_EQUAL(stats.messagesReceived, nMessages * options.nConnections);
+    BOOST_CHECK(stats.messagesPerSecond > 0);
+}
+
+BOOST_AUTO_TEST_CASE(stop_drains)
+{
+    TestServer server {GetServerOptions()};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+    WebSocketPoolOptions options {};
+    options.nConnections = 3;
+    WebSocketClientPool pool {"localhost", "/echo", std::to_string(port), ctx, options};
+
+    /* Stop as soon as the connections are up: everything queued by then is
+       still written before the connections close */
+    const size_t nMessages {200};
+    std::mutex mutex {};
+    std::condition_variable cv {};
+    size_t nConnected {0};
+    std::atomic<size_t> nSent {0};
+    pool.Start([&](size_t connection, auto ec) {
+        for (size_t idx {0}; !ec && idx < nMessages; ++idx)
+        {
+            pool.Send(connection, std::string(512, 'x'), [&nSent](auto ec) {
+                nSent += !ec;
+            });
+        }
+        std::lock_guard<std::mutex> lock {mutex};
+        nConnected += !ec;
+        cv.notify_all();
+    });
+    BOOST_REQUIRE(WaitFor(mutex, cv, nConnected, options.nConnections));
+    pool.Stop();
+
+    const auto stats {pool.GetStats()};
+    BOOST_CHECK_EQUAL(nSent, nMessages * options.nConnections);
+    BOOST_CHECK_EQUAL(stats.messagesSent, nMessages * options.nConnections);
+    BOOST_CHECK_EQUAL(stats.bytesSent, 512 * nMessages * options.nConnections);
+    BOOST_CHECK_EQUAL(stats.sendErrors, 0);
+}
+
+BOOST_AUTO_TEST_CASE(connect_failure)
+{
+    /* Grab a free port, then close it so that nobody listens on it */
+    std::string port {};
+    {
+        boost::asio::io_context ioc {};
+        boost::asio::ip::tcp::acceptor acceptor {
+            ioc, {boost::asio::ip::make_address("127.0.0.1"), 0}
+        };
+        port = std::to_string(acceptor.local_endpoint().port());
+    }
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    WebSocketPoolOptions options {};
+    options.nConnections = 2;
+    options.drainTimeout = std::chrono::milliseconds(500);
+    WebSocketClientPool pool {"127.0.0.1", "/echo", port, ctx, options};
+
+    std::mutex mutex {};
+    std::condition_variable cv {};
+    size_t nFailed {0};
+    boost::system::error_code subscribeError {};
+    pool.Subscribe("subscription", [&subscribeError](auto ec) {
+        subscribeError = ec;
+    });
+    pool.Start([&](size_t, auto ec) {
+        std::lock_guard<std::mutex> lock {mutex};
+        nFailed += !!ec;
+        cv.notify_all();
+    });
+    BOOST_CHECK(WaitFor(mutex, cv, nFailed, options.nConnections));
+
+    /* Connections that gave up take no subscriptions */
+    BOOST_CHECK(!pool.Subscribe("late").has_value());
+    pool.Stop();
+
+    BOOST_CHECK(subscribeError);
+    const auto stats {pool.GetStats()};
+    BOOST_CHECK_EQUAL(stats.nConnected, 0);
+    BOOST_CHECK_EQUAL(stats.sendErrors, 1);
+    for (const auto& connection: stats.connections)
+    {
+        BOOST_CHECK_EQUAL(connection.nSubscriptions, 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(reconnect_renews_subscriptions)
+{
+    TestServer server {GetServerOptions()};
+    const auto port {server.Start()};
+    BOOST_REQUIRE(port != 0);
+
+    boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+    ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+    WebSocketPoolOptions options {};
+    options.nConnections = 1;
+    options.reconnectOptions.enabled = true;
+    options.reconnectOptions.initialDelay = std::chrono::milliseconds(10);
+    WebSocketClientPool pool {"localhost", "/echo", std::to_string(port), ctx, options};
+
+    /* The echo server sends each subscription back, once per session */
+    std::mutex mutex {};
+    std::condition_variable cv {};
+    size_t nConnected {0};
+    size_t nReceived {0};
+    std::vector<std::string> received {};
+    pool.Subscribe("subscription 0");
+    pool.Start(
+        [&](size_t, auto ec) {
+            std::lock_guard<std::mutex> lock {mutex};
+            nConnected += !ec;
+            cv.notify_all();
+        },
+        [&](size_t, auto ec, std::string_view message) {
+            if (ec)
+                return;
+
+            std::lock_guard<std::mutex> lock {mutex};
+            received.emplace_back(message);
+            ++nReceived;
+            cv.notify_all();
+        }
+    );
+    BOOST_REQUIRE(WaitFor(mutex, cv, nReceived, 1));
+    pool.Subscribe("subscription 1");
+    BOOST_REQUIRE(WaitFor(mutex, cv, nReceived, 2));
+
+    /* Both subscriptions are renewed on the new session */
+    server.DropConnections();
+    BOOST_CHECK(WaitFor(mutex, cv, nConnected, 2));
+    BOOST_CHECK(WaitFor(mutex, cv, nReceived, 4));
+    pool.Stop();
+
+    BOOST_CHECK((received == std::vector<std::string> {
+        "subscription 0", "subscription 1", "subscription 0", "subscription 1"
+    }));
+    const auto stats {pool.GetStats()};
+    BOOST_CHECK_EQUAL(stats.reconnects, 1);
+    BOOST_REQUIRE_EQUAL(stats.connections.size(), 1);
+    BOOST_CHECK_EQUAL(stats.connections[0].nSubscriptions, 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END();    /* class_WebSocketClientPool */
+BOOST_AUTO_TEST_SUITE_END();    /* network_monitor */
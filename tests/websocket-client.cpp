@@ -4,16 +4,25 @@
  *         it is also a natural choice to make)
  */
 
+#include "TestServer.h"
 #include "WebSocketClient.h"
 
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <filesystem>
+#include <vector>
 
+using NetworkMonitor::ReconnectOptions;
+using NetworkMonitor::SendQueueOptions;
+using NetworkMonitor::StreamOptions;
+using NetworkMonitor::TestServer;
+using NetworkMonitor::TestServerOptions;
 using NetworkMonitor::WebSocketClient;
 
 BOOST_AUTO_TEST_SUITE(network_monitor);
@@ -111,6 +120,517 @@ BOOST_AUTO_TEST_CASE(test_class_WebSocketClient)
    BOOST_CHECK_EQUAL(message, echo);
 }
 
+BOOST_AUTO_TEST_CASE(test_message_view)
+{
+   TestServerOptions serverOptions {};
+   serverOptions.certFile = TESTS_SERVER_CERT_PEM;
+   serverOptions.keyFile = TESTS_SERVER_KEY_PEM;
+   TestServer server {serverOptions};
+   const auto port {server.Start()};
+   BOOST_REQUIRE(port != 0);
+
+   const std::string message {"Hello WebSocket"};
+
+   boost::asio::io_context ioc {};
+   boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+   ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+   WebSocketClient client {"localhost", "/echo", std::to_string(port), ioc, ctx};
+   client.ReserveReadBuffer(4096);
+
+   bool connected {false};
+   bool messageReceived {false};
+   std::string echo {};
+
+   auto onConnect{[&client, &connected, &message](auto ec) {
+      connected = !ec;
+      if (!ec)
+      {
+         client.Send(message);
+      }
+   }};
+
+   /* The view is only valid during the callback: copy it */
+   auto onReceive{[&client, &messageReceived, &echo](auto ec, std::string_view received) {
+      messageReceived = !ec;
+      echo = std::string {received};
+      client.Close();
+   }};
+
+   client.ConnectWithMessageView(onConnect, onReceive);
+   ioc.run();
+
+   BOOST_CHECK(connected);
+   BOOST_CHECK(messageReceived);
+   BOOST_CHECK_EQUAL(message, echo);
+}
+
+BOOST_AUTO_TEST_CASE(test_send_queue)
+{
+   TestServerOptions serverOptions {};
+   serverOptions.certFile = TESTS_SERVER_CERT_PEM;
+   serverOptions.keyFile = TESTS_SERVER_KEY_PEM;
+   TestServer server {serverOptions};
+   const auto port {server.Start()};
+   BOOST_REQUIRE(port != 0);
+
+   const int nMessages {20};
+
+   boost::asio::io_context ioc {};
+   boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+   ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+   /* Coalesce everything: the echo server sends back fewer, longer messages */
+   SendQueueOptions options {};
+   options.coalesce = true;
+   WebSocketClient client {"localhost", "/echo", std::to_string(port), ioc, ctx, options};
+
+   bool connected {false};
+   int nSent {0};
+   std::string expected {};
+   std::string echo {};
+
+   auto onConnect{[&client, &connected, &nSent, &expected, nMessages](auto ec) {
+      connected = !ec;
+      if (ec)
+      {
+         return;
+      }
+
+      /* Queue all messages at once, without waiting for the previous send */
+      for (int idx {0}; idx < nMessages; ++idx)
+      {
+         auto message {"message " + std::to_string(idx) + ";"};
+         expected += message;
+         client.Send(std::move(message), [&nSent](auto ec) {
+            nSent += !ec;
+         });
+      }
+   }};
+
+   auto onReceive{[&client, &echo, &expected](auto ec, auto received) {
+      echo += received;
+      if (ec || echo.size() >= expected.size())
+      {
+         client.Close();
+      }
+   }};
+
+   client.Connect(onConnect, onReceive);
+   ioc.run();
+
+   BOOST_CHECK(connected);
+   BOOST_CHECK_EQUAL(nSent, nMessages);
+   BOOST_CHECK_EQUAL(echo, expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_send_queue_high_water_mark)
+{
+   boost::asio::io_context ioc {};
+   boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+
+   SendQueueOptions options {};
+   options.highWaterMark = 8;
+   WebSocketClient client {"localhost", "/", "443", ioc, ctx, options};
+
+   /* We never connect: the first message is queued and fails when written,
+      the second one does not fit in the queue */
+   boost::system::error_code firstError {};
+   boost::system::error_code secondError {};
+   client.Send("12345678", [&firstError](auto ec) {
+      firstError = ec;
+   });
+   client.Send("9", [&secondError](auto ec) {
+      secondError = ec;
+   });
+   ioc.run();
+
+   BOOST_CHECK(firstError);
+   BOOST_CHECK(firstError != boost::asio::error::no_buffer_space);
+   BOOST_CHECK_EQUAL(secondError, boost::asio::error::no_buffer_space);
+}
+
+BOOST_AUTO_TEST_CASE(test_local_echo)
+{
+   /* Local TLS echo server, signed with the test certificate */
+   TestServerOptions options {};
+   options.certFile = TESTS_SERVER_CERT_PEM;
+   options.keyFile = TESTS_SERVER_KEY_PEM;
+   TestServer server {options};
+   const auto port {server.Start()};
+   BOOST_REQUIRE(port != 0);
+
+   const int nMessages {100};
+
+   boost::asio::io_context ioc {};
+   boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+   ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+   WebSocketClient client {"localhost", "/echo", std::to_string(port), ioc, ctx};
+
+   bool connected {false};
+   bool disconnected {false};
+   std::string expected {};
+   std::string echo {};
+   int nReceived {0};
+
+   auto onConnect{[&client, &connected, &expected, nMessages](auto ec) {
+      connected = !ec;
+      if (ec)
+      {
+         return;
+      }
+      for (int idx {0}; idx < nMessages; ++idx)
+      {
+         auto message {"message " + std::to_string(idx) + ";"};
+         expected += message;
+         client.Send(std::move(message));
+      }
+   }};
+
+   /* The server echoes each message on its own, in order */
+   auto onReceive{[&client, &echo, &nReceived, &disconnected, nMessages](auto ec, auto received) {
+      echo += received;
+      if (ec || ++nReceived == nMessages)
+      {
+         client.Close([&disconnected](auto ec) {
+            disconnected = !ec;
+         });
+      }
+   }};
+
+   client.Connect(onConnect, onReceive);
+   ioc.run();
+
+   BOOST_CHECK(connected);
+   BOOST_CHECK(disconnected);
+   BOOST_CHECK_EQUAL(nReceived, nMessages);
+   BOOST_CHECK_EQUAL(echo, expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_local_close_while_sending)
+{
+   TestServerOptions options {};
+   options.certFile = TESTS_SERVER_CERT_PEM;
+   options.keyFile = TESTS_SERVER_KEY_PEM;
+   TestServer server {options};
+   const auto port {server.Start()};
+   BOOST_REQUIRE(port != 0);
+
+   const size_t nMessages {10};
+
+   boost::asio::io_context ioc {};
+   boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+   ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+   WebSocketClient client {"localhost", "/echo", std::to_string(port), ioc, ctx};
+
+   /* The first message is being written when Close runs: it completes, then
+      the close frame goes out and the rest of the queue is aborted */
+   std::vector<boost::system::error_code> sendErrors {};
+   bool closed {false};
+   auto onConnect {[&](auto ec) {
+      BOOST_REQUIRE(!ec);
+      for (size_t idx {0}; idx < nMessages; ++idx)
+      {
+         client.Send(std::string(64 * 1024, 'a'), [&sendErrors](auto ec) {
+            sendErrors.push_back(ec);
+         });
+      }
+      client.Close([&](auto ec) {
+         closed = !ec;
+         BOOST_CHECK_EQUAL(sendErrors.size(), nMessages);
+      });
+   }};
+
+   client.Connect(onConnect);
+   ioc.run();
+
+   BOOST_CHECK(closed);
+   BOOST_REQUIRE_EQUAL(sendErrors.size(), nMessages);
+   BOOST_CHECK(!sendErrors.front());
+   for (size_t idx {1}; idx < nMessages; ++idx)
+   {
+      BOOST_CHECK(sendErrors[idx] == boost::asio::error::operation_aborted);
+   }
+   BOOST_CHECK_EQUAL(client.GetQueuedBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_local_compression)
+{
+   TestServerOptions serverOptions {};
+   serverOptions.certFile = TESTS_SERVER_CERT_PEM;
+   serverOptions.keyFile = TESTS_SERVER_KEY_PEM;
+   serverOptions.compression.enabled = true;
+   TestServer server {serverOptions};
+   const auto port {server.Start()};
+   BOOST_REQUIRE(port != 0);
+
+   /* A long repetitive message, like a batch of JSON events */
+   std::string message {};
+   while (message.size() < 64 * 1024)
+   {
+      message += R"({"passenger_event":"in","station_id":"station_0"})";
+   }
+
+   /* Echo the message with and without compression, and return the bytes
+      received on the wire */
+   auto echoOnce{[&](bool compress, std::string& echo) {
+      boost::asio::io_context ioc {};
+      boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+      ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+      StreamOptions streamOptions {};
+      streamOptions.compression.enabled = compress;
+      WebSocketClient client {"localhost", "/echo", std::to_string(port), ioc, ctx,
+                              {}, streamOptions};
+      client.Connect(
+         [&client, &message](auto ec) {
+            if (!ec)
+            {
+               client.Send(message);
+            }
+         },
+         [&client, &echo](auto, auto received) {
+            echo = std::move(received);
+            client.Close();
+         }
+      );
+      ioc.run();
+      return client.GetMetrics().bytesReceived;
+   }};
+
+   std::string plainEcho {};
+   std::string compressedEcho {};
+   const auto plainBytes {echoOnce(false, plainEcho)};
+   const auto compressedBytes {echoOnce(true, compressedEcho)};
+
+   BOOST_CHECK(plainEcho == message);
+   BOOST_CHECK(compressedEcho == message);
+   BOOST_CHECK(plainBytes > message.size());
+   BOOST_CHECK(compressedBytes < message.size() / 10);
+}
+
+BOOST_AUTO_TEST_CASE(test_read_message_max)
+{
+   TestServerOptions serverOptions {};
+   serverOptions.certFile = TESTS_SERVER_CERT_PEM;
+   serverOptions.keyFile = TESTS_SERVER_KEY_PEM;
+   TestServer server {serverOptions};
+   const auto port {server.Start()};
+   BOOST_REQUIRE(port != 0);
+
+   boost::asio::io_context ioc {};
+   boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+   ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+   StreamOptions streamOptions {};
+   streamOptions.readMessageMax = 16;
+   WebSocketClient client {"localhost", "/echo", std::to_string(port), ioc, ctx,
+                           {}, streamOptions};
+
+   /* The echo is larger than the limit: the client never receives it and
+      the connection fails */
+   bool received {false};
+   bool disconnected {false};
+   client.Connect(
+      [&client](auto ec) {
+         if (!ec)
+         {
+            client.Send(std::string(64, 'x'));
+         }
+      },
+      [&received](auto, auto) {
+         received = true;
+      },
+      [&disconnected](auto) {
+         disconnected = true;
+      }
+   );
+   ioc.run();
+
+   BOOST_CHECK(!received);
+   BOOST_CHECK(disconnected);
+}
+
+BOOST_AUTO_TEST_CASE(test_reconnect)
+{
+   TestServerOptions serverOptions {};
+   serverOptions.certFile = TESTS_SERVER_CERT_PEM;
+   serverOptions.keyFile = TESTS_SERVER_KEY_PEM;
+   TestServer server {serverOptions};
+   const auto port {server.Start()};
+   BOOST_REQUIRE(port != 0);
+
+   boost::asio::io_context ioc {};
+   boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+   ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+   WebSocketClient client {"localhost", "/echo", std::to_string(port), ioc, ctx};
+   ReconnectOptions reconnectOptions {};
+   reconnectOptions.enabled = true;
+   reconnectOptions.initialDelay = std::chrono::milliseconds(10);
+   client.SetReconnectOptions(reconnectOptions);
+
+   /* The server drops the connection after the first echo. The client comes
+      back on its own and resumes the TLS session */
+   int nConnected {0};
+   int nDisconnected {0};
+   std::vector<std::string> echoes {};
+   auto onConnect{[&client, &nConnected](auto ec) {
+      if (ec)
+      {
+         return;
+      }
+      ++nConnected;
+      client.Send(nConnected == 1 ? "before" : "after");
+   }};
+   auto onReceive{[&client, &server, &echoes](auto, auto received) {
+      echoes.push_back(std::move(received));
+      if (echoes.size() == 1)
+      {
+         server.DropConnections();
+      }
+      else
+      {
+         client.Close();
+      }
+   }};
+   auto onDisconnect{[&nDisconnected](auto) {
+      ++nDisconnected;
+   }};
+
+   client.Connect(onConnect, onReceive, onDisconnect);
+   ioc.run();
+
+   BOOST_CHECK_EQUAL(nConnected, 2);
+   BOOST_CHECK(nDisconnected >= 1);
+   BOOST_CHECK((echoes == std::vector<std::string> {"before", "after"}));
+
+   const auto metrics {client.GetMetrics()};
+   BOOST_CHECK_EQUAL(metrics.connects, 2);
+   BOOST_CHECK_EQUAL(metrics.reconnects, 1);
+   BOOST_CHECK_EQUAL(metrics.resumedTlsSessions, 1);
+   BOOST_CHECK(metrics.lastHandshakeTime.count() > 0);
+   BOOST_CHECK(metrics.totalHandshakeTime >= metrics.lastHandshakeTime);
+}
+
+BOOST_AUTO_TEST_CASE(test_reconnect_gives_up)
+{
+   TestServerOptions serverOptions {};
+   serverOptions.certFile = TESTS_SERVER_CERT_PEM;
+   serverOptions.keyFile = TESTS_SERVER_KEY_PEM;
+   TestServer server {serverOptions};
+   const auto port {server.Start()};
+   BOOST_REQUIRE(port != 0);
+
+   boost::asio::io_context ioc {};
+   boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+   ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+   WebSocketClient client {"localhost", "/echo", std::to_string(port), ioc, ctx};
+   ReconnectOptions reconnectOptions {};
+   reconnectOptions.enabled = true;
+   reconnectOptions.initialDelay = std::chrono::milliseconds(1);
+   reconnectOptions.maxAttempts = 3;
+   client.SetReconnectOptions(reconnectOptions);
+
+   /* Once connected, the server goes away for good */
+   bool connected {false};
+   boost::system::error_code lastError {};
+   boost::system::error_code sendError {};
+   auto onConnect{[&server, &connected, &lastError](auto ec) {
+      if (!ec)
+      {
+         connected = true;
+         server.Stop();
+         return;
+      }
+      lastError = ec;
+   }};
+   auto onDisconnect{[&client, &sendError](auto) {
+      /* Messages sent while reconnecting fail right away */
+      client.Send("lost", [&sendError](auto ec) {
+         sendError = ec;
+      });
+   }};
+
+   client.Connect(onConnect, nullptr, onDisconnect);
+   ioc.run();
+
+   BOOST_CHECK(connected);
+   BOOST_CHECK(lastError);
+   BOOST_CHECK_EQUAL(sendError, boost::asio::error::not_connected);
+   const auto metrics {client.GetMetrics()};
+   BOOST_CHECK_EQUAL(metrics.connects, 1);
+   BOOST_CHECK_EQUAL(metrics.reconnects, 0);
+   BOOST_CHECK_EQUAL(metrics.failedAttempts, 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_reconnect_during_write)
+{
+   TestServerOptions serverOptions {};
+   serverOptions.certFile = TESTS_SERVER_CERT_PEM;
+   serverOptions.keyFile = TESTS_SERVER_KEY_PEM;
+   TestServer server {serverOptions};
+   const auto port {server.Start()};
+   BOOST_REQUIRE(port != 0);
+
+   boost::asio::io_context ioc {};
+   boost::asio::ssl::context ctx {boost::asio::ssl::context::tlsv12_client};
+   ctx.load_verify_file(TESTS_SERVER_CERT_PEM);
+
+   WebSocketClient client {"localhost", "/echo", std::to_string(port), ioc, ctx};
+   ReconnectOptions reconnectOptions {};
+   reconnectOptions.enabled = true;
+   reconnectOptions.initialDelay = std::chrono::milliseconds(0);
+   client.SetReconnectOptions(reconnectOptions);
+
+   /* The connection drops while a large write is still going on. The client
+      must not reconnect before that write is done: its completion would
+      fail the messages queued for the new connection */
+   const int nMessages {10};
+   int nConnected {0};
+   bool largeWriteDone {false};
+   int nSent {0};
+   int nReceived {0};
+   auto onConnect{[&client, &server, &nConnected, &largeWriteDone, &nSent](auto ec) {
+      if (ec)
+      {
+         return;
+      }
+      if (++nConnected == 1)
+      {
+         client.Send(std::string(32 * 1024 * 1024, 'a'), [&largeWriteDone](auto) {
+            largeWriteDone = true;
+         });
+         server.DropConnections();
+         return;
+      }
+      BOOST_CHECK(largeWriteDone);
+      for (int idx {0}; idx < nMessages; ++idx)
+      {
+         client.Send("after", [&nSent](auto ec) {
+            nSent += !ec;
+         });
+      }
+   }};
+   auto onReceive{[&client, &nReceived](auto, auto received) {
+      if (received == "after" && ++nReceived == nMessages)
+      {
+         client.Close();
+      }
+   }};
+
+   client.Connect(onConnect, onReceive);
+   ioc.run();
+
+   BOOST_CHECK_EQUAL(nConnected, 2);
+   BOOST_CHECK_EQUAL(nSent, nMessages);
+   BOOST_CHECK_EQUAL(nReceived, nMessages);
+   BOOST_CHECK_EQUAL(client.GetQueuedBytes(), 0);
+}
+
 bool CheckResponse (const std::string& response)
 {
    /* We do not parse the whole message
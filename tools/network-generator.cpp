@@ -0,0 +1,46 @@
+#include "NetworkGenerator.h"
+
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+/* @brief: Write a synthetic network layout JSON file
+ * @usage: network-generator <stations> <network-layout.json> [seed]
+ */
+int main(int argc, char* argv[])
+{
+    if (argc != 3 && argc != 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <stations> <network-layout.json> [seed]" << std::endl;
+        return 1;
+    }
+
+    NetworkMonitor::NetworkGeneratorOptions options {};
+    try
+    {
+        options.nStations = std::stoull(argv[1]);
+        if (argc == 4)
+        {
+            options.seed = static_cast<std::uint32_t>(std::stoul(argv[3]));
+        }
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "Invalid number" << std::endl;
+        return 1;
+    }
+
+    const auto layout {NetworkMonitor::GenerateNetworkLayout(options)};
+    if (!NetworkMonitor::WriteNetworkLayout(layout, std::filesystem::path {argv[2]}))
+    {
+        std::cerr << "Could not write " << argv[2] << std::endl;
+        return 1;
+    }
+    std::cout << layout.stations.size() << " stations, "
+              << layout.lines.size() << " lines, "
+              << 2 * layout.lines.size() << " routes" << std::endl;
+
+    return 0;
+}
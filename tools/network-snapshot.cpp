@@ -0,0 +1,28 @@
+#include "NetworkSnapshot.h"
+
+#include <filesystem>
+#include <iostream>
+
+/* @brief: Convert a network layout JSON file into a binary snapshot
+ * @usage: network-snapshot <network-layout.json> <snapshot>
+ */
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <network-layout.json> <snapshot>" << std::endl;
+        return 1;
+    }
+
+    bool ok {NetworkMonitor::NetworkSnapshot::ConvertLayout(
+        std::filesystem::path {argv[1]},
+        std::filesystem::path {argv[2]}
+    )};
+    if (!ok)
+    {
+        std::cerr << "Could not convert " << argv[1] << std::endl;
+        return 1;
+    }
+
+    return 0;
+}